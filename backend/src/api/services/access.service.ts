@@ -1,9 +1,10 @@
 import argon2 from 'argon2';
 import { MqttClient } from 'mqtt';
 import prisma from '@prisma-instance';
-import { PendingSession } from '@api-types/mqtt.types';
+import { PendingSession, RFID_SCAN_AGE_UNKNOWN } from '@api-types/mqtt.types';
 import { AccessStatus, IAccessLogData } from '@api-types/access.types';
 import config from '@config';
+import { publishAllowlist } from '@services/allowlist.service';
 
 /**
  * Access control service - handles the RFID door access flow
@@ -24,6 +25,38 @@ const pendingSessions = new Map<string, PendingSession>();
 
 const SESSION_TIMEOUT_MS = STATE_TIMES.AwaitingPassword;
 
+// Highest scan sequence number seen per RFID device, to drop replays of queued scans
+const lastScanSequences = new Map<string, number>();
+
+/**
+ * Check a scan's sequence number against the last one seen from the device
+ * RFID clients number their scans in increasing order and may publish a queued scan again
+ * after a restart; anything not above the last number seen is such a replay.
+ * Scans without a sequence number are never replays.
+ */
+export function isReplayedScan(rfidDeviceId: string, seq?: number): boolean {
+  if (seq === undefined) {
+    return false;
+  }
+  const last = lastScanSequences.get(rfidDeviceId);
+  if (last !== undefined && seq <= last) {
+    return true;
+  }
+  lastScanSequences.set(rfidDeviceId, seq);
+  return false;
+}
+
+/**
+ * Details for the access log of a scan older than RFID_SCAN_MAX_AGE_MS
+ */
+function lateScanDetails(ageMs: number, details?: string): string {
+  const late =
+    ageMs >= RFID_SCAN_AGE_UNKNOWN
+      ? 'Scan from before a reader restart, no keypad session started'
+      : `Scan delivered ${ageMs} ms late, no keypad session started`;
+  return details ? `${details} - ${late}` : late;
+}
+
 /**
  * Process RFID card scan
  * Flow:
@@ -32,12 +65,15 @@ const SESSION_TIMEOUT_MS = STATE_TIMES.AwaitingPassword;
  * 3. If found - validate keycard
  * 4. If invalid - publish IncorrectKeycard
  * 5. If valid - publish AwaitingPassword and start 30s timer
+ * Scans older than RFID_SCAN_MAX_AGE_MS (queued while the reader was offline) are only logged.
  */
 export async function processRfidScan(
   rfidUid: string,
   rfidDeviceId: string,
   client: MqttClient,
+  ageMs = 0,
 ): Promise<void> {
+  const late = ageMs > config.RFID_SCAN_MAX_AGE_MS;
 
   try {
     // Step 1: Look up deviceId in door table
@@ -70,18 +106,22 @@ export async function processRfidScan(
 
     if (!userKeycard) {
       console.warn(`Invalid keycard: ${rfidUid}`);
-      publishMessage(
-        client,
-        door.keypadDeviceId,
-        'IncorrectKeycard',
-        STATE_TIMES.IncorrectKeycard,
-      );
+      if (!late) {
+        publishMessage(
+          client,
+          door.keypadDeviceId,
+          'IncorrectKeycard',
+          STATE_TIMES.IncorrectKeycard,
+        );
+      }
       // Log invalid keycard attempt
       await logAccessAttempt({
         doorId: door.id,
         keycardCode: rfidUid,
         accessStatus: AccessStatus.INCORRECT_KEYCARD,
-        details: 'Keycard not found or not active',
+        details: late
+          ? lateScanDetails(ageMs, 'Keycard not found or not active')
+          : 'Keycard not found or not active',
       });
       return;
     }
@@ -94,8 +134,15 @@ export async function processRfidScan(
       userKeycardId: userKeycard.id,
       keycardCode: rfidUid,
       accessStatus: AccessStatus.CORRECT_KEYCARD,
+      details: late ? lateScanDetails(ageMs) : undefined,
     });
 
+    // The cardholder is long gone from the door
+    if (late) {
+      console.info(`Late RFID scan (${ageMs} ms) logged without a session`);
+      return;
+    }
+
     // Step 3: Clear any existing session for this door
     if (pendingSessions.has(door.id)) {
       const existingSession = pendingSessions.get(door.id)!;
@@ -129,6 +176,68 @@ export async function processRfidScan(
   }
 }
 
+/**
+ * Process a card the RFID client rejected itself because the door's keycard filter does not contain it
+ * Flow:
+ * 1. Look up deviceId in door table, with only the grants matching this card
+ * 2. If not found - stop
+ * 3. If the card is valid after all the client's filter is stale - republish it and run the normal scan flow
+ * 4. Otherwise - publish IncorrectKeycard and log the attempt
+ * Scans older than RFID_SCAN_MAX_AGE_MS are only logged, as in processRfidScan.
+ */
+export async function processRejectedScan(
+  rfidUid: string,
+  rfidDeviceId: string,
+  client: MqttClient,
+  ageMs = 0,
+): Promise<void> {
+  const late = ageMs > config.RFID_SCAN_MAX_AGE_MS;
+
+  try {
+    const door = await prisma.door.findUnique({
+      where: { rfidDeviceId },
+      include: {
+        accessGrants: {
+          where: { userKeycard: { keycard: { code: rfidUid, active: true } } },
+          take: 1,
+        },
+      },
+    });
+
+    if (!door) {
+      console.warn(`Door not found for RFID device: ${rfidDeviceId}`);
+      return;
+    }
+
+    if (door.accessGrants.length > 0) {
+      console.warn(`Keycard ${rfidUid} rejected by a stale allowlist on ${rfidDeviceId}`);
+      await publishAllowlist(client, rfidDeviceId);
+      await processRfidScan(rfidUid, rfidDeviceId, client, ageMs);
+      return;
+    }
+
+    console.warn(`Invalid keycard (rejected locally): ${rfidUid}`);
+    if (!late) {
+      publishMessage(
+        client,
+        door.keypadDeviceId,
+        'IncorrectKeycard',
+        STATE_TIMES.IncorrectKeycard,
+      );
+    }
+    await logAccessAttempt({
+      doorId: door.id,
+      keycardCode: rfidUid,
+      accessStatus: AccessStatus.INCORRECT_KEYCARD,
+      details: late
+        ? lateScanDetails(ageMs, 'Keycard rejected by the reader allowlist')
+        : 'Keycard rejected by the reader allowlist',
+    });
+  } catch (error) {
+    console.error('Error processing rejected RFID scan:', error);
+  }
+}
+
 /**
  * Process password input from keypad
  * Flow:
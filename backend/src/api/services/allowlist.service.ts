@@ -0,0 +1,98 @@
+import { MqttClient } from 'mqtt';
+import prisma from '@prisma-instance';
+import config from '@config';
+import { buildBloomFilter } from '@utils/bloom';
+
+/**
+ * Keycard allowlist service - publishes a Bloom filter of the active keycards of each door
+ * on a retained topic, so the door's RFID client can reject unknown cards without a round trip
+ */
+
+// Last filter published per RFID device, so unchanged filters are not republished
+const publishedFilters = new Map<string, Buffer>();
+
+/**
+ * Retained topic carrying the filter of one RFID device
+ */
+export function allowlistTopic(rfidDeviceId: string): string {
+  return `${config.MQTT_RFID_ALLOWLIST_TOPIC}/${rfidDeviceId}`;
+}
+
+/**
+ * Build and publish the filters of all doors
+ * @param force - Publish every filter, also those unchanged since the last call (e.g. after a reconnect)
+ */
+export async function publishAllowlists(client: MqttClient, force = false): Promise<void> {
+  try {
+    const doors = await prisma.door.findMany({
+      include: activeKeycardsOfDoor(),
+    });
+
+    for (const door of doors) {
+      const codes = door.accessGrants.map((grant) => grant.userKeycard.keycard.code);
+      publishFilter(client, door.rfidDeviceId, buildBloomFilter(codes, config.RFID_ALLOWLIST_BITS), force);
+    }
+  } catch (error) {
+    console.error('Error publishing keycard allowlists:', error);
+  }
+}
+
+/**
+ * Build and publish the filter of one door, e.g. when it turned out to be stale
+ */
+export async function publishAllowlist(client: MqttClient, rfidDeviceId: string): Promise<void> {
+  try {
+    const door = await prisma.door.findUnique({
+      where: { rfidDeviceId },
+      include: activeKeycardsOfDoor(),
+    });
+
+    if (!door) {
+      return;
+    }
+
+    const codes = door.accessGrants.map((grant) => grant.userKeycard.keycard.code);
+    publishFilter(client, door.rfidDeviceId, buildBloomFilter(codes, config.RFID_ALLOWLIST_BITS), true);
+  } catch (error) {
+    console.error('Error publishing keycard allowlist:', error);
+  }
+}
+
+/**
+ * Prisma include selecting the access grants of a door whose keycard is active
+ */
+function activeKeycardsOfDoor() {
+  return {
+    accessGrants: {
+      where: { userKeycard: { keycard: { active: true } } },
+      include: {
+        userKeycard: {
+          include: {
+            keycard: true,
+          },
+        },
+      },
+    },
+  } as const;
+}
+
+/**
+ * Publish a filter retained, unless the same filter was already published for the device
+ */
+function publishFilter(client: MqttClient, rfidDeviceId: string, filter: Buffer, force: boolean): void {
+  const previous = publishedFilters.get(rfidDeviceId);
+  if (!force && previous && previous.equals(filter)) {
+    return;
+  }
+  publishedFilters.set(rfidDeviceId, filter);
+
+  const topic = allowlistTopic(rfidDeviceId);
+  client.publish(topic, filter, { qos: 1, retain: true }, (err) => {
+    if (err) {
+      console.error(`Failed to publish keycard allowlist to ${topic}:`, err);
+      publishedFilters.delete(rfidDeviceId);
+    } else {
+      console.info(`📡 Published keycard allowlist to ${topic}`);
+    }
+  });
+}
@@ -37,6 +37,11 @@ const config: Config = {
   MQTT_Incorrect_Keycard_STATE_TIME : Number(process.env.MQTT_Incorrect_Keycard_STATE_TIME) || 3000,
   MQTT_Incorrect_Password_STATE_TIME : Number(process.env.MQTT_Incorrect_Password_STATE_TIME) || 3000,
   MQTT_DOOR_OPEN_STATE_TIME : Number(process.env.MQTT_DOOR_OPEN_STATE_TIME) || 10000,
+  MQTT_RFID_ALLOWLIST_TOPIC: process.env.MQTT_RFID_ALLOWLIST_TOPIC || 'rfid/allowlist',
+  MQTT_RFID_REJECTED_TOPIC: process.env.MQTT_RFID_REJECTED_TOPIC || 'rfid/rejected',
+  RFID_ALLOWLIST_BITS: Number(process.env.RFID_ALLOWLIST_BITS) || 512,
+  RFID_ALLOWLIST_REFRESH_MS: Number(process.env.RFID_ALLOWLIST_REFRESH_MS) || 60000,
+  RFID_SCAN_MAX_AGE_MS: Number(process.env.RFID_SCAN_MAX_AGE_MS) || 10000,
 };
 
 export default config;
@@ -7,7 +7,7 @@ import passport from 'passport';
 
 import app from '@app';
 import config from '@config';
-import { DeviceStatus, DeviceStatusMessage, RfidKeyMessage, PasswordMessage } from '@api-types/mqtt.types';
+import { DeviceStatus, DeviceStatusMessage, RfidKeyMessage, RfidRejectedMessage, PasswordMessage } from '@api-types/mqtt.types';
 // import alertRoutes from '@routes/alert.routes';
 // import authRoutes from '@routes/auth.routes';
 // import deviceRoutes from '@routes/device.routes';
@@ -16,7 +16,14 @@ import { DeviceStatus, DeviceStatusMessage, RfidKeyMessage, PasswordMessage } fr
 // import profileRoutes from '@routes/profile.routes';
 // import timeSeriesRoutes from '@routes/timeSeries.routes';
 // import tsAlertsRoutes from '@routes/tsAlerts.routes';
-import { processRfidScan, processPasswordInput, cleanupAllSessions } from '@services/access.service';
+import {
+  processRfidScan,
+  processRejectedScan,
+  processPasswordInput,
+  cleanupAllSessions,
+  isReplayedScan,
+} from '@services/access.service';
+import { publishAllowlists } from '@services/allowlist.service';
 
 import './passport';
 
@@ -93,6 +100,18 @@ app.listen(config.PORT, () => {
       }
     });
 
+    // Subscribe to the topic RFID clients report locally rejected cards on
+    client.subscribe(config.MQTT_RFID_REJECTED_TOPIC, (err) => {
+      if (err) {
+        console.error('MQTT RFID Rejected Subscription Error:', err);
+      } else {
+        console.info('Subscribed to RFID rejected topic:', config.MQTT_RFID_REJECTED_TOPIC);
+      }
+    });
+
+    // Publish every door's keycard filter, the broker may have lost the retained copies
+    publishAllowlists(client, true);
+
     // Subscribe to keypad password topic
     client.subscribe(config.MQTT_KEYPAD_PASSWORD_TOPIC, (err) => {
       if (err) {
@@ -113,14 +132,38 @@ app.listen(config.PORT, () => {
       try {
         const rfidMessage: RfidKeyMessage = JSON.parse(payload);
         console.info('Parsed RFID payload:', rfidMessage);
+
+        // Drop scans the client published again (e.g. from its offline queue after a restart)
+        if (isReplayedScan(rfidMessage.deviceId, rfidMessage.seq)) {
+          console.info(`Dropped replayed RFID scan ${rfidMessage.seq} from ${rfidMessage.deviceId}`);
+          return;
+        }
         
         // Process the RFID scan through the access control flow
-        processRfidScan(rfidMessage.rfidUid, rfidMessage.deviceId, client).catch((err) => {
+        processRfidScan(rfidMessage.rfidUid, rfidMessage.deviceId, client, rfidMessage.ageMs).catch((err) => {
           console.error('Error in processRfidScan:', err);
         });
       } catch (err) {
         console.warn('Failed to parse RFID payload as JSON:', err);
       }
+    } else if (topic === config.MQTT_RFID_REJECTED_TOPIC) {
+      const payload = message.toString();
+
+      try {
+        const rejectedMessage: RfidRejectedMessage = JSON.parse(payload);
+        console.info('Parsed RFID rejected payload:', rejectedMessage);
+
+        if (isReplayedScan(rejectedMessage.deviceId, rejectedMessage.seq)) {
+          console.info(`Dropped replayed RFID scan ${rejectedMessage.seq} from ${rejectedMessage.deviceId}`);
+          return;
+        }
+
+        processRejectedScan(rejectedMessage.rfidUid, rejectedMessage.deviceId, client, rejectedMessage.ageMs).catch((err) => {
+          console.error('Error in processRejectedScan:', err);
+        });
+      } catch (err) {
+        console.warn('Failed to parse RFID rejected payload as JSON:', err);
+      }
     } else if (topic === config.MQTT_KEYPAD_PASSWORD_TOPIC) {
       const payload = message.toString();
 
@@ -139,6 +182,13 @@ app.listen(config.PORT, () => {
     }
   });
 
+  // Rebuild the keycard filters regularly; only changed ones are republished
+  const allowlistTimer = setInterval(() => {
+    if (client.connected) {
+      publishAllowlists(client);
+    }
+  }, config.RFID_ALLOWLIST_REFRESH_MS);
+
   client.on('error', (err) => {
     console.error('MQTT Client Error:', err);
   });
@@ -147,6 +197,7 @@ app.listen(config.PORT, () => {
   process.on('SIGINT', () => {
     console.info('Shutting down gracefully...');
     cleanupAllSessions();
+    clearInterval(allowlistTimer);
     client.end();
     process.exit(0);
   });
@@ -154,6 +205,7 @@ app.listen(config.PORT, () => {
   process.on('SIGTERM', () => {
     console.info('Shutting down gracefully...');
     cleanupAllSessions();
+    clearInterval(allowlistTimer);
     client.end();
     process.exit(0);
   });
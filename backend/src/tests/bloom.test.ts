@@ -0,0 +1,50 @@
+import { describe, expect, it } from 'vitest';
+
+import {
+  BLOOM_FORMAT,
+  BLOOM_HEADER_BYTES,
+  bloomHashCount,
+  bloomMightContain,
+  bloomPositions,
+  buildBloomFilter,
+  fnv1a,
+} from '../utils/bloom';
+
+describe('Keycard Bloom filter', () => {
+  it('hashes like FNV-1a', () => {
+    expect(fnv1a('')).toBe(0x811c9dc5);
+    expect(fnv1a('a')).toBe(0xe40c292c);
+  });
+
+  // The RFID client test (test_allowlist_positions) checks the same positions
+  it('places a code where the RFID client looks for it', () => {
+    expect(fnv1a('E3:89:6E:AF')).toBe(0xa3eb4e72);
+    expect(bloomPositions('E3:89:6E:AF', 512, 4)).toEqual([114, 93, 72, 51]);
+  });
+
+  it('writes the header and the bit array', () => {
+    const filter = buildBloomFilter(['E3:89:6E:AF', 'FE:79:D8:03'], 512);
+    expect(filter.length).toBe(BLOOM_HEADER_BYTES + 64);
+    expect(filter[0]).toBe(BLOOM_FORMAT);
+    expect(filter[1]).toBe(bloomHashCount(512, 2));
+    expect(bloomMightContain(filter, 'E3:89:6E:AF')).toBe(true);
+    expect(bloomMightContain(filter, 'FE:79:D8:03')).toBe(true);
+  });
+
+  it('rejects every code when the door has no keycards', () => {
+    const filter = buildBloomFilter([], 512);
+    expect(filter.subarray(BLOOM_HEADER_BYTES).every((byte) => byte === 0)).toBe(true);
+    expect(bloomMightContain(filter, 'E3:89:6E:AF')).toBe(false);
+  });
+
+  it('keeps false positives near the expected rate', () => {
+    const codes = Array.from({ length: 50 }, (_, i) => `04:${i.toString(16).padStart(2, '0').toUpperCase()}:10:20`);
+    const filter = buildBloomFilter(codes, 512);
+    let positives = 0;
+    for (let i = 0; i < 10000; i++) {
+      if (bloomMightContain(filter, `08:${(i >> 8).toString(16)}:${(i & 0xff).toString(16)}:AA`)) positives++;
+    }
+    // k = 7 for 50 codes in 512 bits: about 0.8 %
+    expect(positives / 10000).toBeLessThan(0.03);
+  });
+});
@@ -36,6 +36,11 @@ export function isPort(value: unknown): value is Port {
  * @property {string} REFRESH_TOKEN_EXPIRATION - The expiration time for refresh tokens.
  * @property {number} MAX_FAILED_LOGIN_ATTEMPTS - The maximum number of failed login attempts allowed.
  * @property {number} ATTEMPT_WINDOW_MINUTES - The time window (in minutes) for counting failed login attempts.
+ * @property {string} MQTT_RFID_ALLOWLIST_TOPIC - Prefix of the retained per-door keycard filter topics (`<prefix>/<rfidDeviceId>`).
+ * @property {string} MQTT_RFID_REJECTED_TOPIC - The topic RFID clients report locally rejected cards on.
+ * @property {number} RFID_ALLOWLIST_BITS - Size of the keycard filter in bits, a multiple of 8 the RFID clients can hold.
+ * @property {number} RFID_ALLOWLIST_REFRESH_MS - How often the keycard filters are rebuilt and republished when changed.
+ * @property {number} RFID_SCAN_MAX_AGE_MS - Older scans (queued while a reader was offline) are logged but start no keypad session.
  */
 export interface Config {
   NODE_ENV: NODE_ENV;
@@ -61,4 +66,9 @@ export interface Config {
   MQTT_Incorrect_Keycard_STATE_TIME : number;
   MQTT_Incorrect_Password_STATE_TIME : number;
   MQTT_DOOR_OPEN_STATE_TIME : number;
+  MQTT_RFID_ALLOWLIST_TOPIC: string;
+  MQTT_RFID_REJECTED_TOPIC: string;
+  RFID_ALLOWLIST_BITS: number;
+  RFID_ALLOWLIST_REFRESH_MS: number;
+  RFID_SCAN_MAX_AGE_MS: number;
 }
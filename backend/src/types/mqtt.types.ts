@@ -10,9 +10,18 @@ export interface DeviceStatusMessage {
 
 export interface RfidKeyMessage {
   deviceId: string;
+  reader?: number; // index of the reader on a multi-reader controller
   rfidUid: string
+  seq?: number; // per-controller scan sequence number, increasing across restarts
+  ageMs?: number; // how long ago the scan happened; scans queued while offline arrive late
 }
 
+// ageMs of a scan the client restored from EEPROM after a restart: its age is unknown, so it is always late
+export const RFID_SCAN_AGE_UNKNOWN = 0xffffffff;
+
+// Card the RFID client rejected itself because the door's keycard filter does not contain it
+export type RfidRejectedMessage = RfidKeyMessage;
+
 // Pending session stored per deviceId (one active attempt per keypad/door)
 export interface PendingSession {
   deviceId: string;
@@ -0,0 +1,91 @@
+/**
+ * Bloom filter of keycard codes in the binary format the RFID clients read
+ * (clients/rfid_client/src/allowlist.cpp):
+ *
+ *   byte 0     format version (BLOOM_FORMAT)
+ *   byte 1     number of hash functions k
+ *   byte 2...  bit array, bit n is (byte 2 + n / 8) & (1 << (n % 8))
+ *
+ * Bit positions use double hashing on FNV-1a of the code text: h1 is the low 16 bits,
+ * h2 the high 16 bits with the lowest bit set, position i is (h1 + i * h2) mod m.
+ */
+
+export const BLOOM_FORMAT = 1;
+export const BLOOM_HEADER_BYTES = 2;
+export const BLOOM_MAX_HASHES = 8;
+
+/**
+ * 32-bit FNV-1a over the UTF-8 bytes of a string
+ * @param {string} text - The text to hash, e.g. "E3:89:6E:AF".
+ * @returns {number} The unsigned 32-bit hash.
+ */
+export function fnv1a(text: string): number {
+  let hash = 0x811c9dc5;
+  for (const byte of Buffer.from(text, 'utf-8')) {
+    hash ^= byte;
+    hash = Math.imul(hash, 0x01000193) >>> 0;
+  }
+  return hash >>> 0;
+}
+
+/**
+ * Bit positions of a code in a filter of `bits` bits with `hashes` hash functions
+ * @param {string} code - The keycard code.
+ * @param {number} bits - The filter size in bits.
+ * @param {number} hashes - The number of hash functions.
+ * @returns {number[]} The bit positions, one per hash function.
+ */
+export function bloomPositions(code: string, bits: number, hashes: number): number[] {
+  const hash = fnv1a(code);
+  const h1 = hash & 0xffff;
+  const h2 = (hash >>> 16) | 1;
+  const positions: number[] = [];
+  for (let i = 0; i < hashes; i++) {
+    positions.push((h1 + i * h2) % bits);
+  }
+  return positions;
+}
+
+/**
+ * Number of hash functions with the lowest false positive rate for `count` codes in `bits` bits
+ * @param {number} bits - The filter size in bits.
+ * @param {number} count - The number of codes in the filter.
+ * @returns {number} k, between 1 and BLOOM_MAX_HASHES.
+ */
+export function bloomHashCount(bits: number, count: number): number {
+  if (count === 0) return 1;
+  const k = Math.round((bits / count) * Math.LN2);
+  return Math.min(BLOOM_MAX_HASHES, Math.max(1, k));
+}
+
+/**
+ * Build the filter payload for a set of codes
+ * @param {string[]} codes - The keycard codes to add.
+ * @param {number} bits - The filter size in bits, a multiple of 8.
+ * @returns {Buffer} The header followed by the bit array.
+ */
+export function buildBloomFilter(codes: string[], bits: number): Buffer {
+  const hashes = bloomHashCount(bits, codes.length);
+  const filter = Buffer.alloc(BLOOM_HEADER_BYTES + bits / 8);
+  filter[0] = BLOOM_FORMAT;
+  filter[1] = hashes;
+  for (const code of codes) {
+    for (const position of bloomPositions(code, bits, hashes)) {
+      filter[BLOOM_HEADER_BYTES + (position >> 3)] |= 1 << (position & 7);
+    }
+  }
+  return filter;
+}
+
+/**
+ * Check a code against a filter payload built by buildBloomFilter
+ * @param {Buffer} filter - The filter payload.
+ * @param {string} code - The keycard code.
+ * @returns {boolean} False if the code is definitely not in the filter.
+ */
+export function bloomMightContain(filter: Buffer, code: string): boolean {
+  const bits = (filter.length - BLOOM_HEADER_BYTES) * 8;
+  return bloomPositions(code, bits, filter[1]).every(
+    (position) => (filter[BLOOM_HEADER_BYTES + (position >> 3)] & (1 << (position & 7))) !== 0,
+  );
+}
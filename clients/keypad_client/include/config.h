@@ -32,6 +32,11 @@ extern const uint8_t COL_PINS[4];
 // Key layout
 extern const char KEYMAP[4][4];
 
+// 1: scan the keypad through the VPORT registers, with the pin-to-port mapping worked out at compile time
+// (Uno WiFi Rev2 / ATmega4809 only). 0: portable digitalWrite/digitalRead scan.
+#define KEYPAD_DIRECT_PORTS 1
+static const uint8_t KEYPAD_SETTLE_US = 5; // column recovery after the rows were driven low, before the per-row scan
+
 // ---------------- Grove LEDs ----------------
 static const uint8_t RED_LED_PIN = A0;
 static const uint8_t GREEN_LED_PIN = A1;
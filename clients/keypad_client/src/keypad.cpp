@@ -5,10 +5,14 @@
 #include "payloads.h"
 #include "keypad_led.h"
 
+#if KEYPAD_DIRECT_PORTS
+#include <util/delay.h>
+#endif
+
 // --- Keypad pin definitions ---
-// 4x4 matrix keypad: 4 rows, 4 columns
-const uint8_t ROW_PINS[4] = {2, 3, 4, 5};
-const uint8_t COL_PINS[4] = {6, 7, 8, 9};
+// 4x4 matrix keypad: 4 rows, 4 columns (constexpr: the direct port scanner is generated from them)
+constexpr uint8_t ROW_PINS[4] = {2, 3, 4, 5};
+constexpr uint8_t COL_PINS[4] = {6, 7, 8, 9};
 
 // Key layout mapping rows/columns to characters
 const char KEYMAP[4][4] = {
@@ -75,26 +79,169 @@ void keypadInit()
     pinMode(COL_PINS[c], INPUT_PULLUP);
 }
 
+#if KEYPAD_DIRECT_PORTS
+// --- Direct port scanning ---
+// Every row/column pin is resolved to its VPORT and bit at compile time, so driving a row is one
+// SBI/CBI and reading the columns is one IN per port they sit on (with D6..D9 that is four ports:
+// PF4, PA1, PE3, PB0; columns wired to a single port are read with a single IN).
+
+#ifndef ARDUINO_AVR_UNO_WIFI_REV2
+#error "KEYPAD_DIRECT_PORTS maps Uno WiFi Rev2 pins, set it to 0 for other boards"
+#endif
+
+// Port (0 = A .. 5 = F) << 3 | bit of Arduino pins 0..13 on the Uno WiFi Rev2 (variants/uno2018)
+constexpr uint8_t PIN_PORT_BITS[14] = {
+    2 << 3 | 5, 2 << 3 | 4, 0 << 3 | 0, 5 << 3 | 5, 2 << 3 | 6, 1 << 3 | 2, 5 << 3 | 4,
+    0 << 3 | 1, 4 << 3 | 3, 1 << 3 | 0, 1 << 3 | 1, 4 << 3 | 0, 4 << 3 | 1, 4 << 3 | 2};
+
+constexpr uint8_t pinPort(uint8_t pin)
+{
+  return PIN_PORT_BITS[pin] >> 3;
+}
+
+constexpr uint8_t pinMask(uint8_t pin)
+{
+  return 1 << (PIN_PORT_BITS[pin] & 7);
+}
+
+// Bits of the column pins on `port`
+constexpr uint8_t columnMask(uint8_t port, uint8_t col = 0)
+{
+  return col == 4 ? 0 : (pinPort(COL_PINS[col]) == port ? pinMask(COL_PINS[col]) : 0) | columnMask(port, col + 1);
+}
+
+// True if every pin in the list is on the port map
+constexpr bool pinsMapped(const uint8_t *pins, uint8_t count)
+{
+  return count == 0 || (pins[0] < sizeof(PIN_PORT_BITS) && pinsMapped(pins + 1, count - 1));
+}
+
+static_assert(pinsMapped(ROW_PINS, 4) && pinsMapped(COL_PINS, 4), "keypad pins must be digital pins 0..13");
+
+// Virtual port `port`, in the I/O space reached by SBI/CBI/IN; folds to one address for a constant port
+static inline __attribute__((always_inline)) VPORT_t &vport(uint8_t port)
+{
+  return port == 0 ? VPORTA : port == 1 ? VPORTB : port == 2 ? VPORTC : port == 3 ? VPORTD : port == 4 ? VPORTE : VPORTF;
+}
+
+// Drive row `Row` high (idle) or low (selected)
+template <uint8_t Row>
+static inline __attribute__((always_inline)) void writeRow(bool high)
+{
+  if (high)
+    vport(pinPort(ROW_PINS[Row])).OUT |= pinMask(ROW_PINS[Row]);
+  else
+    vport(pinPort(ROW_PINS[Row])).OUT &= ~pinMask(ROW_PINS[Row]);
+}
+
+// Drive rows 0..Count-1
+template <uint8_t Count>
+struct Rows
+{
+  static inline __attribute__((always_inline)) void write(bool high)
+  {
+    Rows<Count - 1>::write(high);
+    writeRow<Count - 1>(high);
+  }
+};
+
+template <>
+struct Rows<0>
+{
+  static inline void write(bool) {}
+};
+
+// Columns on port `Port` that read low, as bit c for column c
+template <uint8_t Port, uint8_t Col = 0>
+struct PortColumns
+{
+  static inline __attribute__((always_inline)) uint8_t gather(uint8_t low)
+  {
+    return ((pinPort(COL_PINS[Col]) == Port && (low & pinMask(COL_PINS[Col]))) ? 1 << Col : 0) |
+           PortColumns<Port, Col + 1>::gather(low);
+  }
+};
+
+template <uint8_t Port>
+struct PortColumns<Port, 4>
+{
+  static inline uint8_t gather(uint8_t) { return 0; }
+};
+
+// Read the columns on port `Port`; ports without a column are not read at all
+template <uint8_t Port>
+static inline __attribute__((always_inline)) uint8_t readPort()
+{
+  return columnMask(Port) == 0 ? 0 : PortColumns<Port>::gather(~vport(Port).IN);
+}
+
+// Columns pulled low, bit c for column c. The short delay covers the input synchronizer after a row change.
+static inline __attribute__((always_inline)) uint8_t readColumns()
+{
+  _delay_us(1);
+  return readPort<0>() | readPort<1>() | readPort<2>() | readPort<3>() | readPort<4>() | readPort<5>();
+}
+
+// Select rows Row..3 one at a time; key of the first row with a low column (lowest column first)
+template <uint8_t Row>
+struct RowScan
+{
+  static inline __attribute__((always_inline)) char find()
+  {
+    writeRow<Row>(false);
+    const uint8_t columns = readColumns();
+    writeRow<Row>(true);
+    for (uint8_t c = 0; c < 4; c++)
+      if (columns & (1 << c))
+        return KEYMAP[Row][c];
+    return RowScan<Row + 1>::find();
+  }
+};
+
+template <>
+struct RowScan<4>
+{
+  static inline char find() { return 0; }
+};
+
+// Scan keypad matrix and return pressed key (or 0 if none).
+// All rows low first: with no key down (nearly every call) that one look ends the scan.
+char scanKeypad()
+{
+  Rows<4>::write(false);
+  const uint8_t columns = readColumns();
+  Rows<4>::write(true);
+  if (columns == 0)
+    return 0;
+
+  // A key is down: let the columns it pulled low recover, then find its row
+  _delay_us(KEYPAD_SETTLE_US);
+  return RowScan<0>::find();
+}
+#else
 // Scan keypad matrix and return pressed key (or 0 if none)
 char scanKeypad()
 {
   for (uint8_t r = 0; r < 4; r++)
   {
-    // Set all rows inactive
-    for (uint8_t rr = 0; rr < 4; rr++)
-      digitalWrite(ROW_PINS[rr], HIGH);
-
-    // Activate current row
+    // Activate current row (the others are idle HIGH)
     digitalWrite(ROW_PINS[r], LOW);
     delayMicroseconds(5);
 
     // Check each column for a pressed key
-    for (uint8_t c = 0; c < 4; c++)
+    char key = 0;
+    for (uint8_t c = 0; c < 4 && key == 0; c++)
       if (digitalRead(COL_PINS[c]) == LOW)
-        return KEYMAP[r][c];
+        key = KEYMAP[r][c];
+
+    // Back to idle before the next row
+    digitalWrite(ROW_PINS[r], HIGH);
+    if (key != 0)
+      return key;
   }
   return 0;
 }
+#endif
 
 // Main keypad processing loop (debounce + logic)
 void keypadLoop()
@@ -0,0 +1,57 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+
+// Bloom filter of the active keycards of one door, pushed by the backend on the retained
+// MQTT_TOPIC_ALLOWLIST/<deviceId> topic. A card the filter does not contain is definitely not
+// allowed at the door; a card it contains may be (false positives, never false negatives),
+// so those still go to the backend.
+//
+// Payload: format version (FORMAT), hash count k, then the bit array (bit n in byte n / 8, mask 1 << n % 8).
+// Bit i of a UID is (h1 + i * h2) mod m, with h1/h2 the low/high 16 bits of FNV-1a over the UID text
+// ("E3:89:6E:AF") and the lowest bit of h2 set. backend/src/utils/bloom.ts builds the same filter.
+class Allowlist
+{
+public:
+  static const uint8_t FORMAT = 1;
+  static const uint8_t HEADER_SIZE = 2;
+  static const uint8_t MAX_HASHES = 8;
+  // EEPROM bytes taken by save(): format, k, length, checksum and the bit array
+  static const uint8_t EEPROM_SIZE = 4 + ALLOWLIST_MAX_BYTES;
+
+  // Constructor - no filter, every card might be allowed
+  Allowlist();
+
+  // Replace the filter with a payload from the backend. An empty payload (cleared retained topic)
+  // removes the filter. Returns false and keeps the current filter if the payload is malformed
+  // or larger than ALLOWLIST_MAX_BYTES.
+  bool load(const uint8_t *payload, uint16_t length);
+
+  // Remove the filter
+  void clear();
+
+  // True once a filter was loaded; without one nothing is rejected
+  bool active() const;
+
+  // False if the door's keycards definitely do not include this UID text
+  bool mightContain(const char *uid) const;
+
+  // Filter size in bits, 0 without a filter
+  uint16_t bits() const;
+
+  // Write the filter to EEPROM at address, touching only bytes that changed
+  void save(uint16_t address) const;
+
+  // Load the filter saved at address; false (and no filter) if there is no valid copy
+  bool restore(uint16_t address);
+
+private:
+  uint8_t _bits[ALLOWLIST_MAX_BYTES];
+  // Bytes of _bits in use, 0 = no filter
+  uint8_t _length;
+  // Hash functions k
+  uint8_t _hashes;
+
+  // 8-bit sum over k, length and the bit array, guards the EEPROM copy
+  uint8_t checksum() const;
+};
@@ -27,14 +27,45 @@ static const uint16_t MQTT_PORT = 1883;
 // Leave empty ("") if you don't use authentication
 static const char *MQTT_USER = "admin";
 static const char *MQTT_PASS = "Admin1234!";
+static const uint32_t MQTT_RETRY_INTERVAL_MS = 2000; // pause between WiFi/MQTT connection attempts; the readers keep scanning meanwhile
+static const uint32_t WIFI_JOIN_TIMEOUT_MS = 20000; // a WiFi join runs in the background; one not done by then is started over
+static const uint16_t MQTT_CONNECT_TIMEOUT_MS = 2000; // TCP handshake (polled, not waited for) and CONNACK wait limit per attempt
 
 // ---------------- Topics ----------------
 static const char *MQTT_TOPIC_UID = "rfid/uid";
 static const char *MQTT_TOPIC_STATUS = "device-status";
+static const char *MQTT_TOPIC_STATS = "rfid/stats"; // driver counters, only with MFRC522_FEATURE_STATS=1
+static const char *MQTT_TOPIC_ALLOWLIST = "rfid/allowlist"; // + "/<deviceId>": retained keycard filter of the reader's door
+static const char *MQTT_TOPIC_REJECTED = "rfid/rejected";   // cards the keycard filter rejected locally
 
 // ---------------- Behavior ----------------
 static const bool MQTT_RETAIN_UID = false;     // retain last UID on broker
 static const uint32_t DEDUPE_WINDOW_MS = 1500; // avoid spamming same tag if held near reader
+static const uint8_t DEDUPE_CACHE_SIZE = 8;    // recently published cards remembered per reader (each with its own window)
+static const uint32_t RFID_POLL_INTERVAL_MS = 20; // pause between detections when no card is present (shortest pause with RFID_DUTY_CYCLE)
+static const bool RFID_PRESENCE_TRACKING = true;  // publish on card arrival only, track removal with WUPA + SELECT
+static const uint8_t RFID_PRESENCE_MISSES = 2;    // missed presence checks before a card counts as removed
+static const uint8_t RFID_INVENTORY_MAX_CARDS = 4; // cards enumerated per presentation (1 = only the one that wins anticollision)
+static const uint16_t RFID_INVENTORY_BUDGET_MS = 60; // time allowed to enumerate the cards in the field
+static const bool RFID_DUTY_CYCLE = true;          // antenna off + soft power-down between detections while the field is empty (pair with RFID_PRESENCE_TRACKING: a powered-down field wakes halted cards)
+static const uint16_t RFID_MAX_DETECT_LATENCY_MS = 250; // duty cycle: longest time from a card entering the field to its detection
+static const uint16_t RFID_DUTY_HOLD_MS = 5000;    // duty cycle: keep polling every RFID_POLL_INTERVAL_MS this long after a card was seen
+static const uint16_t RFID_FIELD_SETTLE_US = 5000; // field on time before the first REQA after power-down (ISO 14443-3: 5 ms)
+static const uint32_t RFID_STATS_INTERVAL_MS = 60000; // publish and reset the driver counters this often (MFRC522_FEATURE_STATS=1)
+static const bool ALLOWLIST_ENABLED = true;        // reject cards the door's keycard filter rules out, without the backend's access check
+static const uint8_t ALLOWLIST_MAX_BYTES = 64;     // largest keycard filter kept per reader (512 bits, RFID_ALLOWLIST_BITS on the backend)
+static const bool ALLOWLIST_PERSIST = true;        // keep each reader's filter in EEPROM for start-ups without the broker
+static const uint16_t ALLOWLIST_EEPROM_ADDR = 160; // EEPROM address of reader 0's filter, the other readers' follow (after the scan queue)
+static const uint8_t SCAN_QUEUE_SIZE = 8;          // scans kept while the broker is unreachable; the oldest is dropped when full
+static const bool SCAN_QUEUE_PERSIST = true;       // copy waiting scans to EEPROM so a restart does not lose them
+static const uint16_t SCAN_QUEUE_EEPROM_ADDR = 0;  // EEPROM address of the boot number and the scan queue slots (2 + 18 bytes per scan)
+static const uint16_t SCAN_QUEUE_DRAIN_INTERVAL_MS = 250; // at most one queued scan published per interval after a reconnect
 
 // ---------------- RFID (I2C) ----------------
 static const uint8_t RFID_I2C_ADDR = 0x28; // M5Stack RFID/RFID2 default
+static const int8_t RFID_IRQ_PIN = -1;     // MFRC522 IRQ output, -1 if not wired (poll over I2C)
+static const uint32_t RFID_I2C_MAX_CLOCK = 1000000; // fastest I2C clock tried at start-up (100k -> 400k -> 1M)
+static const uint8_t RFID_I2C_VERIFY_ROUNDS = 16;   // VersionReg + FIFO readback checks per clock step
+// 1: talk to the readers through the TWI0 registers instead of the Wire library (ATmega4809 only).
+// All readers then share TWI0, see RfidReader::Bus.
+#define RFID_DIRECT_TWI 0
@@ -3,6 +3,10 @@
 #include <WiFiNINA.h>
 #include <PubSubClient.h>
 
+// MQTT callback function type
+// Called when a subscribed MQTT message is received
+typedef void (*mqtt_callback_t)(char *topic, byte *payload, unsigned int length);
+
 // Network and MQTT communication handler
 class NetMqtt
 {
@@ -13,11 +17,17 @@ public:
   // Initialize MQTT server connection
   void begin();
 
-  // Ensure WiFi connection is established
-  void ensureWiFi();
+  // Start joining WiFi if not connected and not joining yet, without waiting for the result;
+  // true once connected. A join still pending after WIFI_JOIN_TIMEOUT_MS is started over.
+  bool ensureWiFi();
+
+  // Connect to the broker if not connected: open the TCP socket without waiting for the handshake,
+  // check on it in later calls, then send CONNECT. Attempts start at most once per MQTT_RETRY_INTERVAL_MS.
+  // True if it (re)connected in this call, subscriptions then need renewing.
+  bool ensureMQTT(const String &clientId);
 
-  // Ensure MQTT connection is established
-  void ensureMQTT(const String &clientId);
+  // True while connected to the broker
+  bool connected();
 
   // Process MQTT communication (call regularly)
   void loop();
@@ -25,11 +35,34 @@ public:
   // Publish a message to a MQTT topic
   bool publish(const char *topic, const String &payload, bool retain);
 
+  // Subscribe to a MQTT topic (renew after every reconnect)
+  bool subscribe(const char *topic);
+
+  // Set the handler for messages on subscribed topics
+  void setCallback(mqtt_callback_t callback);
+
 private:
   // WiFi client connection
   WiFiClient _wifi;
   // MQTT client
   PubSubClient _mqtt;
+  // Earliest time of the next connection attempt
+  uint32_t _nextAttemptMs;
+  // millis() when the pending WiFi join was started
+  uint32_t _joinStartMs;
+  // True while a WiFi join is pending
+  bool _joining;
+  // Socket of the pending TCP connection to the broker and millis() when it was opened
+  uint8_t _socket;
+  uint32_t _openStartMs;
+  // True while the TCP handshake with the broker is pending
+  bool _opening;
+
+  // Start the TCP connection to the broker in the WiFi module; false if no socket or address
+  bool openBrokerSocket();
+
+  // True once the pending TCP connection is up; gives up on it after MQTT_CONNECT_TIMEOUT_MS
+  bool brokerSocketReady();
 
   // Publish device online status to MQTT
   void publishOnlineStatus(const String &deviceName);
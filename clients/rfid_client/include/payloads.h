@@ -1,8 +1,22 @@
 #pragma once
 #include <Arduino.h>
+#include <MFRC522_I2C.h>
+#include "uid_cache.h"
 
 // Build JSON status payload with device ID and status for MQTT publishing
 String buildStatusJson(const String &deviceId, const String &status);
 
-// Build JSON payload with device ID and RFID UID for MQTT publishing
-String buildJsonPayload(const String &deviceId, const String &uid);
+// Build JSON payload with device ID, reader index, RFID UID, scan sequence number and age for MQTT publishing
+String buildJsonPayload(const String &deviceId, const char *uid, uint8_t readerIndex, uint32_t sequence,
+                        uint32_t ageMs);
+
+// Build compact single-line JSON for a card the keycard filter rejected locally (same fields as buildJsonPayload)
+String buildRejectedJson(const String &deviceId, const char *uid, uint8_t readerIndex, uint32_t sequence,
+                         uint32_t ageMs);
+
+#if MFRC522_FEATURE_STATS
+// Build JSON payload with device ID, reader index, the driver counters of one interval and the
+// deduplication hit/miss totals for MQTT publishing
+String buildStatsJson(const String &deviceId, uint8_t readerIndex, const MFRC522_I2C::PCD_Stats &stats,
+                      const UidCache &recent);
+#endif
@@ -1,27 +1,225 @@
 #pragma once
 #include <Arduino.h>
+#include <Wire.h>
 #include <MFRC522_I2C.h>
+#include "config.h"
+#if RFID_DIRECT_TWI
+#include <MFRC522_TWI0.h>
+#endif
+
+// A card as read by RfidReader: plain data, copied by value, no heap
+struct CardRead
+{
+  // UID bytes, uidSize of them (4, 7 or 10)
+  uint8_t uid[10];
+  uint8_t uidSize;
+  // SAK returned by the card on SELECT
+  uint8_t sak;
+  // Card type derived from the SAK; RfidReader::typeName() gives its name
+  MFRC522_I2C::PICC_Type type;
+  // millis() when the card was selected
+  uint32_t timestampMs;
+};
 
 // RFID card/tag reader handler
 class RfidReader
 {
 public:
-  // Constructor - initialize with I2C address and optional reset pin
-  explicit RfidReader(uint8_t i2cAddr, int8_t resetPin = -1);
+#if RFID_DIRECT_TWI
+  // I2C bus type: TWI0 driven through its registers
+  typedef MFRC522_TWI0 Bus;
+#else
+  // I2C bus type: the Wire library
+  typedef TwoWire Bus;
+#endif
+  // MFRC522 driver on that bus
+  typedef MFRC522_I2C_T<Bus> Driver;
+
+  // Result of a non-blocking detection step
+  enum class DetectResult : uint8_t
+  {
+    Pending,
+    CardReady,
+    NoCard
+  };
+
+  // Result of a presence tracking step
+  enum class PresenceEvent : uint8_t
+  {
+    Pending, // RF exchange still running, call pollPresence() again
+    None,    // Nothing changed: still no card, or the tracked card is still there
+    Arrived, // A new card was selected and is now tracked
+    Removed  // The tracked card stopped answering and has left the field
+  };
+
+  // Constructor - initialize with I2C address, optional reset pin, optional IRQ pin and the I2C bus the reader sits on
+  explicit RfidReader(uint8_t i2cAddr, int8_t resetPin = -1, int8_t irqPin = -1, Bus *bus = defaultBus());
 
   // Initialize the RFID reader module
   void begin();
 
+  // Characters formatUid() needs for the longest UID: 10 bytes as "XX:" with the last ':' as terminator
+  static const uint8_t UID_TEXT_SIZE = 30;
+
   // Read RFID card UID and determine card type
-  bool readUid(String &outUid, String &outPiccType);
+  bool readUid(CardRead &out);
+
+  // Start a non-blocking card detection (sends REQA and returns)
+  void startDetect();
+
+  // Advance the detection by one step; fills the card record once a card is ready
+  DetectResult poll(CardRead &out);
+
+  // Start the next presence tracking step: a detection while no card is tracked,
+  // otherwise a WUPA + SELECT of the tracked UID
+  void startPresence();
+
+  // Advance the presence step; fills the card record on Arrived, and with the tracked card on Removed
+  PresenceEvent pollPresence(CardRead &out);
+
+  // True while a card is tracked (between Arrived and Removed)
+  bool tracking() const;
+
+  // Switch the antenna off and put the MFRC522 into soft power-down after every step that found the field empty.
+  // The pause between steps is minIntervalMs while cards come and go and for holdMs after the last one, then
+  // doubles per empty step up to what keeps the time from a card entering the field to its detection within
+  // maxLatencyMs: the pause, RFID_FIELD_SETTLE_US and DETECT_TIME_MS.
+  void setDutyCycle(uint16_t minIntervalMs, uint16_t maxLatencyMs, uint16_t holdMs);
+
+  // Pause before the next startDetect()/startPresence(): RFID_POLL_INTERVAL_MS, or the duty cycle interval
+  uint16_t pollIntervalMs() const;
+
+  // True while the MFRC522 is powered down between steps
+  bool sleeping() const;
+
+  // Allowance for REQA, anticollision and SELECT of a 10 byte UID once the field is up, at 400 kHz I2C or faster
+  static const uint16_t DETECT_TIME_MS = 15;
+
+  // Enumerate every card in the field within budgetMs; returns the number of UIDs stored.
+  // All cards found are left halted.
+  uint8_t inventory(MFRC522_I2C::Uid *uids, uint8_t maxUids, uint16_t budgetMs);
+
+#if MFRC522_FEATURE_READ
+  // Read MIFARE Classic blocks of the selected card (after poll() returned CardReady, before halt())
+  // into buffer, 16 bytes per block. Authenticates once per sector; timings is optional.
+  bool readBlocks(uint8_t firstBlock, uint8_t blockCount, uint8_t *buffer, uint8_t bufferSize,
+                  const MFRC522_I2C::MIFARE_Key &key, MFRC522_I2C::MIFARE_ReadTimings *timings = nullptr);
+
+  // Read the data blocks of a MIFARE Classic sector of the selected card with one authentication
+  bool readSector(uint8_t sector, uint8_t *buffer, uint8_t bufferSize,
+                  const MFRC522_I2C::MIFARE_Key &key, MFRC522_I2C::MIFARE_ReadTimings *timings = nullptr);
+
+  // Read 4-byte pages of the selected Ultralight/NTAG card into buffer; uses FAST_READ where supported
+  bool readPages(uint8_t startPage, uint8_t pageCount, uint8_t *buffer, uint8_t bufferSize);
+#endif
+
+  // Activate ISO 14443-4 on the selected card and switch to the fastest common bit rate up to maxRate.
+  // Cards without ISO 14443-4 stay at 106 kbps. Returns false if the card did not answer RATS.
+  bool negotiateBitRate(MFRC522_I2C::PCD_BitRate maxRate = MFRC522_I2C::BITRATE_848);
+
+  // Current RF bit rate in kbps (106, 212, 424 or 848)
+  uint16_t bitRateKbps();
+
+  // Duration of the last card command in microseconds
+  uint32_t lastTransceiveUs();
+
+  // Fastest I2C clock that passed link verification in begin()
+  uint32_t i2cClock() const;
+
+  // Number of clock steps that failed link verification in begin()
+  uint8_t i2cVerifyErrors() const;
+
+  // Set the I2C clock of the reader's bus; also used when the bus is recovered after an error
+  void setBusClock(uint32_t clockHz);
+
+  // I2C error counters since start-up (failed transactions, retries, bus recoveries)
+  MFRC522_I2C::PCD_BusStats busStats();
+
+#if MFRC522_FEATURE_STATS
+  // Driver operation counters (register traffic, polls, timeouts, time per call) since begin() or resetStats()
+  MFRC522_I2C::PCD_Stats stats();
+
+  // Start a new counting interval
+  void resetStats();
+#endif
+
+  // The I2C bus the reader sits on
+  Bus *bus() const;
+
+  // The bus readers use when none is given: Wire, or TWI0 with RFID_DIRECT_TWI
+  static Bus *defaultBus();
+
+  // Start every distinct bus of the readers once; call before their begin()
+  static void beginBuses(RfidReader *readers, uint8_t count);
+
+  // Fill a card record from a UID returned by the driver, e.g. by inventory(); timestamped now
+  void describeCard(const MFRC522_I2C::Uid &uid, CardRead &out);
+
+  // Write the UID as "DE:AD:BE:EF" into out (at least UID_TEXT_SIZE for any UID); returns the length.
+  // Truncated to whole bytes if out is too small, always terminated.
+  static uint8_t formatUid(const CardRead &card, char *out, uint8_t outSize);
+
+  // True if both records hold the same UID
+  static bool sameUid(const CardRead &a, const CardRead &b);
+
+  // Name of the card type, only looked up when asked for (e.g. for debug output)
+  const __FlashStringHelper *typeName(const CardRead &card);
 
   // Halt the current card and stop encryption
   void halt();
 
+  // Replace the per-command RF timeouts (REQA/WUPA, select, halt, auth, transfer)
+  void setTimingProfile(const MFRC522_I2C::PCD_TimingProfile &profile);
+
 private:
   // MFRC522 I2C RFID reader module
-  MFRC522_I2C _mfrc;
+  Driver _mfrc;
+  // I2C bus the reader sits on
+  Bus *_bus;
+  // Fastest I2C clock verified in begin()
+  uint32_t _i2cClock;
+  // Clock steps that failed verification
+  uint8_t _i2cVerifyErrors;
+  // Pin wired to the MFRC522 IRQ output (-1 to poll over I2C)
+  int8_t _irqPin;
+  // A card is in the field and its UID is in _trackedUid
+  bool _tracking;
+  // UID of the tracked card
+  MFRC522_I2C::Uid _trackedUid;
+  // Consecutive presence checks the tracked card failed to answer
+  uint8_t _presenceMisses;
+  // Duty cycling enabled by setDutyCycle()
+  bool _dutyCycle;
+  // Antenna off and MFRC522 in soft power-down
+  bool _sleeping;
+  // Woken by startDetect()/startPresence(); the detection starts once the field has settled
+  bool _startDeferred;
+  // micros() when the field was switched on
+  uint32_t _fieldOnUs;
+  // Current, shortest and longest pause between steps
+  uint16_t _intervalMs;
+  uint16_t _minIntervalMs;
+  uint16_t _maxIntervalMs;
+  // Time after the last card during which the pause stays at its minimum
+  uint16_t _holdMs;
+  // millis() of the last step that saw a card
+  uint32_t _lastActivityMs;
+
+  // Step the I2C clock up as far as the link stays reliable
+  void negotiateBusClock();
+
+  // Check register traffic at the current clock: VersionReg reads and a FIFO write/readback
+  bool verifyLink(byte expectedVersion);
+
+  // Copy a UID into a card record without type or timestamp
+  static void copyUid(const MFRC522_I2C::Uid &uid, CardRead &out);
+
+  // Power the MFRC522 up and switch the field on
+  void wake();
+
+  // Start of a step: wakes the reader if it sleeps; true if the detection has to wait for the field to settle
+  bool deferStart();
 
-  // Convert UID bytes to formatted hexadecimal string
-  String uidToString();
+  // End of a step: adapt the pause and, if duty cycling, sleep while the field is empty
+  void endStep(bool activity);
 };
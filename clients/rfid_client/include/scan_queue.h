@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "rfid_reader.h"
+
+// A scan waiting to be published
+struct ScanEvent
+{
+  // Card and millis() of the scan; timestampMs is meaningless for scans restored from before a restart (FLAG_RESTORED)
+  CardRead card;
+  // Increasing across restarts: boot number in the high 16 bits, scan count of the boot in the low 16
+  uint32_t sequence;
+  // Reader that scanned the card
+  uint8_t reader;
+  // FLAG_* bits
+  uint8_t flags;
+  // EEPROM slot holding a copy, NO_SLOT if none
+  uint8_t slot;
+};
+
+// Store-and-forward ring of scan events (SCAN_QUEUE_SIZE, no heap). Scans are published from the
+// front in order; while the broker is unreachable they wait here, and persist() copies them to
+// EEPROM so a restart does not lose them. When full, the oldest event is dropped.
+//
+// EEPROM: the boot number (2 bytes), then SCAN_QUEUE_SIZE slots. Slots are taken round-robin,
+// never by position in the ring, so the writes spread evenly over all of them; a slot is written
+// once when an event is persisted and its status byte once more when the event is sent. Scans
+// published while online never touch the EEPROM.
+class ScanQueue
+{
+public:
+  static const uint8_t FLAG_REJECTED = 0x01; // rejected by the keycard filter, goes to MQTT_TOPIC_REJECTED
+  static const uint8_t FLAG_RESTORED = 0x02; // read back from EEPROM after a restart, its age is unknown
+  // ageMs() of a restored event: longer than any RFID_SCAN_MAX_AGE_MS, so the backend always treats it as late
+  static const uint32_t AGE_UNKNOWN = 0xFFFFFFFFUL;
+  static const uint8_t NO_SLOT = 0xFF;
+  // Status, checksum, reader + flags, UID size, sequence, UID bytes
+  static const uint8_t SLOT_SIZE = 8 + sizeof(CardRead::uid);
+  static const uint16_t EEPROM_SIZE = 2 + SCAN_QUEUE_SIZE * SLOT_SIZE;
+
+  // Constructor - empty, no EEPROM
+  ScanQueue();
+
+  // Count this start-up in the boot number at address and, with persist, take back the events
+  // a previous run left unsent. address -1: no EEPROM (sequence numbers restart from 0).
+  void begin(int address, bool persist);
+
+  // Queue a scan under the next sequence number; drops the oldest event if the ring is full
+  void push(const CardRead &card, uint8_t reader, uint8_t flags);
+
+  // Oldest event, NULL if empty
+  const ScanEvent *front() const;
+
+  // Remove the oldest event once it was published
+  void pop();
+
+  // Copy the events not yet in EEPROM there (call while the broker is unreachable)
+  void persist();
+
+  // Events waiting
+  uint8_t size() const;
+
+  // Events dropped because the ring was full, since start-up
+  uint32_t dropped() const;
+
+  // Milliseconds since the event was scanned, AGE_UNKNOWN for events from before the restart
+  static uint32_t ageMs(const ScanEvent &event, uint32_t now);
+
+private:
+  ScanEvent _events[SCAN_QUEUE_SIZE];
+  // Index of the oldest event and number of events
+  uint8_t _tail;
+  uint8_t _count;
+  uint16_t _boot;
+  uint16_t _counter;
+  uint32_t _dropped;
+  // EEPROM address, -1 if none; slots are used only with _persist
+  int _address;
+  bool _persist;
+  // Slot the round-robin search for a free one starts at
+  uint8_t _nextSlot;
+
+  // EEPROM address of a slot
+  int slotAddress(uint8_t slot) const;
+  // True if no queued event is stored in the slot
+  bool slotFree(uint8_t slot) const;
+  // Write an event to a free slot
+  void store(ScanEvent &event);
+  // Mark the event's slot as sent, if it has one
+  void release(ScanEvent &event);
+  // Read the pending slots back into the ring, oldest first
+  void restore();
+  // Write the boot number
+  void saveBoot();
+  // 8-bit sum over the slot bytes after the checksum
+  static uint8_t slotChecksum(const uint8_t *slot);
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <Arduino.h>
+#include "config.h"
+#include "rfid_reader.h"
+
+// Recently published cards of one reader, for deduplication.
+// Fixed capacity (DEDUPE_CACHE_SIZE), no heap. Entries are keyed by a 32-bit hash of the UID bytes;
+// two UIDs with the same hash within one window would count as one card.
+class UidCache
+{
+public:
+  // Constructor - empty cache, counters at zero
+  UidCache();
+
+  // True if the card was published less than windowMs before card.timestampMs (a hit).
+  // Otherwise (a miss) the card is recorded as published at card.timestampMs, replacing the
+  // least recently seen entry when the cache is full.
+  bool isDuplicate(const CardRead &card, uint32_t windowMs);
+
+  // Reads suppressed as duplicates since start-up
+  uint32_t hits() const;
+
+  // Reads let through (published) since start-up
+  uint32_t misses() const;
+
+private:
+  // One recently published card
+  struct Entry
+  {
+    // Hash of the UID, 0 marks a free entry
+    uint32_t hash;
+    // When the card was last published; its window runs from here
+    uint32_t publishedMs;
+    // When the card was last read, for LRU eviction
+    uint32_t seenMs;
+  };
+
+  Entry _entries[DEDUPE_CACHE_SIZE];
+  uint32_t _hits;
+  uint32_t _misses;
+
+  // FNV-1a over the UID size and bytes, never 0
+  static uint32_t hashUid(const CardRead &card);
+};
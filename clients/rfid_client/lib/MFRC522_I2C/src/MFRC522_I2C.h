@@ -81,6 +81,41 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+// CRC_A for PICC frames is computed on the host from a lookup table, which costs no I2C traffic.
+// Define MFRC522_CRC_COPROCESSOR to use the CRC coprocessor of the MFRC522 instead (saves the 512 byte table in flash).
+//#define MFRC522_CRC_COPROCESSOR
+
+// Optional parts of the driver. All are in by default; a build that does not need one sets it to 0,
+// e.g. build_flags = -D MFRC522_FEATURE_DUMP=0. Detection, selection, halt and presence checks are always in.
+// MIFARE_Read(), MIFARE_Write(), PCD_Authenticate() and the block/sector/page readers built on them.
+#ifndef MFRC522_FEATURE_READ
+#define MFRC522_FEATURE_READ 1
+#endif
+// MIFARE_Increment(), MIFARE_Decrement(), MIFARE_Restore(), MIFARE_Transfer(), MIFARE_GetValue(), MIFARE_SetValue().
+#ifndef MFRC522_FEATURE_VALUE_BLOCKS
+#define MFRC522_FEATURE_VALUE_BLOCKS 1
+#endif
+// PCD_DumpVersionToSerial() and the PICC_Dump*ToSerial() functions.
+#ifndef MFRC522_FEATURE_DUMP
+#define MFRC522_FEATURE_DUMP 1
+#endif
+// MIFARE_OpenUidBackdoor(), MIFARE_SetUid() and MIFARE_UnbrickUidSector() for UID changeable cards.
+#ifndef MFRC522_FEATURE_UID_BACKDOOR
+#define MFRC522_FEATURE_UID_BACKDOOR 1
+#endif
+// The texts of GetStatusCodeName() and PICC_GetTypeName(). Without them both return "?".
+#ifndef MFRC522_FEATURE_NAMES
+#define MFRC522_FEATURE_NAMES 1
+#endif
+// Operation counters behind PCD_GetStats(): register traffic, poll iterations, timeouts and time spent in the
+// polling calls. Off by default; when 0 neither the counters nor the code that updates them is compiled.
+#ifndef MFRC522_FEATURE_STATS
+#define MFRC522_FEATURE_STATS 0
+#endif
+#if !MFRC522_FEATURE_READ && (MFRC522_FEATURE_VALUE_BLOCKS || MFRC522_FEATURE_DUMP || MFRC522_FEATURE_UID_BACKDOOR)
+#error "MFRC522_FEATURE_VALUE_BLOCKS, _DUMP and _UID_BACKDOOR need MFRC522_FEATURE_READ"
+#endif
+
 // Firmware data for self-test
 // Reference values based on firmware version
 // Hint: if needed, you can remove unused self-test data to save flash memory
@@ -134,7 +169,11 @@ const byte FM17522_firmware_reference[] PROGMEM = {
 	0x56, 0x9A, 0x98, 0x82, 0x26, 0xEA, 0x2A, 0x62
 };
 
-class MFRC522_I2C {
+/**
+ * Everything about the MFRC522 that does not depend on the I2C bus: the register and command codes, the types
+ * passed to and from the driver and the functions that only compute. Shared by every MFRC522_I2C_T.
+ */
+class MFRC522_I2C_Base {
 public:
 	// MFRC522 registers. Described in chapter 9 of the datasheet.
 	enum PCD_Register {
@@ -251,6 +290,10 @@ public:
 		PICC_CMD_SEL_CL2		= 0x95,		// Anti collision/Select, Cascade Level 2
 		PICC_CMD_SEL_CL3		= 0x97,		// Anti collision/Select, Cascade Level 3
 		PICC_CMD_HLTA			= 0x50,		// HaLT command, Type A. Instructs an ACTIVE PICC to go to state HALT.
+		// The commands used for ISO/IEC 14443-4 activation (from the ISO/IEC 14443-4 draft, Section 5)
+		PICC_CMD_RATS			= 0xE0,		// Request for Answer To Select. Enters the ISO/IEC 14443-4 protocol, the PICC answers with its ATS.
+		PICC_CMD_PPS			= 0xD0,		// Protocol and Parameter Selection, start byte PPSS with CID 0. Changes the bit rates.
+		PICC_CMD_S_DESELECT		= 0xC2,		// S(DESELECT) block. Ends the ISO/IEC 14443-4 protocol, the PICC goes to state HALT.
 		// The commands used for MIFARE Classic (from http://www.nxp.com/documents/data_sheet/MF1S503x.pdf, Section 9)
 		// Use PCD_MFAuthent to authenticate access to a sector, then use these commands to read/write/modify the blocks on the sector.
 		// The read/write commands can also be used for MIFARE Ultralight.
@@ -264,7 +307,9 @@ public:
 		PICC_CMD_MF_TRANSFER	= 0xB0,		// Writes the contents of the internal data register to a block.
 		// The commands used for MIFARE Ultralight (from http://www.nxp.com/documents/data_sheet/MF0ICU1.pdf, Section 8.6)
 		// The PICC_CMD_MF_READ and PICC_CMD_MF_WRITE can also be used for MIFARE Ultralight.
-		PICC_CMD_UL_WRITE		= 0xA2		// Writes one 4 byte page to the PICC.
+		PICC_CMD_UL_WRITE		= 0xA2,		// Writes one 4 byte page to the PICC.
+		// The commands used for NTAG21x (from http://www.nxp.com/documents/data_sheet/NTAG213_215_216.pdf, Section 10)
+		PICC_CMD_NTAG_FAST_READ	= 0x3A		// Reads pages StartAddr..EndAddr in one frame. MIFARE Ultralight and Ultralight C answer NAK.
 	};
 
 	// MIFARE constants that does not fit anywhere else
@@ -273,6 +318,14 @@ public:
 		MF_KEY_SIZE				= 6			// A Mifare Crypto1 key is 6 bytes.
 	};
 
+	// RF bit rates. The value is both the TxSpeed/RxSpeed code of TxModeReg/RxModeReg and the DSI/DRI code of PPS.
+	enum PCD_BitRate {
+		BITRATE_106				= 0,	// 106 kBd, used for all ISO/IEC 14443-3 frames
+		BITRATE_212				= 1,	// 212 kBd
+		BITRATE_424				= 2,	// 424 kBd
+		BITRATE_848				= 3		// 848 kBd
+	};
+
 	// PICC types we can detect. Remember to update PICC_GetTypeName() if you add more.
 	enum PICC_Type {
 		PICC_TYPE_UNKNOWN		= 0,
@@ -297,7 +350,78 @@ public:
 		STATUS_INTERNAL_ERROR	= 6,	// Internal error in the code. Should not happen ;-)
 		STATUS_INVALID			= 7,	// Invalid argument.
 		STATUS_CRC_WRONG		= 8,	// The CRC_A does not match
-		STATUS_MIFARE_NACK		= 9		// A MIFARE PICC responded with NAK.
+		STATUS_MIFARE_NACK		= 9,	// A MIFARE PICC responded with NAK.
+		STATUS_PENDING			= 10,	// The command is still running. Only returned by the non-blocking functions.
+		STATUS_BUS_ERROR		= 11	// An I2C transaction with the MFRC522 failed, see PCD_GetBusStats().
+	};
+
+	// Timer settings for one class of PICC commands. See PCD_SetTimingProfile().
+	typedef struct {
+		uint16_t	timeoutUs;		// Reply timeout, counted by the MFRC522 timer from the end of transmission. Max 65535.
+		uint16_t	firstPollUs;	// Time from starting the command until ComIrqReg is worth reading: roughly the frame + response time.
+	} PCD_Timing;
+
+	// Timer settings per class of PICC commands.
+	typedef struct {
+		PCD_Timing	request;		// REQA, WUPA
+		PCD_Timing	select;			// ANTICOLLISION, SELECT
+		PCD_Timing	halt;			// HLTA. Success is no answer, so this timeout is waited out every time.
+		PCD_Timing	auth;			// MFAuthent
+		PCD_Timing	transfer;		// READ, WRITE and the other MIFARE data commands
+	} PCD_TimingProfile;
+
+	// Timings used after construction. See the .cpp for the reasoning behind the values.
+	static const PCD_TimingProfile DefaultTimingProfile;
+
+	// Chunk callbacks for PCD_TransceiveStream().
+	// The source fills buffer with up to maxLength bytes of the frame to send and returns the count, 0 at the end of the frame.
+	typedef byte (*PCD_StreamSource)(void *context, byte *buffer, byte maxLength);
+	// The sink receives the response as it is drained from the FIFO, CRC_A included.
+	typedef void (*PCD_StreamSink)(void *context, const byte *data, byte length);
+
+	// I2C error counters, see PCD_GetBusStats().
+	typedef struct {
+		uint16_t	errors;			// Transactions that failed after all retries
+		uint16_t	retries;		// Transactions repeated after a failure
+		uint16_t	recoveries;		// Bus recoveries performed
+		byte		lastError;		// Last endTransmission() code, or I2C_ERROR_SHORT_READ
+	} PCD_BusStats;
+
+#if MFRC522_FEATURE_STATS
+	// Calls to one public function and the time spent in them, see PCD_Stats.
+	typedef struct {
+		uint16_t	calls;
+		uint32_t	totalUs;		// Sum of micros() from entry to return
+		uint32_t	maxUs;			// Longest single call
+	} PCD_CallStats;
+
+	// Operation counters since construction or PCD_ResetStats(), see PCD_GetStats().
+	typedef struct {
+		uint32_t	regReads;		// PCD_ReadRegister() calls, each a pointer write plus a read transaction
+		uint32_t	regWrites;		// PCD_WriteRegister() calls, one transaction each
+		uint32_t	bytesRead;		// Register bytes received
+		uint32_t	bytesWritten;	// Register bytes sent, register address excluded
+		uint32_t	commPolls;		// PCD_PollCommunicate() calls, from PCD_CommunicateWithPICC() and PICC_PollDetect()
+		uint32_t	crcPolls;		// Iterations of the wait loop in PCD_CalculateCRC()
+		struct {
+			uint16_t	request;	// REQA, WUPA: an empty field
+			uint16_t	select;		// ANTICOLLISION, SELECT
+			uint16_t	halt;		// HLTA. Every successful halt ends in a timeout.
+			uint16_t	auth;		// MFAuthent
+			uint16_t	transfer;	// READ, WRITE and the other data commands
+			uint16_t	crc;		// CalcCRC on the MFRC522
+		} timeouts;					// Commands that ended in STATUS_TIMEOUT, per timing class
+		PCD_CallStats	isNewCardPresent;
+		PCD_CallStats	select;		// PICC_Select(), also when called by PICC_ReadCardSerial() or the detection
+		PCD_CallStats	haltA;
+	} PCD_Stats;
+#endif // MFRC522_FEATURE_STATS
+
+	// Results of PICC_PollDetect().
+	enum DetectStatus {
+		DETECT_PENDING			= 0,	// Detection still running, call PICC_PollDetect() again.
+		DETECT_CARD_READY		= 1,	// A PICC has been selected. Its UID is in the uid member.
+		DETECT_NO_CARD			= 2		// No PICC answered, or selection failed. Call PICC_StartDetect() to try again.
 	};
 
 	// A struct used for passing the UID of a PICC.
@@ -312,17 +436,137 @@ public:
 		byte		keyByte[MF_KEY_SIZE];
 	} MIFARE_Key;
 
-	// Member variables
-	Uid uid;								// Used by PICC_ReadCardSerial().
+	// Time spent in the phases of MIFARE_ReadBlocks() / MIFARE_ReadSector(), in microseconds.
+	typedef struct {
+		uint32_t	authUs;			// PCD_Authenticate(), 0 if the cached session was reused
+		uint32_t	readUs;			// All MIFARE_Read() calls
+		uint32_t	totalUs;		// Whole call, including CRC and buffer copies
+		byte		authCount;		// Number of authentications performed
+		byte		blocksRead;		// Number of blocks copied into the buffer
+	} MIFARE_ReadTimings;
 
 	// Size of the MFRC522 FIFO
 	static const byte FIFO_SIZE = 64;		// The FIFO is 64 bytes.
+	// WaterLevelReg value used by PCD_TransceiveStream(): refill when at most this many bytes are left, drain when at most this many are free.
+	static const byte STREAM_WATER_LEVEL = 32;
+	// Number of configuration registers that can be mirrored by the shadow register cache.
+	static const byte REG_CACHE_SIZE = 15;
+	// Value for PCD_SetIrqPin() when the MFRC522 IRQ output is not wired. Command completion is then polled over I2C.
+	static const byte IRQ_PIN_NONE = 0xFF;
+	// Number of instances that can use an IRQ pin at the same time.
+	static const byte IRQ_MAX_INSTANCES = 4;
+	// Bus transactions are repeated at most this many times, see PCD_BusWrite().
+	static const byte I2C_MAX_RETRIES = 2;
+	// PCD_BusStats.lastError when requestFrom() returned fewer bytes than asked for.
+	static const byte I2C_ERROR_SHORT_READ = 6;
+	// Minimum time between two bus recoveries.
+	static const uint16_t BUS_RECOVERY_HOLDOFF_MS = 100;
+	// Longest wait for the chip to come back from a reset, see PCD_WaitReady().
+	static const uint16_t RESET_TIMEOUT_MS = 50;
+	// No pin assigned, see PCD_SetBusRecoveryPins().
+	static const byte PIN_NONE = 0xFF;
+	// No sector authenticated, see MIFARE_ReadBlocks().
+	static const byte AUTH_SECTOR_NONE = 0xFF;
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Functions for communicating with MIFARE PICCs
+	/////////////////////////////////////////////////////////////////////////////////////
+	static byte MIFARE_SectorOfBlock(byte blockAddr);
+	static byte MIFARE_SectorFirstBlock(byte sector);
+	static byte MIFARE_SectorBlockCount(byte sector);
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Support functions
+	/////////////////////////////////////////////////////////////////////////////////////
+	static void CRC_A_Compute(const byte *data, byte length, byte *result);
+	static uint16_t CRC_A_Update(uint16_t crc, const byte *data, byte length);
+	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
+	//const char *GetStatusCodeName(byte code);
+	const __FlashStringHelper *GetStatusCodeName(byte code);
+	byte PICC_GetType(byte sak);
+	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
+	//const char *PICC_GetTypeName(byte type);
+	const __FlashStringHelper *PICC_GetTypeName(byte type);
+	void MIFARE_SetAccessBits(byte *accessBitBuffer, byte g0, byte g1, byte g2, byte g3);
+
+protected:
+	// Steps of PICC_PollDetect(). The value is the command that is in flight.
+	enum DetectStep {
+		DETECT_STEP_IDLE		= 0,	// Nothing in flight
+		DETECT_STEP_REQA		= 1,	// REQA or WUPA sent, waiting for ATQA
+		DETECT_STEP_ANTICOLL	= 2,	// ANTICOLLISION sent for _detectLevel, waiting for UID CLn + BCC
+		DETECT_STEP_SELECT		= 3		// SELECT sent for _detectLevel, waiting for SAK
+	};
+
+#if MFRC522_FEATURE_READ
+	// Most pages one FAST_READ may return: the data and the CRC_A must fit in the 64 byte FIFO,
+	// and the whole FIFO is read back in one TwoWire request, so it must also fit in the TwoWire buffer.
+#if defined(BUFFER_LENGTH) && BUFFER_LENGTH < 64
+	static const byte FAST_READ_MAX_PAGES = (BUFFER_LENGTH - 2) / 4;
+#else
+	static const byte FAST_READ_MAX_PAGES = (FIFO_SIZE - 2) / 4;	// 15 pages, 60 bytes + CRC_A
+#endif
+
+	// PCD_TransceiveStream() context of a FAST_READ that does not fit in the FIFO.
+	typedef struct {
+		byte		command[3];		// FAST_READ, StartAddr, EndAddr. The CRC_A is appended by the stream.
+		bool		sent;
+		byte		*buffer;		// Receives the pages; the CRC_A is dropped
+		uint16_t	size;
+		uint16_t	received;
+	} FastReadStream;
+
+	static byte FastReadSource(void *context, byte *buffer, byte maxLength);
+	static void FastReadSink(void *context, const byte *data, byte length);
+#endif // MFRC522_FEATURE_READ
+
+#if MFRC522_FEATURE_STATS
+	// Books the time from construction to destruction, i.e. to whichever return leaves the function, in a PCD_CallStats.
+	class PCD_CallTimer {
+	public:
+		PCD_CallTimer(PCD_CallStats *stats) : _stats(stats), _startUs(micros()) {}
+		~PCD_CallTimer() {
+			uint32_t elapsed = micros() - _startUs;
+			_stats->calls++;
+			_stats->totalUs += elapsed;
+			if (elapsed > _stats->maxUs) {
+				_stats->maxUs = elapsed;
+			}
+		}
+	private:
+		PCD_CallStats *_stats;
+		uint32_t _startUs;
+	};
+#endif // MFRC522_FEATURE_STATS
+
+	// Register values written by PCD_Configure(): { register, value } pairs in flash.
+	static const byte PCD_InitTable[][2];
+	static const byte PCD_INIT_TABLE_LENGTH;
+
+	static int8_t PCD_RegisterCacheSlot(byte reg);
+	static byte PCD_StreamFill(PCD_StreamSource source, void *context, byte *buffer, byte maxLength, bool *done);
+};
+
+/**
+ * MFRC522 driver for a bus of type TwoWireT, anything with the TwoWire master functions used here:
+ * begin(), end(), setClock(), beginTransmission(), write(), endTransmission(), requestFrom(), available() and read().
+ * The calls are resolved at compile time, so a bus with inline functions (see MFRC522_TWI0.h) ends up as
+ * direct register access on the polling path, and a fake bus can stand in for the chip in host tests.
+ * ChipAddress fixes the I2C address at compile time and the constructor's chipAddress is then ignored; 0 takes it from the constructor.
+ *
+ * MFRC522_I2C is the driver on the Arduino TwoWire class.
+ */
+template <class TwoWireT, byte ChipAddress = 0>
+class MFRC522_I2C_T : public MFRC522_I2C_Base {
+public:
+	// Member variables
+	Uid uid;								// Used by PICC_ReadCardSerial().
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for setting up the Arduino
 	/////////////////////////////////////////////////////////////////////////////////////
 	// MFRC522_I2C(byte chipAddress, byte resetPowerDownPin, TwoWire & TwoWireInstance = Wire);
-    MFRC522_I2C(byte chipAddress, byte resetPowerDownPin, TwoWire *TwoWireInstance = &Wire);
+	MFRC522_I2C_T(byte chipAddress, byte resetPowerDownPin, TwoWireT *TwoWireInstance = &Wire);
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Basic interface functions for communicating with the MFRC522
@@ -331,70 +575,106 @@ public:
 	void PCD_WriteRegister(byte reg, byte count, byte *values);
 	byte PCD_ReadRegister(byte reg);
 	void PCD_ReadRegister(byte reg, byte count, byte *values, byte rxAlign = 0);
+	void PCD_SetBusClock(uint32_t clockHz);
+	void PCD_SetBusRecoveryPins(byte sdaPin, byte sclPin);
+	PCD_BusStats PCD_GetBusStats();
+#if MFRC522_FEATURE_STATS
+	PCD_Stats PCD_GetStats();
+	void PCD_ResetStats();
+#endif
+	void PCD_RecoverBus();
 	void setBitMask(unsigned char reg, unsigned char mask);
 	void PCD_SetRegisterBitMask(byte reg, byte mask);
 	void PCD_ClearRegisterBitMask(byte reg, byte mask);
+	void PCD_SetRegisterCache(bool enabled);
 	byte PCD_CalculateCRC(byte *data, byte length, byte *result);
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for manipulating the MFRC522
 	/////////////////////////////////////////////////////////////////////////////////////
 	void PCD_Init();
-	void PCD_Reset();
+	bool PCD_Reset();
 	void PCD_AntennaOn();
 	void PCD_AntennaOff();
+	void PCD_SoftPowerDown();
+	bool PCD_SoftPowerUp();
 	byte PCD_GetAntennaGain();
 	void PCD_SetAntennaGain(byte mask);
 	bool PCD_PerformSelfTest();
+	bool PCD_SetIrqPin(byte irqPin);
+	void PCD_SetTimingProfile(const PCD_TimingProfile *profile);
+	void PCD_SetTimeout(uint16_t timeoutUs, uint16_t firstPollUs = 0);
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with PICCs
 	/////////////////////////////////////////////////////////////////////////////////////
 	byte PCD_TransceiveData(byte *sendData, byte sendLen, byte *backData, byte *backLen, byte *validBits = NULL, byte rxAlign = 0, bool checkCRC = false);
 	byte PCD_CommunicateWithPICC(byte command, byte waitIRq, byte *sendData, byte sendLen, byte *backData = NULL, byte *backLen = NULL, byte *validBits = NULL, byte rxAlign = 0, bool checkCRC = false);
+	void PCD_StartCommunicate(byte command, byte waitIRq, byte *sendData, byte sendLen, byte txLastBits = 0, byte rxAlign = 0);
+	byte PCD_PollCommunicate();
+	byte PCD_FinishCommunicate(byte *backData = NULL, byte *backLen = NULL, byte *validBits = NULL, byte rxAlign = 0, bool checkCRC = false);
+	byte PCD_TransceiveStream(PCD_StreamSource source, PCD_StreamSink sink, void *context, uint16_t *receivedLen = NULL, bool useCRC = true);
 	byte PICC_RequestA(byte *bufferATQA, byte *bufferSize);
 	byte PICC_WakeupA(byte *bufferATQA, byte *bufferSize);
 	byte PICC_REQA_or_WUPA(byte command, byte *bufferATQA, byte *bufferSize);
 	byte PICC_Select(Uid *uid, byte validBits = 0);
 	byte PICC_HaltA();
 
+	/////////////////////////////////////////////////////////////////////////////////////
+	// ISO/IEC 14443-4 activation and bit rate negotiation
+	/////////////////////////////////////////////////////////////////////////////////////
+	byte PICC_RequestATS(byte *bufferATS, byte *bufferSize);
+	byte PICC_PPS(byte bitRate);
+	byte PICC_NegotiateBitRate(byte maxBitRate);
+	byte PICC_Deselect();
+	bool PICC_IsProtocolActive();
+	void PCD_SetBitRate(byte bitRate);
+	byte PCD_GetBitRate();
+	uint32_t PCD_GetLastTransceiveUs();
+
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Functions for communicating with MIFARE PICCs
 	/////////////////////////////////////////////////////////////////////////////////////
-	byte PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid);
 	void PCD_StopCrypto1();
+#if MFRC522_FEATURE_READ
+	byte PCD_Authenticate(byte command, byte blockAddr, const MIFARE_Key *key, Uid *uid);
 	byte MIFARE_Read(byte blockAddr, byte *buffer, byte *bufferSize);
+	byte MIFARE_ReadBlocks(byte firstBlock, byte blockCount, byte *buffer, byte bufferSize, const MIFARE_Key *key, byte keyType = PICC_CMD_MF_AUTH_KEY_A, MIFARE_ReadTimings *timings = NULL);
+	byte MIFARE_ReadSector(byte sector, byte *buffer, byte bufferSize, const MIFARE_Key *key, byte keyType = PICC_CMD_MF_AUTH_KEY_A, MIFARE_ReadTimings *timings = NULL);
 	byte MIFARE_Write(byte blockAddr, byte *buffer, byte bufferSize);
+	byte MIFARE_Ultralight_Write(byte page, byte *buffer, byte bufferSize);
+	byte MIFARE_Ultralight_FastRead(byte startPage, byte endPage, byte *buffer, byte *bufferSize);
+	byte MIFARE_Ultralight_ReadPages(byte startPage, byte pageCount, byte *buffer, byte bufferSize);
+#endif
+#if MFRC522_FEATURE_VALUE_BLOCKS
 	byte MIFARE_Decrement(byte blockAddr, long delta);
 	byte MIFARE_Increment(byte blockAddr, long delta);
 	byte MIFARE_Restore(byte blockAddr);
 	byte MIFARE_Transfer(byte blockAddr);
-	byte MIFARE_Ultralight_Write(byte page, byte *buffer, byte bufferSize);
 	byte MIFARE_GetValue(byte blockAddr, long *value);
 	byte MIFARE_SetValue(byte blockAddr, long value);
+#endif
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Support functions
 	/////////////////////////////////////////////////////////////////////////////////////
+#if MFRC522_FEATURE_READ
 	byte PCD_MIFARE_Transceive(byte *sendData, byte sendLen, bool acceptTimeout = false);
-	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
-	//const char *GetStatusCodeName(byte code);
-	const __FlashStringHelper *GetStatusCodeName(byte code);
-	byte PICC_GetType(byte sak);
-	// old function used too much memory, now name moved to flash; if you need char, copy from flash to memory
-	//const char *PICC_GetTypeName(byte type);
-	const __FlashStringHelper *PICC_GetTypeName(byte type);
+#endif
 
 	// Support functions for debuging
+#if MFRC522_FEATURE_DUMP
 	void PCD_DumpVersionToSerial();
 	void PICC_DumpToSerial(Uid *uid);
 	void PICC_DumpMifareClassicToSerial(Uid *uid, byte piccType, MIFARE_Key *key);
 	void PICC_DumpMifareClassicSectorToSerial(Uid *uid, MIFARE_Key *key, byte sector);
 	void PICC_DumpMifareUltralightToSerial();
-	void MIFARE_SetAccessBits(byte *accessBitBuffer, byte g0, byte g1, byte g2, byte g3);
+#endif
+#if MFRC522_FEATURE_UID_BACKDOOR
 	bool MIFARE_OpenUidBackdoor(bool logErrors);
 	bool MIFARE_SetUid(byte *newUid, byte uidSize, bool logErrors);
 	bool MIFARE_UnbrickUidSector(bool logErrors);
+#endif
 
 	/////////////////////////////////////////////////////////////////////////////////////
 	// Convenience functions - does not add extra functionality
@@ -402,11 +682,92 @@ public:
 	bool PICC_IsNewCardPresent();
 	bool PICC_ReadCardSerial();
 
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Multi-PICC inventory - every PICC in the field instead of whichever wins anticollision
+	/////////////////////////////////////////////////////////////////////////////////////
+	byte PICC_Inventory(Uid *uids, byte maxUids, byte *uidCount, uint16_t budgetMs);
+
+	/////////////////////////////////////////////////////////////////////////////////////
+	// Non-blocking card detection - same result as PICC_IsNewCardPresent() + PICC_ReadCardSerial()
+	// PICC_StartPresenceCheck() re-selects a known PICC, also from HALT, without anticollision.
+	/////////////////////////////////////////////////////////////////////////////////////
+	void PICC_StartDetect();
+	byte PICC_PollDetect();
+	void PICC_StartPresenceCheck(const Uid *known);
+
 private:
-	uint16_t _chipAddress;
+	byte _chipAddress;
 	byte _resetPowerDownPin;	// Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
-	TwoWire *_TwoWireInstance = NULL;	// TwoWire Instance
+	TwoWireT *_TwoWireInstance = NULL;	// TwoWire Instance
+	byte PCD_ChipAddress();
+	PCD_BusStats _busStats;				// I2C error counters
+#if MFRC522_FEATURE_STATS
+	PCD_Stats _stats;					// Operation counters, see PCD_GetStats()
+	const PCD_Timing *_statsTiming;		// Entry of _timing in use, to file timeouts under their command class
+	void PCD_CountTimeout();
+#endif
+	bool _busError;						// A transaction failed since the current PICC command started
+	bool _busRecovering;				// PCD_RecoverBus() is running, do not recurse
+	uint32_t _lastRecoveryMs;			// millis() of the last PCD_RecoverBus()
+	uint32_t _busClock;					// Clock set by PCD_SetBusClock(), 0 if never set
+	byte _sdaPin;						// Pins driven by PCD_RecoverBus(), PIN_NONE if not known
+	byte _sclPin;
+	bool PCD_BusWrite(byte reg, byte count, const byte *values);
+	bool PCD_BusRead(byte reg, byte count, byte *values, byte rxAlign);
+	void PCD_BusFailed();
+	void PCD_Configure();
+	bool PCD_WaitReady();
+	bool PCD_ProbeRegister(byte reg, byte *value);
+	bool _regCacheEnabled;				// Shadow register cache in use, see PCD_SetRegisterCache()
+	uint16_t _regCacheValid;			// Bit n set => _regCache[n] mirrors the chip
+	byte _regCache[REG_CACHE_SIZE];		// Last known values of the cacheable configuration registers
+	void PCD_InvalidateRegisterCache();
+	byte PCD_ReadCachedRegister(byte reg);
+	void PCD_WriteRegisterIfChanged(byte reg, byte value);
+	byte _irqPin;						// Arduino pin connected to the MFRC522 IRQ output, or IRQ_PIN_NONE
+	volatile bool _irqFired;			// Set from the pin-change interrupt, see PCD_SetIrqPin()
+	static MFRC522_I2C_T *_irqInstances[IRQ_MAX_INSTANCES];
+	template <byte slot> static void PCD_IrqHandler();
+	byte _commWaitIRq;					// Success bits of the command started by PCD_StartCommunicate()
+	uint32_t _commDeadline;				// millis() at which that command is given up
+	uint32_t _commStartUs;				// micros() when that command was started
+	PCD_TimingProfile _timing;			// Timer settings per class of PICC commands
+	uint16_t _timeoutTicks;				// Value in TReloadReg, 0 if unknown
+	uint16_t _timeoutUs;				// Timeout set by PCD_SetTimeout()
+	uint16_t _firstPollUs;				// First poll delay set by PCD_SetTimeout()
+	void PCD_UseTiming(const PCD_Timing &timing);
+	byte _bitRate;						// Current TxModeReg/RxModeReg speed, one of the PCD_BitRate values
+	bool _protocolActive;				// The selected PICC has answered RATS and speaks ISO/IEC 14443-4
+	uint32_t _lastTransceiveUs;			// Duration of the last PCD_CommunicateWithPICC()
+	byte _detectStep;					// Where PICC_PollDetect() is, one of the DETECT_STEP_* values
+	byte _detectLevel;					// Cascade level being selected by PICC_PollDetect()
+	byte _detectBuffer[9];				// SEL, NVB, 4 UID bytes (or CT + 3), BCC, CRC_A
+	bool _detectKnownUid;				// Select the UID in the uid member instead of running anticollision
+	void PICC_StartDetectRequest(byte command, bool knownUid);
+	void PICC_StartDetectLevel();
+	bool PICC_StartDetectSelect();
+	void PICC_StartDetectAnticollision();
+	byte _authSector;					// Sector the current Crypto1 session is authenticated for, AUTH_SECTOR_NONE if none
+	byte _authKeyType;					// PICC_CMD_MF_AUTH_KEY_A or _B used for _authSector
+	MIFARE_Key _authKey;				// Key used for _authSector
+	byte PCD_CRC_A(byte *data, byte length, byte *result);
+#if MFRC522_FEATURE_VALUE_BLOCKS
 	byte MIFARE_TwoStepHelper(byte command, byte blockAddr, long data);
+#endif
 };
 
+// Pins PCD_RecoverBus() drives by default: see the TwoWire overload in the .cpp. Unknown for other bus types.
+template <class TwoWireT>
+void MFRC522_I2C_DefaultRecoveryPins(TwoWireT *bus, byte *sdaPin, byte *sclPin) {
+	*sdaPin = MFRC522_I2C_Base::PIN_NONE;
+	*sclPin = MFRC522_I2C_Base::PIN_NONE;
+}
+void MFRC522_I2C_DefaultRecoveryPins(TwoWire *bus, byte *sdaPin, byte *sclPin);
+
+#include "MFRC522_I2C_impl.h"
+
+// The driver on the Arduino TwoWire class, compiled once in MFRC522_I2C.cpp.
+typedef MFRC522_I2C_T<TwoWire> MFRC522_I2C;
+extern template class MFRC522_I2C_T<TwoWire>;
+
 #endif
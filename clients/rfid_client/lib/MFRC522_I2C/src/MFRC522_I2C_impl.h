@@ -0,0 +1,3248 @@
+/*
+ * MFRC522_I2C_impl.h - Member functions of MFRC522_I2C_T, the part of the driver that talks to the MFRC522.
+ * Included at the end of MFRC522_I2C.h; a template needs its definitions wherever it is instantiated.
+ * NOTE: Please also check the comments in MFRC522_I2C.h - they provide useful hints and background information.
+ * Released into the public domain.
+ */
+#ifndef MFRC522_I2C_impl_h
+#define MFRC522_I2C_impl_h
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Functions for setting up the Arduino
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Constructor.
+ * Prepares the output pins.
+ */
+template <class TwoWireT, byte ChipAddress>
+MFRC522_I2C_T<TwoWireT, ChipAddress>::MFRC522_I2C_T(	byte chipAddress,
+					byte resetPowerDownPin,	///< Arduino pin connected to MFRC522's reset and power down input (Pin 6, NRSTPD, active low)
+					TwoWireT *TwoWireInstance
+				) {
+	_chipAddress = (ChipAddress != 0) ? ChipAddress : chipAddress;
+	_resetPowerDownPin = resetPowerDownPin;
+	_TwoWireInstance = TwoWireInstance;
+	memset(&_busStats, 0, sizeof(_busStats));
+#if MFRC522_FEATURE_STATS
+	memset(&_stats, 0, sizeof(_stats));
+	_statsTiming = NULL;
+#endif
+	_busError = false;
+	_busRecovering = false;
+	_lastRecoveryMs = 0;
+	_busClock = 0;
+	MFRC522_I2C_DefaultRecoveryPins(TwoWireInstance, &_sdaPin, &_sclPin);
+	_regCacheEnabled = false;
+	_regCacheValid = 0;
+	_irqPin = IRQ_PIN_NONE;
+	_irqFired = false;
+	_detectStep = 0;
+	_detectKnownUid = false;
+	_authSector = AUTH_SECTOR_NONE;
+	_bitRate = BITRATE_106;
+	_protocolActive = false;
+	_lastTransceiveUs = 0;
+	_timing = DefaultTimingProfile;
+	_timeoutTicks = 0;
+	_timeoutUs = 25000;
+	_firstPollUs = 0;
+} // End constructor
+
+template <class TwoWireT, byte ChipAddress>
+MFRC522_I2C_T<TwoWireT, ChipAddress> *MFRC522_I2C_T<TwoWireT, ChipAddress>::_irqInstances[IRQ_MAX_INSTANCES] = { NULL };
+
+/**
+ * Returns the I2C address of the MFRC522: the template argument if one was given, else the one passed to the constructor.
+ * A constant address lets the compiler fold it into every transaction.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ChipAddress() {
+	return (ChipAddress != 0) ? ChipAddress : _chipAddress;
+} // End PCD_ChipAddress()
+
+/**
+ * Pin-change interrupt handler for the instance registered in _irqInstances[slot].
+ * Only raises a flag; the IRQ registers are read over I2C by the waiting function.
+ */
+template <class TwoWireT, byte ChipAddress>
+template <byte slot>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_IrqHandler() {
+	if (_irqInstances[slot] != NULL) {
+		_irqInstances[slot]->_irqFired = true;
+	}
+} // End PCD_IrqHandler()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Basic interface functions for communicating with the MFRC522
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes a byte to the specified register in the MFRC522 chip.
+ * The interface is described in the datasheet section 8.1.2.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_WriteRegister(	byte reg,		///< The register to write to. One of the PCD_Register enums.
+									byte value		///< The value to write.
+								) {
+	if (!PCD_BusWrite(reg, 1, &value)) {
+		return;
+	}
+
+	if (_regCacheEnabled) {
+		int8_t slot = PCD_RegisterCacheSlot(reg);
+		if (slot >= 0) {
+			// StartSend (BitFramingReg[7]) is a trigger, not a setting. Never remember it.
+			_regCache[slot] = (reg == BitFramingReg) ? (value & 0x7F) : value;
+			_regCacheValid |= (1 << slot);
+		}
+	}
+} // End PCD_WriteRegister()
+
+/**
+ * Writes a number of bytes to the specified register in the MFRC522 chip.
+ * The interface is described in the datasheet section 8.1.2.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_WriteRegister(	byte reg,		///< The register to write to. One of the PCD_Register enums.
+									byte count,		///< The number of bytes to write to the register
+									byte *values	///< The values to write. Byte array.
+								) {
+	if (count == 0) {
+		return;
+	}
+	PCD_BusWrite(reg, count, values);
+
+	if (_regCacheEnabled) {
+		int8_t slot = PCD_RegisterCacheSlot(reg);
+		if (slot >= 0) {
+			_regCacheValid &= ~(1 << slot);
+		}
+	}
+} // End PCD_WriteRegister()
+
+/**
+ * Reads a byte from the specified register in the MFRC522 chip.
+ * The interface is described in the datasheet section 8.1.2.
+ *
+ * @return The register value, 0 if the bus transaction failed (see PCD_GetBusStats()).
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ReadRegister(	byte reg	///< The register to read from. One of the PCD_Register enums.
+								) {
+	byte value = 0;
+	PCD_BusRead(reg, 1, &value, 0);
+	return value;
+} // End PCD_ReadRegister()
+
+/**
+ * Reads a number of bytes from the specified register in the MFRC522 chip.
+ * The interface is described in the datasheet section 8.1.2.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ReadRegister(	byte reg,		///< The register to read from. One of the PCD_Register enums.
+								byte count,		///< The number of bytes to read
+								byte *values,	///< Byte array to store the values in.
+								byte rxAlign	///< Only bit positions rxAlign..7 in values[0] are updated.
+								) {
+	if (count == 0) {
+		return;
+	}
+	PCD_BusRead(reg, count, values, rxAlign);
+} // End PCD_ReadRegister()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// I2C transactions, error accounting and bus recovery
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Writes reg followed by count bytes in one I2C transaction.
+ *
+ * A failed transaction is repeated up to I2C_MAX_RETRIES times if that is harmless: always when the address was
+ * not acknowledged (nothing reached the chip), otherwise only for registers other than FIFODataReg, where
+ * a repeat would push the same bytes twice. When all attempts fail the error is counted, latched for the
+ * running PICC command (STATUS_BUS_ERROR) and a bus recovery is attempted.
+ *
+ * @return true on success.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_BusWrite(	byte reg,				///< The register to write to. One of the PCD_Register enums.
+								byte count,				///< The number of bytes to write
+								const byte *values		///< The values to write
+							) {
+	for (byte attempt = 0; ; attempt++) {
+		_TwoWireInstance->beginTransmission(PCD_ChipAddress());
+		_TwoWireInstance->write(reg);
+		for (byte index = 0; index < count; index++) {
+			_TwoWireInstance->write(values[index]);
+		}
+		byte error = _TwoWireInstance->endTransmission();	// 0 success, 2 address NACK, 3 data NACK, 4 other, 5 timeout
+		if (error == 0) {
+#if MFRC522_FEATURE_STATS
+			_stats.regWrites++;
+			_stats.bytesWritten += count;
+#endif
+			return true;
+		}
+		_busStats.lastError = error;
+		if (attempt >= I2C_MAX_RETRIES || (error != 2 && reg == FIFODataReg)) {
+			break;
+		}
+		_busStats.retries++;
+	}
+	PCD_BusFailed();
+	return false;
+} // End PCD_BusWrite()
+
+/**
+ * Reads count bytes from reg: a register pointer write followed by a read transaction.
+ * Retried like PCD_BusWrite(). A short read of FIFODataReg is not retried because the bytes that
+ * did arrive have already left the FIFO.
+ *
+ * @return true on success.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_BusRead(	byte reg,		///< The register to read from. One of the PCD_Register enums.
+								byte count,		///< The number of bytes to read
+								byte *values,	///< Byte array to store the values in.
+								byte rxAlign	///< Only bit positions rxAlign..7 in values[0] are updated.
+							) {
+	for (byte attempt = 0; ; attempt++) {
+		_TwoWireInstance->beginTransmission(PCD_ChipAddress());
+		_TwoWireInstance->write(reg);
+		byte error = _TwoWireInstance->endTransmission();
+		bool retryable = true;
+		if (error == 0) {
+			byte received = _TwoWireInstance->requestFrom(PCD_ChipAddress(), (uint8_t)count);
+			if (received == count) {
+				for (byte index = 0; index < count; index++) {
+					byte value = _TwoWireInstance->read();
+					if (index == 0 && rxAlign) {		// Only update bit positions rxAlign..7 in values[0]
+						byte mask = (byte)(0xFF << rxAlign);
+						values[0] = (values[0] & ~mask) | (value & mask);
+					}
+					else { // Normal case
+						values[index] = value;
+					}
+				}
+#if MFRC522_FEATURE_STATS
+				_stats.regReads++;
+				_stats.bytesRead += count;
+#endif
+				return true;
+			}
+			while (_TwoWireInstance->available()) {	// Drop a partial answer
+				_TwoWireInstance->read();
+			}
+			error = I2C_ERROR_SHORT_READ;
+			retryable = (reg != FIFODataReg);
+		}
+		_busStats.lastError = error;
+		if (attempt >= I2C_MAX_RETRIES || !retryable) {
+			break;
+		}
+		_busStats.retries++;
+	}
+	PCD_BusFailed();
+	return false;
+} // End PCD_BusRead()
+
+/**
+ * Books a failed transaction and tries to get the bus back.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_BusFailed() {
+	_busStats.errors++;
+	_busError = true;
+	PCD_RecoverBus();
+} // End PCD_BusFailed()
+
+/**
+ * Frees a stuck bus and brings the MFRC522 back into a known configuration.
+ *
+ * A slave that lost track in the middle of a byte can hold SDA low forever. Up to nine SCL pulses let it shift out
+ * the rest of that byte, then a STOP condition resets every slave's bus logic. The TwoWire peripheral is restarted
+ * at the clock set by PCD_SetBusClock(). Finally the register cache is dropped and the configuration of PCD_Init()
+ * is written again, in case the chip was reset by the same glitch.
+ *
+ * Takes well under a millisecond plus a few transactions. To keep a dead reader from eating the loop,
+ * it runs at most once per BUS_RECOVERY_HOLDOFF_MS.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_RecoverBus() {
+	if (_busRecovering) {
+		return;
+	}
+	uint32_t now = millis();
+	if (_busStats.recoveries != 0 && now - _lastRecoveryMs < BUS_RECOVERY_HOLDOFF_MS) {
+		return;
+	}
+	_busRecovering = true;
+	_lastRecoveryMs = now;
+	_busStats.recoveries++;
+
+	if (_sdaPin != PIN_NONE && _sclPin != PIN_NONE) {
+		_TwoWireInstance->end();
+		pinMode(_sdaPin, INPUT_PULLUP);
+		pinMode(_sclPin, INPUT_PULLUP);
+		// Open drain by hand: drive low, or release to the pull-up.
+		for (byte i = 0; i < 9 && digitalRead(_sdaPin) == LOW; i++) {
+			digitalWrite(_sclPin, LOW);
+			pinMode(_sclPin, OUTPUT);
+			delayMicroseconds(5);
+			pinMode(_sclPin, INPUT_PULLUP);
+			delayMicroseconds(5);
+		}
+		// STOP: SDA goes high while SCL is high.
+		digitalWrite(_sdaPin, LOW);
+		pinMode(_sdaPin, OUTPUT);
+		delayMicroseconds(5);
+		pinMode(_sdaPin, INPUT_PULLUP);
+		delayMicroseconds(5);
+		_TwoWireInstance->begin();
+		if (_busClock != 0) {
+			_TwoWireInstance->setClock(_busClock);
+		}
+	}
+
+	PCD_InvalidateRegisterCache();
+	_timeoutTicks = 0;
+	_authSector = AUTH_SECTOR_NONE;
+	_protocolActive = false;
+	byte version = PCD_ReadRegister(VersionReg);
+	if (version != 0x00 && version != 0xFF) {		// Somebody answers: restore the configuration
+		PCD_Configure();
+		_bitRate = 0xFF;							// Unknown, force the write
+		PCD_SetBitRate(BITRATE_106);
+	}
+	_busRecovering = false;
+} // End PCD_RecoverBus()
+
+/**
+ * Sets the I2C clock and remembers it, so PCD_RecoverBus() can restart the bus at the same speed.
+ * Readers sharing a TwoWire bus should all be given the same clock.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetBusClock(uint32_t clockHz		///< I2C clock in Hz, e.g. 100000 or 400000
+								) {
+	_busClock = clockHz;
+	_TwoWireInstance->setClock(clockHz);
+} // End PCD_SetBusClock()
+
+/**
+ * Sets the pins PCD_RecoverBus() drives to free a stuck bus. Pass PIN_NONE to only re-initialise the chip.
+ * Defaults to PIN_WIRE_SDA/PIN_WIRE_SCL for the Wire instance, none for other buses.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetBusRecoveryPins(	byte sdaPin,	///< Arduino pin of SDA
+											byte sclPin		///< Arduino pin of SCL
+										) {
+	_sdaPin = sdaPin;
+	_sclPin = sclPin;
+} // End PCD_SetBusRecoveryPins()
+
+/**
+ * Returns the I2C error counters.
+ */
+template <class TwoWireT, byte ChipAddress>
+MFRC522_I2C_Base::PCD_BusStats MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_GetBusStats() {
+	return _busStats;
+} // End PCD_GetBusStats()
+
+#if MFRC522_FEATURE_STATS
+/**
+ * Returns a snapshot of the operation counters.
+ * Only register traffic that got through is counted; failed transactions are in PCD_GetBusStats().
+ */
+template <class TwoWireT, byte ChipAddress>
+MFRC522_I2C_Base::PCD_Stats MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_GetStats() {
+	return _stats;
+} // End PCD_GetStats()
+
+/**
+ * Clears the operation counters, e.g. after publishing a snapshot so the next one covers one interval.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ResetStats() {
+	memset(&_stats, 0, sizeof(_stats));
+} // End PCD_ResetStats()
+
+/**
+ * Counts a STATUS_TIMEOUT of the running PICC command under the timing class it was started with.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_CountTimeout() {
+	if (_statsTiming == &_timing.request) {
+		_stats.timeouts.request++;
+	}
+	else if (_statsTiming == &_timing.select) {
+		_stats.timeouts.select++;
+	}
+	else if (_statsTiming == &_timing.halt) {
+		_stats.timeouts.halt++;
+	}
+	else if (_statsTiming == &_timing.auth) {
+		_stats.timeouts.auth++;
+	}
+	else {
+		_stats.timeouts.transfer++;
+	}
+} // End PCD_CountTimeout()
+#endif // MFRC522_FEATURE_STATS
+
+/**
+ * Sets the bits given in mask in register reg.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetRegisterBitMask(	byte reg,	///< The register to update. One of the PCD_Register enums.
+										byte mask	///< The bits to set.
+									) {
+	byte tmp;
+	tmp = PCD_ReadCachedRegister(reg);
+	PCD_WriteRegister(reg, tmp | mask);			// set bit mask
+} // End PCD_SetRegisterBitMask()
+
+/**
+ * Clears the bits given in mask from register reg.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ClearRegisterBitMask(	byte reg,	///< The register to update. One of the PCD_Register enums.
+										byte mask	///< The bits to clear.
+									  ) {
+	byte tmp;
+	tmp = PCD_ReadCachedRegister(reg);
+	if (_regCacheEnabled && PCD_RegisterCacheSlot(reg) >= 0 && (tmp & mask) == 0) {
+		return;									// The cache says the bits are already cleared
+	}
+	PCD_WriteRegister(reg, tmp & (~mask));		// clear bit mask
+} // End PCD_ClearRegisterBitMask()
+
+/**
+ * Enables or disables the shadow register cache.
+ *
+ * With the cache enabled the driver remembers the last value written to the configuration registers it owns
+ * (see PCD_RegisterCacheSlot()), so PCD_SetRegisterBitMask() and PCD_ClearRegisterBitMask() on those registers
+ * cost a single I2C write instead of a read followed by a write. Registers the chip updates by itself
+ * (CommandReg, ComIrqReg, DivIrqReg, ErrorReg, Status2Reg, FIFOLevelReg, ...) are never cached and always read from the chip.
+ *
+ * Only enable this if nothing else writes to the MFRC522 behind the back of this instance.
+ * The cache is dropped on every PCD_Reset() and hard reset.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetRegisterCache(	bool enabled	///< True to mirror configuration registers in RAM.
+									) {
+	_regCacheEnabled = enabled;
+	PCD_InvalidateRegisterCache();
+} // End PCD_SetRegisterCache()
+
+/**
+ * Forgets all cached register values, eg after the chip has been reset.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_InvalidateRegisterCache() {
+	_regCacheValid = 0;
+} // End PCD_InvalidateRegisterCache()
+
+/**
+ * Reads a register, served from the shadow register cache when possible.
+ * A cache miss on a cacheable register reads the chip and fills the cache.
+ *
+ * @return The register value.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ReadCachedRegister(	byte reg	///< The register to read from. One of the PCD_Register enums.
+										) {
+	int8_t slot = _regCacheEnabled ? PCD_RegisterCacheSlot(reg) : -1;
+	if (slot >= 0 && (_regCacheValid & (1 << slot))) {
+		return _regCache[slot];
+	}
+	byte value = PCD_ReadRegister(reg);
+	if (slot >= 0) {
+		_regCache[slot] = (reg == BitFramingReg) ? (value & 0x7F) : value;
+		_regCacheValid |= (1 << slot);
+	}
+	return value;
+} // End PCD_ReadCachedRegister()
+
+/**
+ * Writes a register unless the shadow register cache knows it already holds that value.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_WriteRegisterIfChanged(	byte reg,	///< The register to write to. One of the PCD_Register enums.
+											byte value	///< The value to write.
+										) {
+	int8_t slot = _regCacheEnabled ? PCD_RegisterCacheSlot(reg) : -1;
+	if (slot >= 0 && (_regCacheValid & (1 << slot)) && _regCache[slot] == value) {
+		return;
+	}
+	PCD_WriteRegister(reg, value);
+} // End PCD_WriteRegisterIfChanged()
+
+
+/**
+ * Use the CRC coprocessor in the MFRC522 to calculate a CRC_A.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_CalculateCRC(	byte *data,		///< In: Pointer to the data to transfer to the FIFO for CRC calculation.
+								byte length,	///< In: The number of bytes to transfer.
+								byte *result	///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
+					 ) {
+	PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop any active command.
+	if (_irqPin != IRQ_PIN_NONE) {
+		PCD_WriteRegisterIfChanged(ComIEnReg, 0x80);	// IRqInv=1 (IRQ active low), no ComIrqReg sources
+		PCD_WriteRegisterIfChanged(DivIEnReg, 0x04);	// IRQ open drain, CRCIEn
+	}
+	PCD_WriteRegister(DivIrqReg, 0x04);				// Clear the CRCIRq interrupt request bit
+	_irqFired = false;
+	PCD_WriteRegister(FIFOLevelReg, 0x80);			// FlushBuffer = 1, FIFO initialization. FIFOLevelReg[6..0] are read-only, no need to read first.
+	PCD_WriteRegister(FIFODataReg, length, data);	// Write data to the FIFO
+	PCD_WriteRegister(CommandReg, PCD_CalcCRC);		// Start the calculation
+
+	// Wait for the CRC calculation to complete. Each iteration of the while-loop takes 17.73�s.
+	const uint32_t deadline = millis() + 89;
+	byte n;
+	do {
+#if MFRC522_FEATURE_STATS
+		_stats.crcPolls++;
+#endif
+		if (_irqPin != IRQ_PIN_NONE && !_irqFired) {	// Nothing to read before the IRQ pin says so.
+			yield();
+			continue;
+		}
+		_irqFired = false;
+		n = PCD_ReadRegister(DivIrqReg);	// DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
+		if (n & 0x04) {						// CRCIRq bit set - calculation done
+			PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop calculating CRC for new content in the FIFO.
+
+			// Transfer the result from the registers to the result buffer
+			result[0] = PCD_ReadRegister(CRCResultRegL);
+			result[1] = PCD_ReadRegister(CRCResultRegH);
+			return STATUS_OK;
+		}
+		yield();
+		}
+	while (millis() < deadline);
+
+#if MFRC522_FEATURE_STATS
+	_stats.timeouts.crc++;
+#endif
+	return STATUS_TIMEOUT;
+} // End PCD_CalculateCRC()
+
+/**
+ * Calculates a CRC_A on the host. Gives the same result as PCD_CalculateCRC() without any I2C traffic.
+ * Uses the lookup table, or the MFRC522 coprocessor if MFRC522_CRC_COPROCESSOR is defined.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_CRC_A(	byte *data,		///< In: Pointer to the data to calculate the CRC_A for.
+							byte length,	///< In: The number of bytes.
+							byte *result	///< Out: Pointer to result buffer. Result is written to result[0..1], low byte first.
+						) {
+#ifdef MFRC522_CRC_COPROCESSOR
+	return PCD_CalculateCRC(data, length, result);
+#else
+	CRC_A_Compute(data, length, result);
+	return STATUS_OK;
+#endif
+} // End PCD_CRC_A()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Functions for manipulating the MFRC522
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Initializes the MFRC522 chip.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_Init() {
+	// Set the resetPowerDownPin as digital output, do not reset or power down.
+	pinMode(_resetPowerDownPin, OUTPUT);
+
+
+	if (digitalRead(_resetPowerDownPin) == LOW) {	//The MFRC522 chip is in power down mode.
+		digitalWrite(_resetPowerDownPin, HIGH);		// Exit power down mode. This triggers a hard reset.
+		PCD_InvalidateRegisterCache();				// All registers are back at their reset values.
+		_timeoutTicks = 0;
+		_authSector = AUTH_SECTOR_NONE;
+		_bitRate = BITRATE_106;
+		_protocolActive = false;
+		// Section 8.8.2 in the datasheet says the oscillator start-up time is the start up time of the crystal + 37,74us.
+		// The chip does not answer on I2C until then, so simply wait until it does.
+		PCD_WaitReady();
+	}
+	else { // Perform a soft reset
+		PCD_Reset();
+	}
+	PCD_Configure();
+} // End PCD_Init()
+
+/**
+ * Writes the configuration PCD_Init() sets up after a reset: timer, modulation, CRC preset, antenna.
+ * Also used by PCD_RecoverBus() when the chip may have lost it.
+ * The values come from PCD_InitTable, written in one pass without reading anything back.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_Configure() {
+	for (byte i = 0; i < PCD_INIT_TABLE_LENGTH; i++) {
+		PCD_WriteRegister(pgm_read_byte(&PCD_InitTable[i][0]), pgm_read_byte(&PCD_InitTable[i][1]));
+	}
+	// Keep PCD_SetTimeout() in step with the reload value in the table.
+	_timeoutTicks = 1000;
+	_timeoutUs = 25000;
+	_firstPollUs = 0;
+} // End PCD_Configure()
+
+/**
+ * Performs a soft reset on the MFRC522 chip and waits for it to be ready again.
+ * The wait is bounded by RESET_TIMEOUT_MS; a chip that does not come back is reported instead of waited for.
+ *
+ * @return true if the chip is ready, false if it did not come back or the bus failed.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_Reset() {
+	_busError = false;
+	PCD_WriteRegister(CommandReg, PCD_SoftReset);	// Issue the SoftReset command.
+	PCD_InvalidateRegisterCache();					// All registers are back at their reset values.
+	_timeoutTicks = 0;
+	_authSector = AUTH_SECTOR_NONE;
+	_bitRate = BITRATE_106;
+	_protocolActive = false;
+	// The datasheet does not mention how long the SoftRest command takes to complete.
+	// But the MFRC522 might have been in soft power-down mode (triggered by bit 4 of CommandReg)
+	// and then needs the oscillator start-up time (section 8.8.2). Poll instead of sleeping for the worst case.
+	return PCD_WaitReady() && !_busError;
+} // End PCD_Reset()
+
+/**
+ * Waits until the MFRC522 answers on I2C with CommandReg showing Idle and the PowerDown bit cleared,
+ * for at most RESET_TIMEOUT_MS. While the chip restarts it may not acknowledge its address;
+ * those transactions are expected and not counted as bus errors.
+ *
+ * @return true if the chip is ready.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_WaitReady() {
+	uint32_t start = millis();
+	while (true) {
+		byte command;
+		if (PCD_ProbeRegister(CommandReg, &command) && (command & 0x1F) == PCD_Idle) {	// PowerDown = 0, Command = Idle
+			return true;
+		}
+		if (millis() - start >= RESET_TIMEOUT_MS) {
+			return false;
+		}
+		delayMicroseconds(200);
+	}
+} // End PCD_WaitReady()
+
+/**
+ * Reads a register once, without retries, error accounting or bus recovery.
+ *
+ * @return true if the read succeeded.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_ProbeRegister(	byte reg,		///< The register to read from. One of the PCD_Register enums.
+										byte *value		///< Out: the register value
+									) {
+	_TwoWireInstance->beginTransmission(PCD_ChipAddress());
+	_TwoWireInstance->write(reg);
+	if (_TwoWireInstance->endTransmission() != 0) {
+		return false;
+	}
+	if (_TwoWireInstance->requestFrom(PCD_ChipAddress(), (uint8_t)1) != 1) {
+		return false;
+	}
+	*value = _TwoWireInstance->read();
+	return true;
+} // End PCD_ProbeRegister()
+
+/**
+ * Turns the antenna on by enabling pins TX1 and TX2.
+ * After a reset these pins are disabled.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_AntennaOn() {
+	byte value = PCD_ReadCachedRegister(TxControlReg);
+	if ((value & 0x03) != 0x03) {
+		PCD_WriteRegister(TxControlReg, value | 0x03);
+	}
+} // End PCD_AntennaOn()
+
+/**
+ * Turns the antenna off by disabling pins TX1 and TX2.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_AntennaOff() {
+	PCD_ClearRegisterBitMask(TxControlReg, 0x03);
+} // End PCD_AntennaOff()
+
+/**
+ * Enters soft power-down mode (section 8.6.2 in the datasheet): the running command is stopped, the oscillator
+ * and the antenna drivers switch off, registers and the I2C interface stay alive.
+ * The register cache stays valid; PCD_SoftPowerUp() brings the chip back with the same configuration.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SoftPowerDown() {
+	PCD_WriteRegister(CommandReg, 0x10 | PCD_Idle);	// PowerDown = 1
+	_authSector = AUTH_SECTOR_NONE;					// The PICCs lose power with the field
+	_protocolActive = false;
+} // End PCD_SoftPowerDown()
+
+/**
+ * Leaves soft power-down mode and waits for the oscillator, at most RESET_TIMEOUT_MS like PCD_Reset().
+ * The antenna drivers come back as they were set in TxControlReg.
+ *
+ * @return true if the chip is ready.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SoftPowerUp() {
+	_busError = false;
+	PCD_WriteRegister(CommandReg, PCD_Idle);		// PowerDown = 0. The bit reads 1 until the oscillator runs.
+	return PCD_WaitReady() && !_busError;
+} // End PCD_SoftPowerUp()
+
+/**
+ * Get the current MFRC522 Receiver Gain (RxGain[2:0]) value.
+ * See 9.3.3.6 / table 98 in http://www.nxp.com/documents/data_sheet/MFRC522.pdf
+ * NOTE: Return value scrubbed with (0x07<<4)=01110000b as RCFfgReg may use reserved bits.
+ *
+ * @return Value of the RxGain, scrubbed to the 3 bits used.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_GetAntennaGain() {
+	return PCD_ReadCachedRegister(RFCfgReg) & (0x07<<4);
+} // End PCD_GetAntennaGain()
+
+/**
+ * Set the MFRC522 Receiver Gain (RxGain) to value specified by given mask.
+ * See 9.3.3.6 / table 98 in http://www.nxp.com/documents/data_sheet/MFRC522.pdf
+ * NOTE: Given mask is scrubbed with (0x07<<4)=01110000b as RCFfgReg may use reserved bits.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetAntennaGain(byte mask) {
+	if (PCD_GetAntennaGain() != mask) {						// only bother if there is a change
+		PCD_ClearRegisterBitMask(RFCfgReg, (0x07<<4));		// clear needed to allow 000 pattern
+		PCD_SetRegisterBitMask(RFCfgReg, mask & (0x07<<4));	// only set RxGain[2:0] bits
+	}
+} // End PCD_SetAntennaGain()
+
+/**
+ * Performs a self-test of the MFRC522
+ * See 16.1.1 in http://www.nxp.com/documents/data_sheet/MFRC522.pdf
+ *
+ * @return Whether or not the test passed.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_PerformSelfTest() {
+	// This follows directly the steps outlined in 16.1.1
+	// 1. Perform a soft reset.
+	PCD_Reset();
+
+	// 2. Clear the internal buffer by writing 25 bytes of 00h
+	byte ZEROES[25] = {0x00};
+	PCD_WriteRegister(FIFOLevelReg, 0x80);		// flush the FIFO buffer
+	PCD_WriteRegister(FIFODataReg, 25, ZEROES);	// write 25 bytes of 00h to FIFO
+	PCD_WriteRegister(CommandReg, PCD_Mem);		// transfer to internal buffer
+
+	// 3. Enable self-test
+	PCD_WriteRegister(AutoTestReg, 0x09);
+
+	// 4. Write 00h to FIFO buffer
+	PCD_WriteRegister(FIFODataReg, 0x00);
+
+	// 5. Start self-test by issuing the CalcCRC command
+	PCD_WriteRegister(CommandReg, PCD_CalcCRC);
+
+	// 6. Wait for self-test to complete
+	word i;
+	byte n;
+	for (i = 0; i < 0xFF; i++) {
+		n = PCD_ReadRegister(DivIrqReg);	// DivIrqReg[7..0] bits are: Set2 reserved reserved MfinActIRq reserved CRCIRq reserved reserved
+		if (n & 0x04) {						// CRCIRq bit set - calculation done
+			break;
+		}
+	}
+	PCD_WriteRegister(CommandReg, PCD_Idle);		// Stop calculating CRC for new content in the FIFO.
+
+	// 7. Read out resulting 64 bytes from the FIFO buffer.
+	byte result[64];
+	PCD_ReadRegister(FIFODataReg, 64, result, 0);
+
+	// Auto self-test done
+	// Reset AutoTestReg register to be 0 again. Required for normal operation.
+	PCD_WriteRegister(AutoTestReg, 0x00);
+
+	// Determine firmware version (see section 9.3.4.8 in spec)
+	byte version = PCD_ReadRegister(VersionReg);
+
+	// Pick the appropriate reference values
+	const byte *reference;
+	switch (version) {
+		case 0x88:	// Fudan Semiconductor FM17522 clone
+			reference = FM17522_firmware_reference;
+			break;
+		case 0x90:	// Version 0.0
+			reference = MFRC522_firmware_referenceV0_0;
+			break;
+		case 0x91:	// Version 1.0
+			reference = MFRC522_firmware_referenceV1_0;
+			break;
+		case 0x92:	// Version 2.0
+			reference = MFRC522_firmware_referenceV2_0;
+			break;
+		default:	// Unknown version
+			return false;
+	}
+
+	// Verify that the results match up to our expectations
+	for (i = 0; i < 64; i++) {
+		if (result[i] != pgm_read_byte(&(reference[i]))) {
+			return false;
+		}
+	}
+
+	// Test passed; all is good.
+	return true;
+} // End PCD_PerformSelfTest()
+
+/**
+ * Uses the MFRC522 IRQ output to detect command completion instead of polling the IRQ registers over I2C.
+ * PCD_CommunicateWithPICC() and PCD_CalculateCRC() program ComIEnReg/DivIEnReg for the interrupts they wait for,
+ * then only read ComIrqReg/DivIrqReg once the pin has fired. The millis() deadlines still apply as a safety net.
+ * The IRQ output is configured as open drain, so the pin is set up with the internal pull-up.
+ *
+ * Pass IRQ_PIN_NONE to go back to polling.
+ *
+ * @return true if the IRQ pin is in use, false if polling is used.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetIrqPin(	byte irqPin	///< Arduino pin connected to the MFRC522 IRQ output (Pin 23, active low), or IRQ_PIN_NONE.
+								) {
+	static void (*const handlers[IRQ_MAX_INSTANCES])() = {
+		&PCD_IrqHandler<0>, &PCD_IrqHandler<1>, &PCD_IrqHandler<2>, &PCD_IrqHandler<3>
+	};
+
+	// Release the current pin and slot, if any.
+	if (_irqPin != IRQ_PIN_NONE) {
+		detachInterrupt(digitalPinToInterrupt(_irqPin));
+		for (byte i = 0; i < IRQ_MAX_INSTANCES; i++) {
+			if (_irqInstances[i] == this) {
+				_irqInstances[i] = NULL;
+			}
+		}
+		_irqPin = IRQ_PIN_NONE;
+	}
+	if (irqPin == IRQ_PIN_NONE || digitalPinToInterrupt(irqPin) == NOT_AN_INTERRUPT) {
+		return false;
+	}
+
+	for (byte i = 0; i < IRQ_MAX_INSTANCES; i++) {
+		if (_irqInstances[i] == NULL) {
+			_irqInstances[i] = this;
+			_irqPin = irqPin;
+			_irqFired = false;
+			pinMode(irqPin, INPUT_PULLUP);
+			attachInterrupt(digitalPinToInterrupt(irqPin), handlers[i], FALLING);
+			return true;
+		}
+	}
+	return false;	// No free slot, keep polling.
+} // End PCD_SetIrqPin()
+
+/**
+ * Replaces the timer settings used per class of PICC commands. See DefaultTimingProfile.
+ * Shorter timeouts make failing commands (an empty field for REQA, every successful HLTA) cheaper,
+ * but must stay above the reply time of the slowest PICC you want to support.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetTimingProfile(	const PCD_TimingProfile *profile	///< The timings to copy.
+									) {
+	_timing = *profile;
+} // End PCD_SetTimingProfile()
+
+/**
+ * Sets the reply timeout for the following commands and how long to wait before ComIrqReg is read for the first time.
+ * The MFRC522 timer runs at 40kHz (set up in PCD_Init()), so the timeout is rounded up to 25us.
+ * TReloadReg is only written when the value changes.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetTimeout(	uint16_t timeoutUs,		///< Reply timeout in microseconds, counted from the end of transmission.
+								uint16_t firstPollUs	///< Microseconds after the command start before the first ComIrqReg read.
+							) {
+	uint16_t ticks = (uint16_t)(((uint32_t)timeoutUs + 24) / 25);
+	if (ticks == 0) {
+		ticks = 1;
+	}
+	if (ticks != _timeoutTicks) {
+		PCD_WriteRegister(TReloadRegH, ticks >> 8);
+		PCD_WriteRegister(TReloadRegL, ticks & 0xFF);
+		_timeoutTicks = ticks;
+	}
+	_timeoutUs = timeoutUs;
+	_firstPollUs = firstPollUs;
+#if MFRC522_FEATURE_STATS
+	_statsTiming = NULL;						// Set by PCD_UseTiming(); a timeout set by hand counts as transfer
+#endif
+} // End PCD_SetTimeout()
+
+/**
+ * Applies one entry of the timing profile.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_UseTiming(	const PCD_Timing &timing	///< Entry of _timing for the command about to be sent.
+								) {
+	PCD_SetTimeout(timing.timeoutUs, timing.firstPollUs);
+#if MFRC522_FEATURE_STATS
+	_statsTiming = &timing;
+#endif
+} // End PCD_UseTiming()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Functions for communicating with PICCs
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Executes the Transceive command.
+ * CRC validation can only be done if backData and backLen are specified.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_TransceiveData(	byte *sendData,		///< Pointer to the data to transfer to the FIFO.
+									byte sendLen,		///< Number of bytes to transfer to the FIFO.
+									byte *backData,		///< NULL or pointer to buffer if data should be read back after executing the command.
+									byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+									byte *validBits,	///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits. Default NULL.
+									byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
+									bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+								 ) {
+	byte waitIRq = 0x30;		// RxIRq and IdleIRq
+	return PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, sendData, sendLen, backData, backLen, validBits, rxAlign, checkCRC);
+} // End PCD_TransceiveData()
+
+/**
+ * Transfers data to the MFRC522 FIFO, executes a command, waits for completion and transfers data back from the FIFO.
+ * CRC validation can only be done if backData and backLen are specified.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_CommunicateWithPICC(	byte command,		///< The command to execute. One of the PCD_Command enums.
+										byte waitIRq,		///< The bits in the ComIrqReg register that signals successful completion of the command.
+										byte *sendData,		///< Pointer to the data to transfer to the FIFO.
+										byte sendLen,		///< Number of bytes to transfer to the FIFO.
+										byte *backData,		///< NULL or pointer to buffer if data should be read back after executing the command.
+										byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+										byte *validBits,	///< In/Out: The number of valid bits in the last byte. 0 for 8 valid bits.
+										byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received. Default 0.
+										bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+									 ) {
+	byte result;
+
+	PCD_StartCommunicate(command, waitIRq, sendData, sendLen, validBits ? *validBits : 0, rxAlign);
+
+	// Wait for the command to complete.
+	do {
+		result = PCD_PollCommunicate();
+	}
+	while (result == STATUS_PENDING);
+	if (result == STATUS_OK) {
+		result = PCD_FinishCommunicate(backData, backLen, validBits, rxAlign, checkCRC);
+	}
+	_lastTransceiveUs = micros() - _commStartUs;
+
+	// A PICC that cannot keep up with the negotiated bit rate stops answering or garbles frames.
+	// Fall back to 106 kBd; the PICC has to be activated again (HLTA/WUPA + SELECT) before it answers.
+	if (_bitRate != BITRATE_106 && (result == STATUS_ERROR || result == STATUS_CRC_WRONG || result == STATUS_TIMEOUT)) {
+		PCD_SetBitRate(BITRATE_106);
+		_protocolActive = false;
+	}
+	return result;
+} // End PCD_CommunicateWithPICC()
+
+/**
+ * First part of PCD_CommunicateWithPICC(): transfers data to the MFRC522 FIFO and starts the command.
+ * Returns as soon as the command is running. Use PCD_PollCommunicate() to find out when it is done,
+ * then PCD_FinishCommunicate() to collect the result.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_StartCommunicate(	byte command,		///< The command to execute. One of the PCD_Command enums.
+									byte waitIRq,		///< The bits in the ComIrqReg register that signals successful completion of the command.
+									byte *sendData,		///< Pointer to the data to transfer to the FIFO.
+									byte sendLen,		///< Number of bytes to transfer to the FIFO.
+									byte txLastBits,	///< The number of valid bits in the last byte to send. 0 for 8 valid bits.
+									byte rxAlign		///< Defines the bit position in backData[0] for the first bit received.
+								) {
+	// Prepare values for BitFramingReg
+	byte bitFraming = (rxAlign << 4) + txLastBits;		// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
+
+	_busError = false;									// Bus errors from here on fail this command
+	PCD_WriteRegister(CommandReg, PCD_Idle);			// Stop any active command.
+	if (_irqPin != IRQ_PIN_NONE) {
+		PCD_WriteRegisterIfChanged(DivIEnReg, 0x00);			// IRQ open drain, no DivIrqReg sources
+		PCD_WriteRegisterIfChanged(ComIEnReg, 0x80 | waitIRq | 0x01);	// IRqInv=1 (IRQ active low), the success bits and TimerIRq
+	}
+	PCD_WriteRegister(ComIrqReg, 0x7F);					// Clear all seven interrupt request bits
+	_irqFired = false;
+	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization. FIFOLevelReg[6..0] are read-only, no need to read first.
+	PCD_WriteRegister(FIFODataReg, sendLen, sendData);	// Write sendData to the FIFO
+	PCD_WriteRegister(BitFramingReg, bitFraming);		// Bit adjustments
+	PCD_WriteRegister(CommandReg, command);				// Execute the command
+	if (command == PCD_Transceive) {
+		PCD_SetRegisterBitMask(BitFramingReg, 0x80);	// StartSend=1, transmission of data starts
+	}
+
+	// In PCD_Init() we set the TAuto flag in TModeReg. This means the timer automatically starts when the PCD stops transmitting.
+	// The host side deadline is only a safety net in case the timer interrupt never shows up.
+	_commWaitIRq = waitIRq;
+	_commStartUs = micros();
+	_commDeadline = millis() + _timeoutUs / 1000 + 11;
+} // End PCD_StartCommunicate()
+
+/**
+ * Checks once whether the command started by PCD_StartCommunicate() has completed.
+ * Costs a single ComIrqReg read, or no bus traffic at all in IRQ pin mode while the pin has not fired.
+ *
+ * @return STATUS_PENDING while the command runs, STATUS_OK when done, STATUS_TIMEOUT or STATUS_BUS_ERROR otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_PollCommunicate() {
+#if MFRC522_FEATURE_STATS
+	_stats.commPolls++;
+#endif
+	if ((uint32_t)(micros() - _commStartUs) < _firstPollUs) {
+		return STATUS_PENDING;					// The reply cannot be there yet, save the bus.
+	}
+	if (_irqPin == IRQ_PIN_NONE || _irqFired) {
+		_irqFired = false;
+		byte n = PCD_ReadRegister(ComIrqReg);	// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
+		if (_busError) {						// The command or this read never made it across the bus
+			return STATUS_BUS_ERROR;
+		}
+		if (n & _commWaitIRq) {					// One of the interrupts that signal success has been set.
+			return STATUS_OK;
+		}
+		if (n & 0x01) {							// Timer interrupt - nothing received within the timeout of the active timing profile
+#if MFRC522_FEATURE_STATS
+			PCD_CountTimeout();
+#endif
+			return STATUS_TIMEOUT;
+		}
+	}
+	else {
+		yield();								// Nothing to read before the IRQ pin says so.
+	}
+	if ((int32_t)(millis() - _commDeadline) >= 0) {
+#if MFRC522_FEATURE_STATS
+		PCD_CountTimeout();
+#endif
+		return STATUS_TIMEOUT;
+	}
+	return STATUS_PENDING;
+} // End PCD_PollCommunicate()
+
+/**
+ * Last part of PCD_CommunicateWithPICC(), once PCD_PollCommunicate() returned STATUS_OK:
+ * checks for errors and transfers data back from the FIFO.
+ * CRC validation can only be done if backData and backLen are specified.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_FinishCommunicate(	byte *backData,		///< NULL or pointer to buffer if data should be read back after executing the command.
+										byte *backLen,		///< In: Max number of bytes to write to *backData. Out: The number of bytes returned.
+										byte *validBits,	///< Out: The number of valid bits in the last byte. 0 for 8 valid bits. May be NULL.
+										byte rxAlign,		///< In: Defines the bit position in backData[0] for the first bit received.
+										bool checkCRC		///< In: True => The last two bytes of the response is assumed to be a CRC_A that must be validated.
+									) {
+	byte n, _validBits = 0;
+
+	// Stop now if any errors except collisions were detected.
+	byte errorRegValue = PCD_ReadRegister(ErrorReg); // ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
+	if (errorRegValue & 0x13) {	 // BufferOvfl ParityErr ProtocolErr
+		return STATUS_ERROR;
+	}
+
+	// If the caller wants data back, get it from the MFRC522.
+	if (backData && backLen) {
+		n = PCD_ReadRegister(FIFOLevelReg);			// Number of bytes in the FIFO
+		if (n > *backLen) {
+			return STATUS_NO_ROOM;
+		}
+		*backLen = n;											// Number of bytes returned
+		PCD_ReadRegister(FIFODataReg, n, backData, rxAlign);	// Get received data from FIFO
+		_validBits = PCD_ReadRegister(ControlReg) & 0x07;		// RxLastBits[2:0] indicates the number of valid bits in the last received byte. If this value is 000b, the whole byte is valid.
+		if (validBits) {
+			*validBits = _validBits;
+		}
+	}
+
+	// Tell about collisions
+	if (errorRegValue & 0x08) {		// CollErr
+		return STATUS_COLLISION;
+	}
+
+	// Perform CRC_A validation if requested.
+	if (backData && backLen && checkCRC) {
+		// In this case a MIFARE Classic NAK is not OK.
+		if (*backLen == 1 && _validBits == 4) {
+			return STATUS_MIFARE_NACK;
+		}
+		// We need at least the CRC_A value and all 8 bits of the last byte must be received.
+		if (*backLen < 2 || _validBits != 0) {
+			return STATUS_CRC_WRONG;
+		}
+		// Verify CRC_A - do our own calculation and store the control in controlBuffer.
+		byte controlBuffer[2];
+		n = PCD_CRC_A(&backData[0], *backLen - 2, &controlBuffer[0]);
+		if (n != STATUS_OK) {
+			return n;
+		}
+		if ((backData[*backLen - 2] != controlBuffer[0]) || (backData[*backLen - 1] != controlBuffer[1])) {
+			return STATUS_CRC_WRONG;
+		}
+	}
+
+	if (_busError) {								// Some of the registers read above are not real
+		return STATUS_BUS_ERROR;
+	}
+	return STATUS_OK;
+} // End PCD_FinishCommunicate()
+
+/**
+ * Transceives a frame of any length, refilling and draining the FIFO while the RF transfer is running.
+ *
+ * WaterLevelReg is set to STREAM_WATER_LEVEL. One Status1Reg read per iteration tells what to do:
+ * 		- LoAlert while sending: at most STREAM_WATER_LEVEL bytes are left in the FIFO, the next chunk from source is written.
+ * 		- HiAlert while receiving: at least FIFO_SIZE - STREAM_WATER_LEVEL bytes are waiting, they are read and passed to sink.
+ * 		  HiAlert also counts the end of the frame still waiting to go out, so it is only taken as received data
+ * 		  once TxIRq in ComIrqReg says the transmission is over.
+ * 		- IRq: RxIRq, ErrIRq or TimerIRq ended the exchange. The rest of the FIFO is drained.
+ * A chunk costs one I2C transaction for the data, so the bus must be faster than the RF link
+ * (400 kHz for 106 kBd). If the FIFO runs dry while sending, the PICC sees a short frame and STATUS_ERROR is returned.
+ *
+ * With useCRC the CRC_A is appended to the frame from source and the response CRC_A is checked on the fly.
+ * The sink still receives the CRC_A as the last two bytes, like MIFARE_Read() returns it.
+ *
+ * The exchange always runs with the transfer entry of the timing profile, whatever the previous command used.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_TransceiveStream(	PCD_StreamSource source,	///< Supplies the frame to send
+										PCD_StreamSink sink,		///< Receives the response. May be NULL.
+										void *context,				///< Passed to source and sink
+										uint16_t *receivedLen,		///< Out: number of bytes received. May be NULL.
+										bool useCRC					///< Append CRC_A to the frame and check the CRC_A of the response
+									) {
+	const byte chunkSize = FIFO_SIZE - STREAM_WATER_LEVEL;
+	byte chunk[FIFO_SIZE];
+	uint16_t txCRC = 0x6363;
+	uint16_t rxCRC = 0x6363;
+	uint16_t received = 0;
+	bool sourceDone = false;
+	bool sending = true;		// More chunks to come from source
+	bool receiving = false;		// TxIRq seen: the FIFO holds received bytes only
+	byte result = STATUS_OK;
+	byte n;
+
+	if (receivedLen) {
+		*receivedLen = 0;
+	}
+	if (source == NULL) {
+		return STATUS_INVALID;
+	}
+	n = PCD_StreamFill(source, context, chunk, FIFO_SIZE - 2, &sourceDone);	// Leave room for the CRC_A of a short frame
+	if (n == 0) {
+		return STATUS_INVALID;
+	}
+
+	PCD_UseTiming(_timing.transfer);					// Not the halt or select timeout of the command before
+	_busError = false;									// Bus errors from here on fail this command
+	PCD_WriteRegister(CommandReg, PCD_Idle);			// Stop any active command.
+	PCD_WriteRegisterIfChanged(DivIEnReg, 0x00);		// No DivIrqReg sources
+	PCD_WriteRegisterIfChanged(ComIEnReg, 0x80 | 0x20 | 0x02 | 0x01);	// RxIRq, ErrIRq and TimerIRq end the exchange, seen in Status1Reg.IRq
+	PCD_WriteRegisterIfChanged(WaterLevelReg, STREAM_WATER_LEVEL);
+	PCD_WriteRegister(ComIrqReg, 0x7F);					// Clear all seven interrupt request bits
+	_irqFired = false;
+	PCD_WriteRegister(FIFOLevelReg, 0x80);				// FlushBuffer = 1, FIFO initialization
+
+	// Prefill the FIFO. If the whole frame fits, it goes in before the transmission starts.
+	if (useCRC) {
+		txCRC = CRC_A_Update(txCRC, chunk, n);
+	}
+	if (sourceDone) {
+		sending = false;
+		if (useCRC) {
+			chunk[n++] = txCRC & 0xFF;
+			chunk[n++] = txCRC >> 8;
+		}
+	}
+	PCD_WriteRegister(FIFODataReg, n, chunk);
+	PCD_WriteRegister(BitFramingReg, 0x00);				// Whole bytes, no alignment
+	PCD_WriteRegister(CommandReg, PCD_Transceive);
+	PCD_SetRegisterBitMask(BitFramingReg, 0x80);		// StartSend=1, transmission of data starts
+
+	uint32_t deadline = millis() + _timeoutUs / 1000 + 11;
+	while (true) {
+		byte status1 = PCD_ReadRegister(Status1Reg);	// Status1Reg[7..0] bits are: reserved CRCOk CRCReady IRq TRunning reserved HiAlert LoAlert
+		if (_busError) {								// A chunk or the status may be lost, the frame cannot be trusted
+			result = STATUS_BUS_ERROR;
+			break;
+		}
+		if (sending && (status1 & 0x01)) {				// LoAlert: room for another chunk
+			n = PCD_StreamFill(source, context, chunk, chunkSize - 2, &sourceDone);
+			if (useCRC) {
+				txCRC = CRC_A_Update(txCRC, chunk, n);
+			}
+			if (sourceDone) {							// Last chunk, close the frame
+				sending = false;
+				if (useCRC) {
+					chunk[n++] = txCRC & 0xFF;
+					chunk[n++] = txCRC >> 8;
+				}
+			}
+			if (PCD_ReadRegister(ComIrqReg) & 0x40) {	// TxIRq: the FIFO ran dry and the frame has already ended
+				result = STATUS_ERROR;
+				break;
+			}
+			if (n) {
+				PCD_WriteRegister(FIFODataReg, n, chunk);
+			}
+			deadline = millis() + _timeoutUs / 1000 + 11;
+			continue;
+		}
+		if (status1 & 0x10) {							// IRq: RxIRq, ErrIRq or TimerIRq
+			break;
+		}
+		if (!sending && !receiving && (status1 & 0x02)) {	// HiAlert, but maybe from the end of the frame being sent
+			if (PCD_ReadRegister(ComIrqReg) & 0x40) {	// TxIRq: the frame is out, check the level again
+				receiving = true;
+				continue;
+			}
+		}
+		else if (receiving && (status1 & 0x02)) {		// HiAlert: a chunk is waiting
+			PCD_ReadRegister(FIFODataReg, chunkSize, chunk);
+			if (useCRC) {
+				rxCRC = CRC_A_Update(rxCRC, chunk, chunkSize);
+			}
+			if (sink) {
+				sink(context, chunk, chunkSize);
+			}
+			received += chunkSize;
+			deadline = millis() + _timeoutUs / 1000 + 11;
+			continue;
+		}
+		if ((int32_t)(millis() - deadline) >= 0) {
+			result = STATUS_TIMEOUT;
+			break;
+		}
+	}
+
+	if (result == STATUS_OK) {
+		byte irq = PCD_ReadRegister(ComIrqReg);			// ComIrqReg[7..0] bits are: Set1 TxIRq RxIRq IdleIRq HiAlertIRq LoAlertIRq ErrIRq TimerIRq
+		byte errorRegValue = PCD_ReadRegister(ErrorReg);	// ErrorReg[7..0] bits are: WrErr TempErr reserved BufferOvfl CollErr CRCErr ParityErr ProtocolErr
+		if (errorRegValue & 0x13) {						// BufferOvfl ParityErr ProtocolErr
+			result = STATUS_ERROR;
+		}
+		else if (errorRegValue & 0x08) {				// CollErr
+			result = STATUS_COLLISION;
+		}
+		else if (!(irq & 0x20)) {						// No RxIRq: the timer ran out
+			result = STATUS_TIMEOUT;
+		}
+	}
+
+	// Drain what is left in the FIFO.
+	if (result == STATUS_OK) {
+		byte level = PCD_ReadRegister(FIFOLevelReg) & 0x7F;
+		while (level) {
+			n = (level > chunkSize) ? chunkSize : level;
+			PCD_ReadRegister(FIFODataReg, n, chunk);
+			if (useCRC) {
+				rxCRC = CRC_A_Update(rxCRC, chunk, n);
+			}
+			if (sink) {
+				sink(context, chunk, n);
+			}
+			received += n;
+			level -= n;
+		}
+		if (useCRC) {
+			byte validBits = PCD_ReadRegister(ControlReg) & 0x07;
+			if (received == 1 && validBits == 4) {		// A MIFARE NAK instead of data
+				result = STATUS_MIFARE_NACK;
+			}
+			else if (received < 2 || validBits != 0 || rxCRC != 0) {	// A correct CRC_A leaves a remainder of 0
+				result = STATUS_CRC_WRONG;
+			}
+		}
+	}
+	if (_busError) {									// Some of the data or registers read above are not real
+		result = STATUS_BUS_ERROR;
+	}
+
+	if (receivedLen) {
+		*receivedLen = received;
+	}
+	return result;
+} // End PCD_TransceiveStream()
+
+/**
+ * Transmits a REQuest command, Type A. Invites PICCs in state IDLE to go to READY and prepare for anticollision or selection. 7 bit frame.
+ * Beware: When two PICCs are in the field at the same time I often get STATUS_TIMEOUT - probably due do bad antenna design.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_RequestA(byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
+							byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
+							) {
+	return PICC_REQA_or_WUPA(PICC_CMD_REQA, bufferATQA, bufferSize);
+} // End PICC_RequestA()
+
+/**
+ * Transmits a Wake-UP command, Type A. Invites PICCs in state IDLE and HALT to go to READY(*) and prepare for anticollision or selection. 7 bit frame.
+ * Beware: When two PICCs are in the field at the same time I often get STATUS_TIMEOUT - probably due do bad antenna design.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_WakeupA(	byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
+							byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
+							) {
+	return PICC_REQA_or_WUPA(PICC_CMD_WUPA, bufferATQA, bufferSize);
+} // End PICC_WakeupA()
+
+/**
+ * Transmits REQA or WUPA commands.
+ * Beware: When two PICCs are in the field at the same time I often get STATUS_TIMEOUT - probably due do bad antenna design.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_REQA_or_WUPA(	byte command, 		///< The command to send - PICC_CMD_REQA or PICC_CMD_WUPA
+									byte *bufferATQA,	///< The buffer to store the ATQA (Answer to request) in
+									byte *bufferSize	///< Buffer size, at least two bytes. Also number of bytes returned if STATUS_OK.
+							   ) {
+	byte validBits;
+	byte status;
+
+	if (bufferATQA == NULL || *bufferSize < 2) {	// The ATQA response is 2 bytes long.
+		return STATUS_NO_ROOM;
+	}
+	PCD_SetBitRate(BITRATE_106);					// REQA/WUPA and anticollision always run at 106 kBd
+	_protocolActive = false;
+	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+	PCD_UseTiming(_timing.request);
+	validBits = 7;									// For REQA and WUPA we need the short frame format - transmit only 7 bits of the last (and only) byte. TxLastBits = BitFramingReg[2..0]
+	status = PCD_TransceiveData(&command, 1, bufferATQA, bufferSize, &validBits);
+	if (status != STATUS_OK) {
+		return status;
+	}
+	if (*bufferSize != 2 || validBits != 0) {		// ATQA must be exactly 16 bits.
+		return STATUS_ERROR;
+	}
+	return STATUS_OK;
+} // End PICC_REQA_or_WUPA()
+
+/**
+ * Transmits SELECT/ANTICOLLISION commands to select a single PICC.
+ * Before calling this function the PICCs must be placed in the READY(*) state by calling PICC_RequestA() or PICC_WakeupA().
+ * On success:
+ * 		- The chosen PICC is in state ACTIVE(*) and all other PICCs have returned to state IDLE/HALT. (Figure 7 of the ISO/IEC 14443-3 draft.)
+ * 		- The UID size and value of the chosen PICC is returned in *uid along with the SAK.
+ *
+ * A PICC UID consists of 4, 7 or 10 bytes.
+ * Only 4 bytes can be specified in a SELECT command, so for the longer UIDs two or three iterations are used:
+ * 		UID size	Number of UID bytes		Cascade levels		Example of PICC
+ * 		========	===================		==============		===============
+ * 		single				 4						1				MIFARE Classic
+ * 		double				 7						2				MIFARE Ultralight
+ * 		triple				10						3				Not currently in use?
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_Select(	Uid *uid,			///< Pointer to Uid struct. Normally output, but can also be used to supply a known UID.
+							byte validBits		///< The number of known UID bits supplied in *uid. Normally 0. If set you must also supply uid->size.
+						 ) {
+	bool uidComplete;
+	bool selectDone;
+	bool useCascadeTag;
+	byte cascadeLevel = 1;
+	byte result;
+	byte count;
+	byte index;
+	byte uidIndex;					// The first index in uid->uidByte[] that is used in the current Cascade Level.
+	int8_t currentLevelKnownBits;		// The number of known UID bits in the current Cascade Level.
+	byte buffer[9];					// The SELECT/ANTICOLLISION commands uses a 7 byte standard frame + 2 bytes CRC_A
+	byte bufferUsed;				// The number of bytes used in the buffer, ie the number of bytes to transfer to the FIFO.
+	byte rxAlign;					// Used in BitFramingReg. Defines the bit position for the first bit received.
+	byte txLastBits;				// Used in BitFramingReg. The number of valid bits in the last transmitted byte.
+	byte *responseBuffer;
+	byte responseLength;
+
+	// Description of buffer structure:
+	//		Byte 0: SEL 				Indicates the Cascade Level: PICC_CMD_SEL_CL1, PICC_CMD_SEL_CL2 or PICC_CMD_SEL_CL3
+	//		Byte 1: NVB					Number of Valid Bits (in complete command, not just the UID): High nibble: complete bytes, Low nibble: Extra bits.
+	//		Byte 2: UID-data or CT		See explanation below. CT means Cascade Tag.
+	//		Byte 3: UID-data
+	//		Byte 4: UID-data
+	//		Byte 5: UID-data
+	//		Byte 6: BCC					Block Check Character - XOR of bytes 2-5
+	//		Byte 7: CRC_A
+	//		Byte 8: CRC_A
+	// The BCC and CRC_A is only transmitted if we know all the UID bits of the current Cascade Level.
+	//
+	// Description of bytes 2-5: (Section 6.5.4 of the ISO/IEC 14443-3 draft: UID contents and cascade levels)
+	//		UID size	Cascade level	Byte2	Byte3	Byte4	Byte5
+	//		========	=============	=====	=====	=====	=====
+	//		 4 bytes		1			uid0	uid1	uid2	uid3
+	//		 7 bytes		1			CT		uid0	uid1	uid2
+	//						2			uid3	uid4	uid5	uid6
+	//		10 bytes		1			CT		uid0	uid1	uid2
+	//						2			CT		uid3	uid4	uid5
+	//						3			uid6	uid7	uid8	uid9
+
+#if MFRC522_FEATURE_STATS
+	PCD_CallTimer timer(&_stats.select);
+#endif
+
+	// Sanity checks
+	if (validBits > 80) {
+		return STATUS_INVALID;
+	}
+
+	// Prepare MFRC522
+	_authSector = AUTH_SECTOR_NONE;					// Selecting ends any Crypto1 session
+	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+	PCD_UseTiming(_timing.select);
+
+	// Repeat Cascade Level loop until we have a complete UID.
+	uidComplete = false;
+	while (!uidComplete) {
+		// Set the Cascade Level in the SEL byte, find out if we need to use the Cascade Tag in byte 2.
+		switch (cascadeLevel) {
+			case 1:
+				buffer[0] = PICC_CMD_SEL_CL1;
+				uidIndex = 0;
+				useCascadeTag = validBits && uid->size > 4;	// When we know that the UID has more than 4 bytes
+				break;
+
+			case 2:
+				buffer[0] = PICC_CMD_SEL_CL2;
+				uidIndex = 3;
+				useCascadeTag = validBits && uid->size > 7;	// When we know that the UID has more than 7 bytes
+				break;
+
+			case 3:
+				buffer[0] = PICC_CMD_SEL_CL3;
+				uidIndex = 6;
+				useCascadeTag = false;						// Never used in CL3.
+				break;
+
+			default:
+				return STATUS_INTERNAL_ERROR;
+				break;
+		}
+
+		// How many UID bits are known in this Cascade Level?
+		currentLevelKnownBits = validBits - (8 * uidIndex);
+		if (currentLevelKnownBits < 0) {
+			currentLevelKnownBits = 0;
+		}
+		// Copy the known bits from uid->uidByte[] to buffer[]
+		index = 2; // destination index in buffer[]
+		if (useCascadeTag) {
+			buffer[index++] = PICC_CMD_CT;
+		}
+		byte bytesToCopy = currentLevelKnownBits / 8 + (currentLevelKnownBits % 8 ? 1 : 0); // The number of bytes needed to represent the known bits for this level.
+		if (bytesToCopy) {
+			byte maxBytes = useCascadeTag ? 3 : 4; // Max 4 bytes in each Cascade Level. Only 3 left if we use the Cascade Tag
+			if (bytesToCopy > maxBytes) {
+				bytesToCopy = maxBytes;
+			}
+			for (count = 0; count < bytesToCopy; count++) {
+				buffer[index++] = uid->uidByte[uidIndex + count];
+			}
+		}
+		// Now that the data has been copied we need to include the 8 bits in CT in currentLevelKnownBits
+		if (useCascadeTag) {
+			currentLevelKnownBits += 8;
+		}
+
+		// Repeat anti collision loop until we can transmit all UID bits + BCC and receive a SAK - max 32 iterations.
+		selectDone = false;
+		while (!selectDone) {
+			// Find out how many bits and bytes to send and receive.
+			if (currentLevelKnownBits >= 32) { // All UID bits in this Cascade Level are known. This is a SELECT.
+				//Serial.print(F("SELECT: currentLevelKnownBits=")); Serial.println(currentLevelKnownBits, DEC);
+				buffer[1] = 0x70; // NVB - Number of Valid Bits: Seven whole bytes
+				// Calculate BCC - Block Check Character
+				buffer[6] = buffer[2] ^ buffer[3] ^ buffer[4] ^ buffer[5];
+				// Calculate CRC_A
+				result = PCD_CRC_A(buffer, 7, &buffer[7]);
+				if (result != STATUS_OK) {
+					return result;
+				}
+				txLastBits		= 0; // 0 => All 8 bits are valid.
+				bufferUsed		= 9;
+				// Store response in the last 3 bytes of buffer (BCC and CRC_A - not needed after tx)
+				responseBuffer	= &buffer[6];
+				responseLength	= 3;
+			}
+			else { // This is an ANTICOLLISION.
+				//Serial.print(F("ANTICOLLISION: currentLevelKnownBits=")); Serial.println(currentLevelKnownBits, DEC);
+				txLastBits		= currentLevelKnownBits % 8;
+				count			= currentLevelKnownBits / 8;	// Number of whole bytes in the UID part.
+				index			= 2 + count;					// Number of whole bytes: SEL + NVB + UIDs
+				buffer[1]		= (index << 4) + txLastBits;	// NVB - Number of Valid Bits
+				bufferUsed		= index + (txLastBits ? 1 : 0);
+				// Store response in the unused part of buffer
+				responseBuffer	= &buffer[index];
+				responseLength	= sizeof(buffer) - index;
+			}
+
+			// Set bit adjustments
+			rxAlign = txLastBits;											// Having a seperate variable is overkill. But it makes the next line easier to read.
+			PCD_WriteRegister(BitFramingReg, (rxAlign << 4) + txLastBits);	// RxAlign = BitFramingReg[6..4]. TxLastBits = BitFramingReg[2..0]
+
+			// Transmit the buffer and receive the response.
+			result = PCD_TransceiveData(buffer, bufferUsed, responseBuffer, &responseLength, &txLastBits, rxAlign);
+			if (result == STATUS_COLLISION) { // More than one PICC in the field => collision.
+				result = PCD_ReadRegister(CollReg); // CollReg[7..0] bits are: ValuesAfterColl reserved CollPosNotValid CollPos[4:0]
+				if (result & 0x20) { // CollPosNotValid
+					return STATUS_COLLISION; // Without a valid collision position we cannot continue
+				}
+				byte collisionPos = result & 0x1F; // Values 0-31, 0 means bit 32.
+				if (collisionPos == 0) {
+					collisionPos = 32;
+				}
+				if (collisionPos <= currentLevelKnownBits) { // No progress - should not happen
+					return STATUS_INTERNAL_ERROR;
+				}
+				// Choose the PICC with the bit set.
+				currentLevelKnownBits = collisionPos;
+				count			= (currentLevelKnownBits - 1) % 8; // The bit to modify
+				index			= 1 + (currentLevelKnownBits / 8) + (count ? 1 : 0); // First byte is index 0.
+				buffer[index]	|= (1 << count);
+			}
+			else if (result != STATUS_OK) {
+				return result;
+			}
+			else { // STATUS_OK
+				if (currentLevelKnownBits >= 32) { // This was a SELECT.
+					selectDone = true; // No more anticollision
+					// We continue below outside the while.
+				}
+				else { // This was an ANTICOLLISION.
+					// We now have all 32 bits of the UID in this Cascade Level
+					currentLevelKnownBits = 32;
+					// Run loop again to do the SELECT.
+				}
+			}
+		} // End of while (!selectDone)
+
+		// We do not check the CBB - it was constructed by us above.
+
+		// Copy the found UID bytes from buffer[] to uid->uidByte[]
+		index			= (buffer[2] == PICC_CMD_CT) ? 3 : 2; // source index in buffer[]
+		bytesToCopy		= (buffer[2] == PICC_CMD_CT) ? 3 : 4;
+		for (count = 0; count < bytesToCopy; count++) {
+			uid->uidByte[uidIndex + count] = buffer[index++];
+		}
+
+		// Check response SAK (Select Acknowledge)
+		if (responseLength != 3 || txLastBits != 0) { // SAK must be exactly 24 bits (1 byte + CRC_A).
+			return STATUS_ERROR;
+		}
+		// Verify CRC_A - do our own calculation and store the control in buffer[2..3] - those bytes are not needed anymore.
+		result = PCD_CRC_A(responseBuffer, 1, &buffer[2]);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		if ((buffer[2] != responseBuffer[1]) || (buffer[3] != responseBuffer[2])) {
+			return STATUS_CRC_WRONG;
+		}
+		if (responseBuffer[0] & 0x04) { // Cascade bit set - UID not complete yes
+			cascadeLevel++;
+		}
+		else {
+			uidComplete = true;
+			uid->sak = responseBuffer[0];
+		}
+	} // End of while (!uidComplete)
+
+	// Set correct uid->size
+	uid->size = 3 * cascadeLevel + 1;
+
+	return STATUS_OK;
+} // End PICC_Select()
+
+/**
+ * Instructs a PICC in state ACTIVE(*) to go to state HALT.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_HaltA() {
+	byte result;
+	byte buffer[4];
+#if MFRC522_FEATURE_STATS
+	PCD_CallTimer timer(&_stats.haltA);
+#endif
+
+	_authSector = AUTH_SECTOR_NONE;
+	_protocolActive = false;
+
+	// Build command buffer
+	buffer[0] = PICC_CMD_HLTA;
+	buffer[1] = 0;
+	// Calculate CRC_A
+	result = PCD_CRC_A(buffer, 2, &buffer[2]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Send the command.
+	// The standard says:
+	//		If the PICC responds with any modulation during a period of 1 ms after the end of the frame containing the
+	//		HLTA command, this response shall be interpreted as 'not acknowledge'.
+	// We interpret that this way: Only STATUS_TIMEOUT is an success.
+	PCD_UseTiming(_timing.halt);
+	result = PCD_TransceiveData(buffer, sizeof(buffer), NULL, 0);
+	if (result == STATUS_TIMEOUT) {
+		return STATUS_OK;
+	}
+	if (result == STATUS_OK) { // That is ironically NOT ok in this case ;-)
+		return STATUS_ERROR;
+	}
+	return result;
+} // End PICC_HaltA()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// ISO/IEC 14443-4 activation and bit rate negotiation
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Sends RATS to the selected PICC and returns its ATS (Answer To Select), CRC_A included.
+ * Only PICCs with SAK bit 6 set (PICC_TYPE_ISO_14443_4) understand it. Afterwards the PICC speaks
+ * ISO/IEC 14443-4 only: MIFARE Classic commands no longer work and it must be released with PICC_Deselect().
+ * We announce FSD = 64 bytes, the size of the FIFO, and CID 0.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_RequestATS(	byte *bufferATS,	///< The buffer to store the ATS in
+									byte *bufferSize	///< Buffer size, at least 3 bytes. Also number of bytes returned if STATUS_OK.
+								) {
+	byte result;
+	byte buffer[4];
+
+	if (bufferATS == NULL || *bufferSize < 3) {		// TL + CRC_A at least
+		return STATUS_NO_ROOM;
+	}
+
+	buffer[0] = PICC_CMD_RATS;
+	buffer[1] = 0x50;								// FSDI = 5 (FSD 64 bytes), CID = 0
+	result = PCD_CRC_A(buffer, 2, &buffer[2]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	PCD_UseTiming(_timing.transfer);
+	result = PCD_TransceiveData(buffer, sizeof(buffer), bufferATS, bufferSize, NULL, 0, true);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (bufferATS[0] != *bufferSize - 2) {			// TL is the length of the ATS without the CRC_A
+		return STATUS_ERROR;
+	}
+	_protocolActive = true;
+	return STATUS_OK;
+} // End PICC_RequestATS()
+
+/**
+ * Sends PPS to switch both directions to bitRate, and reprograms the MFRC522 when the PICC confirms.
+ * Must follow PICC_RequestATS() directly; bitRate must be one the ATS offered in both directions.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_PPS(byte bitRate		///< One of the PCD_BitRate values
+						) {
+	byte result;
+	byte buffer[5];
+	byte responseLength = sizeof(buffer);
+
+	if (bitRate > BITRATE_848) {
+		return STATUS_INVALID;
+	}
+
+	buffer[0] = PICC_CMD_PPS;						// PPSS, CID 0
+	buffer[1] = 0x11;								// PPS0: PPS1 follows
+	buffer[2] = (bitRate << 2) | bitRate;			// PPS1: DSI (PICC to PCD) and DRI (PCD to PICC)
+	result = PCD_CRC_A(buffer, 3, &buffer[3]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	PCD_UseTiming(_timing.transfer);
+	result = PCD_TransceiveData(buffer, 5, buffer, &responseLength, NULL, 0, true);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (responseLength != 3 || buffer[0] != PICC_CMD_PPS) {	// PPS response: PPSS + CRC_A
+		return STATUS_ERROR;
+	}
+	PCD_SetBitRate(bitRate);						// The new rate applies from the next frame on
+	return STATUS_OK;
+} // End PICC_PPS()
+
+/**
+ * Activates ISO/IEC 14443-4 on the selected PICC and switches to the fastest bit rate both sides support, up to maxBitRate.
+ * PICCs without ISO/IEC 14443-4 support (MIFARE Classic, Ultralight, NTAG) are left alone at 106 kBd.
+ * If the PICC rejects PPS the link simply stays at 106 kBd. Use PCD_GetBitRate() for the result.
+ *
+ * @return STATUS_OK if the PICC is usable (at whatever rate), STATUS_??? if RATS failed.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_NegotiateBitRate(byte maxBitRate		///< Highest PCD_BitRate to try
+									) {
+	if (!(uid.sak & 0x20)) {						// Not ISO/IEC 14443-4 compliant
+		return STATUS_OK;
+	}
+
+	byte ats[FIFO_SIZE];
+	byte atsLength = sizeof(ats);
+	byte result = PICC_RequestATS(ats, &atsLength);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// ATS: TL T0 [TA(1)] [TB(1)] [TC(1)] historical bytes CRC_A. T0 bit 5 tells whether TA(1) is present.
+	if (atsLength < 5 || !(ats[1] & 0x10)) {
+		return STATUS_OK;							// No TA(1): 106 kBd only
+	}
+	// TA(1) bits: b7..b5 DS 8/4/2 (PICC to PCD), b3..b1 DR 8/4/2 (PCD to PICC). We only use the same rate both ways.
+	byte both = (ats[2] >> 4) & ats[2] & 0x07;
+	for (byte rate = (maxBitRate > (byte)BITRATE_848) ? (byte)BITRATE_848 : maxBitRate; rate > (byte)BITRATE_106; rate--) {
+		if (both & (1 << (rate - 1))) {
+			if (PICC_PPS(rate) != STATUS_OK) {
+				PCD_SetBitRate(BITRATE_106);
+			}
+			break;
+		}
+	}
+	return STATUS_OK;
+} // End PICC_NegotiateBitRate()
+
+/**
+ * Sends S(DESELECT) to end the ISO/IEC 14443-4 protocol. The PICC goes to state HALT, like after PICC_HaltA(),
+ * and the MFRC522 is set back to 106 kBd.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_Deselect() {
+	byte result;
+	byte buffer[3];
+	byte responseLength = sizeof(buffer);
+
+	buffer[0] = PICC_CMD_S_DESELECT;
+	result = PCD_CRC_A(buffer, 1, &buffer[1]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	PCD_UseTiming(_timing.transfer);
+	result = PCD_TransceiveData(buffer, 3, buffer, &responseLength, NULL, 0, true);
+	_protocolActive = false;
+	_authSector = AUTH_SECTOR_NONE;
+	PCD_SetBitRate(BITRATE_106);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	if (responseLength != 3 || buffer[0] != PICC_CMD_S_DESELECT) {
+		return STATUS_ERROR;
+	}
+	return STATUS_OK;
+} // End PICC_Deselect()
+
+/**
+ * Returns true between a successful PICC_RequestATS() and PICC_Deselect(), PICC_HaltA() or a new REQA/WUPA.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_IsProtocolActive() {
+	return _protocolActive;
+} // End PICC_IsProtocolActive()
+
+/**
+ * Programs the RF bit rate for both directions: TxSpeed/RxSpeed and the modulation pulse width.
+ * Only writes the registers when the rate changes.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_SetBitRate(byte bitRate		///< One of the PCD_BitRate values
+								) {
+	// ModWidth sets the length of the modulation pause, (ModWidth + 1) / 13.56 MHz: about 2.9 us at 106 kBd, halved for each step up.
+	static const byte modWidth[4] = { 0x26, 0x13, 0x09, 0x04 };
+
+	if (bitRate > BITRATE_848 || bitRate == _bitRate) {
+		return;
+	}
+	PCD_WriteRegister(TxModeReg, bitRate << 4);		// TxCRCEn=0, TxSpeed, InvMod=0
+	PCD_WriteRegister(RxModeReg, bitRate << 4);		// RxCRCEn=0, RxSpeed, RxNoErr=0, RxMultiple=0
+	PCD_WriteRegister(ModWidthReg, modWidth[bitRate]);
+	_bitRate = bitRate;
+} // End PCD_SetBitRate()
+
+/**
+ * Returns the current RF bit rate, one of the PCD_BitRate values.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_GetBitRate() {
+	return _bitRate;
+} // End PCD_GetBitRate()
+
+/**
+ * Returns how long the last PICC command took, from writing the FIFO to reading the answer, in microseconds.
+ */
+template <class TwoWireT, byte ChipAddress>
+uint32_t MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_GetLastTransceiveUs() {
+	return _lastTransceiveUs;
+} // End PCD_GetLastTransceiveUs()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Functions for communicating with MIFARE PICCs
+/////////////////////////////////////////////////////////////////////////////////////
+
+#if MFRC522_FEATURE_READ
+/**
+ * Executes the MFRC522 MFAuthent command.
+ * This command manages MIFARE authentication to enable a secure communication to any MIFARE Mini, MIFARE 1K and MIFARE 4K card.
+ * The authentication is described in the MFRC522 datasheet section 10.3.1.9 and http://www.nxp.com/documents/data_sheet/MF1S503x.pdf section 10.1.
+ * For use with MIFARE Classic PICCs.
+ * The PICC must be selected - ie in state ACTIVE(*) - before calling this function.
+ * Remember to call PCD_StopCrypto1() after communicating with the authenticated PICC - otherwise no new communications can start.
+ *
+ * All keys are set to FFFFFFFFFFFFh at chip delivery.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise. Probably STATUS_TIMEOUT if you supply the wrong key.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_Authenticate(byte command,		///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+								byte blockAddr, 	///< The block number. See numbering in the comments in the .h file.
+								const MIFARE_Key *key,	///< Pointer to the Crypteo1 key to use (6 bytes)
+								Uid *uid			///< Pointer to Uid struct. The first 4 bytes of the UID is used.
+								) {
+	byte waitIRq = 0x10;		// IdleIRq
+
+	_authSector = AUTH_SECTOR_NONE;	// Whatever was authenticated before is replaced
+
+	// Build command buffer
+	byte sendData[12];
+	sendData[0] = command;
+	sendData[1] = blockAddr;
+	for (byte i = 0; i < MF_KEY_SIZE; i++) {	// 6 key bytes
+		sendData[2+i] = key->keyByte[i];
+	}
+	for (byte i = 0; i < 4; i++) {				// The last 4 bytes of the UID
+		sendData[8+i] = uid->uidByte[i+uid->size-4];
+	}
+
+	// Start the authentication.
+	PCD_UseTiming(_timing.auth);
+	return PCD_CommunicateWithPICC(PCD_MFAuthent, waitIRq, &sendData[0], sizeof(sendData));
+} // End PCD_Authenticate()
+#endif // MFRC522_FEATURE_READ
+
+/**
+ * Used to exit the PCD from its authenticated state.
+ * Remember to call this function after communicating with an authenticated PICC - otherwise no new communications can start.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_StopCrypto1() {
+	// Clear MFCrypto1On bit
+	PCD_ClearRegisterBitMask(Status2Reg, 0x08); // Status2Reg[7..0] bits are: TempSensClear I2CForceHS reserved reserved MFCrypto1On ModemState[2:0]
+	_authSector = AUTH_SECTOR_NONE;
+} // End PCD_StopCrypto1()
+
+#if MFRC522_FEATURE_READ
+/**
+ * Reads 16 bytes (+ 2 bytes CRC_A) from the active PICC.
+ *
+ * For MIFARE Classic the sector containing the block must be authenticated before calling this function.
+ *
+ * For MIFARE Ultralight only addresses 00h to 0Fh are decoded.
+ * The MF0ICU1 returns a NAK for higher addresses.
+ * The MF0ICU1 responds to the READ command by sending 16 bytes starting from the page address defined by the command argument.
+ * For example; if blockAddr is 03h then pages 03h, 04h, 05h, 06h are returned.
+ * A roll-back is implemented: If blockAddr is 0Eh, then the contents of pages 0Eh, 0Fh, 00h and 01h are returned.
+ *
+ * The buffer must be at least 18 bytes because a CRC_A is also returned.
+ * Checks the CRC_A before returning STATUS_OK.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Read(	byte blockAddr, 	///< MIFARE Classic: The block (0-0xff) number. MIFARE Ultralight: The first page to return data from.
+							byte *buffer,		///< The buffer to store the data in
+							byte *bufferSize	///< Buffer size, at least 18 bytes. Also number of bytes returned if STATUS_OK.
+						) {
+	byte result;
+
+	// Sanity check
+	if (buffer == NULL || *bufferSize < 18) {
+		return STATUS_NO_ROOM;
+	}
+
+	// Build command buffer
+	buffer[0] = PICC_CMD_MF_READ;
+	buffer[1] = blockAddr;
+	// Calculate CRC_A
+	result = PCD_CRC_A(buffer, 2, &buffer[2]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Transmit the buffer and receive the response, validate CRC_A.
+	PCD_UseTiming(_timing.transfer);
+	return PCD_TransceiveData(buffer, 4, buffer, bufferSize, NULL, 0, true);
+} // End MIFARE_Read()
+
+/**
+ * Reads consecutive MIFARE Classic blocks from the selected PICC (the uid member) into buffer, 16 bytes per block.
+ *
+ * Each sector is authenticated once and the Crypto1 session is reused for the following blocks of the sector,
+ * and by later calls for the same sector with the same key, until the PICC is halted, reselected or
+ * PCD_StopCrypto1() is called. Reading the credential blocks of one sector therefore costs one
+ * authentication and one READ per block instead of an authentication per block.
+ *
+ * No memory is allocated; each block goes through an 18 byte stack buffer (data + CRC_A).
+ * Sector trailers can be read like any block; the keys read back as zeros.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise. On error the blocks read so far are in buffer (see timings->blocksRead).
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_ReadBlocks(	byte firstBlock,			///< First block to read
+										byte blockCount,			///< Number of blocks to read, may span sectors
+										byte *buffer,				///< Receives blockCount * 16 bytes
+										byte bufferSize,			///< Size of buffer
+										const MIFARE_Key *key,		///< Key used for every sector touched
+										byte keyType,				///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+										MIFARE_ReadTimings *timings	///< Optional: receives the time spent per phase
+									) {
+	MIFARE_ReadTimings local;
+	if (timings == NULL) {
+		timings = &local;
+	}
+	memset(timings, 0, sizeof(MIFARE_ReadTimings));
+	uint32_t start = micros();
+
+	if (buffer == NULL || (uint16_t)blockCount * 16 > bufferSize) {
+		return STATUS_NO_ROOM;
+	}
+	if (keyType != PICC_CMD_MF_AUTH_KEY_A && keyType != PICC_CMD_MF_AUTH_KEY_B) {
+		return STATUS_INVALID;
+	}
+
+	byte result = STATUS_OK;
+	byte blockBuffer[18];
+	for (byte i = 0; i < blockCount; i++) {
+		byte blockAddr = firstBlock + i;
+		byte sector = MIFARE_SectorOfBlock(blockAddr);
+
+		// Authenticate only when entering a sector, or when the cached session is for another key.
+		if (sector != _authSector || keyType != _authKeyType || memcmp(key->keyByte, _authKey.keyByte, MF_KEY_SIZE) != 0) {
+			uint32_t phaseStart = micros();
+			result = PCD_Authenticate(keyType, blockAddr, key, &uid);
+			timings->authUs += micros() - phaseStart;
+			timings->authCount++;
+			if (result != STATUS_OK) {
+				break;
+			}
+			_authSector = sector;
+			_authKeyType = keyType;
+			memcpy(&_authKey, key, sizeof(MIFARE_Key));
+		}
+
+		uint32_t phaseStart = micros();
+		byte blockSize = sizeof(blockBuffer);
+		result = MIFARE_Read(blockAddr, blockBuffer, &blockSize);
+		timings->readUs += micros() - phaseStart;
+		if (result != STATUS_OK) {
+			_authSector = AUTH_SECTOR_NONE;			// A PICC drops its Crypto1 session on any error
+			break;
+		}
+		memcpy(&buffer[16 * i], blockBuffer, 16);
+		timings->blocksRead++;
+	}
+
+	timings->totalUs = micros() - start;
+	return result;
+} // End MIFARE_ReadBlocks()
+
+/**
+ * Reads the data blocks of a MIFARE Classic sector (all blocks except the sector trailer) with a single authentication.
+ * See MIFARE_ReadBlocks().
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_ReadSector(	byte sector,				///< Sector 0-39
+										byte *buffer,				///< Receives 48 bytes (240 for sectors 32-39 of a 4K)
+										byte bufferSize,			///< Size of buffer
+										const MIFARE_Key *key,		///< Key for the sector
+										byte keyType,				///< PICC_CMD_MF_AUTH_KEY_A or PICC_CMD_MF_AUTH_KEY_B
+										MIFARE_ReadTimings *timings	///< Optional: receives the time spent per phase
+									) {
+	if (sector > 39) {
+		return STATUS_INVALID;
+	}
+	return MIFARE_ReadBlocks(MIFARE_SectorFirstBlock(sector), MIFARE_SectorBlockCount(sector) - 1, buffer, bufferSize, key, keyType, timings);
+} // End MIFARE_ReadSector()
+
+/**
+ * Writes 16 bytes to the active PICC.
+ *
+ * For MIFARE Classic the sector containing the block must be authenticated before calling this function.
+ *
+ * For MIFARE Ultralight the operation is called "COMPATIBILITY WRITE".
+ * Even though 16 bytes are transferred to the Ultralight PICC, only the least significant 4 bytes (bytes 0 to 3)
+ * are written to the specified address. It is recommended to set the remaining bytes 04h to 0Fh to all logic 0.
+ * *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Write(	byte blockAddr, ///< MIFARE Classic: The block (0-0xff) number. MIFARE Ultralight: The page (2-15) to write to.
+							byte *buffer,	///< The 16 bytes to write to the PICC
+							byte bufferSize	///< Buffer size, must be at least 16 bytes. Exactly 16 bytes are written.
+						) {
+	byte result;
+
+	// Sanity check
+	if (buffer == NULL || bufferSize < 16) {
+		return STATUS_INVALID;
+	}
+
+	// Mifare Classic protocol requires two communications to perform a write.
+	// Step 1: Tell the PICC we want to write to block blockAddr.
+	byte cmdBuffer[2];
+	cmdBuffer[0] = PICC_CMD_MF_WRITE;
+	cmdBuffer[1] = blockAddr;
+	result = PCD_MIFARE_Transceive(cmdBuffer, 2); // Adds CRC_A and checks that the response is MF_ACK.
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Step 2: Transfer the data
+	result = PCD_MIFARE_Transceive(buffer, bufferSize); // Adds CRC_A and checks that the response is MF_ACK.
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	return STATUS_OK;
+} // End MIFARE_Write()
+
+/**
+ * Writes a 4 byte page to the active MIFARE Ultralight PICC.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Ultralight_Write(	byte page, 		///< The page (2-15) to write to.
+										byte *buffer,	///< The 4 bytes to write to the PICC
+										byte bufferSize	///< Buffer size, must be at least 4 bytes. Exactly 4 bytes are written.
+									) {
+	byte result;
+
+	// Sanity check
+	if (buffer == NULL || bufferSize < 4) {
+		return STATUS_INVALID;
+	}
+
+	// Build commmand buffer
+	byte cmdBuffer[6];
+	cmdBuffer[0] = PICC_CMD_UL_WRITE;
+	cmdBuffer[1] = page;
+	memcpy(&cmdBuffer[2], buffer, 4);
+
+	// Perform the write
+	result = PCD_MIFARE_Transceive(cmdBuffer, 6); // Adds CRC_A and checks that the response is MF_ACK.
+	if (result != STATUS_OK) {
+		return result;
+	}
+	return STATUS_OK;
+} // End MIFARE_Ultralight_Write()
+
+/**
+ * Reads pages startPage..endPage from an NTAG21x with the FAST_READ command.
+ * At most FAST_READ_MAX_PAGES (15) pages can be read per call, limited by the MFRC522 FIFO.
+ *
+ * MIFARE Ultralight and Ultralight C do not know FAST_READ and answer NAK (or not at all). A NAK sends
+ * the PICC back to IDLE/HALT, so it must be woken and selected again before the next command.
+ *
+ * The buffer must hold the pages plus the 2 byte CRC_A. Checks the CRC_A before returning STATUS_OK.
+ *
+ * @return STATUS_OK on success, STATUS_MIFARE_NACK if the PICC does not support FAST_READ or the range, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Ultralight_FastRead(	byte startPage,		///< First page to read
+											byte endPage,		///< Last page to read, inclusive
+											byte *buffer,		///< The buffer to store the data in
+											byte *bufferSize	///< Buffer size, at least 4 * pages + 2 bytes. Also number of bytes returned if STATUS_OK.
+										) {
+	if (endPage < startPage || endPage - startPage >= FAST_READ_MAX_PAGES) {
+		return STATUS_INVALID;
+	}
+	if (buffer == NULL || *bufferSize < 4 * (endPage - startPage + 1) + 2) {
+		return STATUS_NO_ROOM;
+	}
+
+	// Build command buffer
+	byte cmdBuffer[5];
+	cmdBuffer[0] = PICC_CMD_NTAG_FAST_READ;
+	cmdBuffer[1] = startPage;
+	cmdBuffer[2] = endPage;
+	byte result = PCD_CRC_A(cmdBuffer, 3, &cmdBuffer[3]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Transmit the buffer and receive the response, validate CRC_A.
+	PCD_UseTiming(_timing.transfer);
+	return PCD_TransceiveData(cmdBuffer, sizeof(cmdBuffer), buffer, bufferSize, NULL, 0, true);
+} // End MIFARE_Ultralight_FastRead()
+
+/**
+ * Reads pageCount pages of 4 bytes from the selected MIFARE Ultralight / NTAG PICC (the uid member) into buffer.
+ *
+ * PICC_GetType() picks the path: only PICC_TYPE_MIFARE_UL (SAK 0x00) is accepted. The pages are read with FAST_READ:
+ * more than 15 pages in a single exchange through PCD_TransceiveStream(), or up to 15 pages per transceive
+ * if that is not possible (the stream needs a 400 kHz bus). If the PICC answers NAK (Ultralight, Ultralight C), it is woken and
+ * selected again and the rest is read with READ, 4 pages per transceive.
+ *
+ * @return STATUS_OK on success, STATUS_INVALID for PICCs that are not page based, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Ultralight_ReadPages(	byte startPage,		///< First page to read
+											byte pageCount,		///< Number of pages to read
+											byte *buffer,		///< Receives pageCount * 4 bytes
+											byte bufferSize		///< Size of buffer
+										) {
+	if (buffer == NULL || (uint16_t)pageCount * 4 > bufferSize) {
+		return STATUS_NO_ROOM;
+	}
+	if (PICC_GetType(uid.sak) != PICC_TYPE_MIFARE_UL) {
+		return STATUS_INVALID;						// MIFARE Classic has 16 byte blocks, see MIFARE_ReadBlocks()
+	}
+
+	byte result = STATUS_OK;
+	byte chunk[FAST_READ_MAX_PAGES * 4 + 2];		// Pages + CRC_A
+	byte done = 0;
+	bool fastRead = true;
+
+	// Too big for the FIFO: stream the whole range in one exchange.
+	if (pageCount > FAST_READ_MAX_PAGES) {
+		FastReadStream stream = { { PICC_CMD_NTAG_FAST_READ, startPage, (byte)(startPage + pageCount - 1) }, false, buffer, (uint16_t)(4 * pageCount), 0 };
+		result = PCD_TransceiveStream(FastReadSource, FastReadSink, &stream);
+		if (result == STATUS_OK && stream.received == stream.size + 2) {
+			return STATUS_OK;
+		}
+		// A NAK or silence means no FAST_READ at all. Otherwise the bus was too slow: use FIFO sized chunks.
+		fastRead = (result != STATUS_MIFARE_NACK && result != STATUS_TIMEOUT);
+	}
+
+	while (fastRead && done < pageCount) {
+		byte pages = pageCount - done;
+		if (pages > FAST_READ_MAX_PAGES) {
+			pages = FAST_READ_MAX_PAGES;
+		}
+		byte chunkSize = sizeof(chunk);
+		result = MIFARE_Ultralight_FastRead(startPage + done, startPage + done + pages - 1, chunk, &chunkSize);
+		if (result != STATUS_OK) {
+			break;
+		}
+		memcpy(&buffer[4 * done], chunk, 4 * pages);
+		done += pages;
+	}
+	if (done == pageCount) {
+		return STATUS_OK;
+	}
+	if (result != STATUS_MIFARE_NACK && result != STATUS_TIMEOUT) {
+		return result;
+	}
+
+	// No FAST_READ on this PICC. The NAK put it back to IDLE/HALT: wake it and select it again by its UID.
+	byte bufferATQA[2];
+	byte atqaSize = sizeof(bufferATQA);
+	result = PICC_WakeupA(bufferATQA, &atqaSize);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	result = PICC_Select(&uid, uid.size * 8);
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// READ returns 4 pages (16 bytes) + CRC_A per transceive.
+	while (done < pageCount) {
+		byte pages = pageCount - done;
+		if (pages > 4) {
+			pages = 4;
+		}
+		byte chunkSize = sizeof(chunk);
+		result = MIFARE_Read(startPage + done, chunk, &chunkSize);
+		if (result != STATUS_OK) {
+			return result;
+		}
+		memcpy(&buffer[4 * done], chunk, 4 * pages);
+		done += pages;
+	}
+	return STATUS_OK;
+} // End MIFARE_Ultralight_ReadPages()
+#endif // MFRC522_FEATURE_READ
+
+#if MFRC522_FEATURE_VALUE_BLOCKS
+/**
+ * MIFARE Decrement subtracts the delta from the value of the addressed block, and stores the result in a volatile memory.
+ * For MIFARE Classic only. The sector containing the block must be authenticated before calling this function.
+ * Only for blocks in "value block" mode, ie with access bits [C1 C2 C3] = [110] or [001].
+ * Use MIFARE_Transfer() to store the result in a block.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Decrement(	byte blockAddr, ///< The block (0-0xff) number.
+								long delta		///< This number is subtracted from the value of block blockAddr.
+							) {
+	return MIFARE_TwoStepHelper(PICC_CMD_MF_DECREMENT, blockAddr, delta);
+} // End MIFARE_Decrement()
+
+/**
+ * MIFARE Increment adds the delta to the value of the addressed block, and stores the result in a volatile memory.
+ * For MIFARE Classic only. The sector containing the block must be authenticated before calling this function.
+ * Only for blocks in "value block" mode, ie with access bits [C1 C2 C3] = [110] or [001].
+ * Use MIFARE_Transfer() to store the result in a block.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Increment(	byte blockAddr, ///< The block (0-0xff) number.
+								long delta		///< This number is added to the value of block blockAddr.
+							) {
+	return MIFARE_TwoStepHelper(PICC_CMD_MF_INCREMENT, blockAddr, delta);
+} // End MIFARE_Increment()
+
+/**
+ * MIFARE Restore copies the value of the addressed block into a volatile memory.
+ * For MIFARE Classic only. The sector containing the block must be authenticated before calling this function.
+ * Only for blocks in "value block" mode, ie with access bits [C1 C2 C3] = [110] or [001].
+ * Use MIFARE_Transfer() to store the result in a block.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Restore(	byte blockAddr ///< The block (0-0xff) number.
+							) {
+	// The datasheet describes Restore as a two step operation, but does not explain what data to transfer in step 2.
+	// Doing only a single step does not work, so I chose to transfer 0L in step two.
+	return MIFARE_TwoStepHelper(PICC_CMD_MF_RESTORE, blockAddr, 0L);
+} // End MIFARE_Restore()
+
+/**
+ * Helper function for the two-step MIFARE Classic protocol operations Decrement, Increment and Restore.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_TwoStepHelper(	byte command,	///< The command to use
+									byte blockAddr,	///< The block (0-0xff) number.
+									long data		///< The data to transfer in step 2
+									) {
+	byte result;
+	byte cmdBuffer[2]; // We only need room for 2 bytes.
+
+	// Step 1: Tell the PICC the command and block address
+	cmdBuffer[0] = command;
+	cmdBuffer[1] = blockAddr;
+	result = PCD_MIFARE_Transceive(	cmdBuffer, 2); // Adds CRC_A and checks that the response is MF_ACK.
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	// Step 2: Transfer the data
+	result = PCD_MIFARE_Transceive(	(byte *)&data, 4, true); // Adds CRC_A and accept timeout as success.
+	if (result != STATUS_OK) {
+		return result;
+	}
+
+	return STATUS_OK;
+} // End MIFARE_TwoStepHelper()
+
+/**
+ * MIFARE Transfer writes the value stored in the volatile memory into one MIFARE Classic block.
+ * For MIFARE Classic only. The sector containing the block must be authenticated before calling this function.
+ * Only for blocks in "value block" mode, ie with access bits [C1 C2 C3] = [110] or [001].
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_Transfer(	byte blockAddr ///< The block (0-0xff) number.
+							) {
+	byte result;
+	byte cmdBuffer[2]; // We only need room for 2 bytes.
+
+	// Tell the PICC we want to transfer the result into block blockAddr.
+	cmdBuffer[0] = PICC_CMD_MF_TRANSFER;
+	cmdBuffer[1] = blockAddr;
+	result = PCD_MIFARE_Transceive(	cmdBuffer, 2); // Adds CRC_A and checks that the response is MF_ACK.
+	if (result != STATUS_OK) {
+		return result;
+	}
+	return STATUS_OK;
+} // End MIFARE_Transfer()
+
+/**
+ * Helper routine to read the current value from a Value Block.
+ *
+ * Only for MIFARE Classic and only for blocks in "value block" mode, that
+ * is: with access bits [C1 C2 C3] = [110] or [001]. The sector containing
+ * the block must be authenticated before calling this function.
+ *
+ * @param[in]   blockAddr   The block (0x00-0xff) number.
+ * @param[out]  value       Current value of the Value Block.
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+  */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_GetValue(byte blockAddr, long *value) {
+	byte status;
+	byte buffer[18];
+	byte size = sizeof(buffer);
+
+	// Read the block
+	status = MIFARE_Read(blockAddr, buffer, &size);
+	if (status == STATUS_OK) {
+		// Extract the value
+		*value = (long(buffer[3])<<24) | (long(buffer[2])<<16) | (long(buffer[1])<<8) | long(buffer[0]);
+	}
+	return status;
+} // End MIFARE_GetValue()
+
+/**
+ * Helper routine to write a specific value into a Value Block.
+ *
+ * Only for MIFARE Classic and only for blocks in "value block" mode, that
+ * is: with access bits [C1 C2 C3] = [110] or [001]. The sector containing
+ * the block must be authenticated before calling this function.
+ *
+ * @param[in]   blockAddr   The block (0x00-0xff) number.
+ * @param[in]   value       New value of the Value Block.
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_SetValue(byte blockAddr, long value) {
+	byte buffer[18];
+
+	// Translate the long into 4 bytes; repeated 2x in value block
+	buffer[0] = buffer[ 8] = (value & 0xFF);
+	buffer[1] = buffer[ 9] = (value & 0xFF00) >> 8;
+	buffer[2] = buffer[10] = (value & 0xFF0000) >> 16;
+	buffer[3] = buffer[11] = (value & 0xFF000000) >> 24;
+	// Inverse 4 bytes also found in value block
+	buffer[4] = ~buffer[0];
+	buffer[5] = ~buffer[1];
+	buffer[6] = ~buffer[2];
+	buffer[7] = ~buffer[3];
+	// Address 2x with inverse address 2x
+	buffer[12] = buffer[14] = blockAddr;
+	buffer[13] = buffer[15] = ~blockAddr;
+
+	// Write the whole data block
+	return MIFARE_Write(blockAddr, buffer, 16);
+} // End MIFARE_SetValue()
+#endif // MFRC522_FEATURE_VALUE_BLOCKS
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Support functions
+/////////////////////////////////////////////////////////////////////////////////////
+
+#if MFRC522_FEATURE_READ
+/**
+ * Wrapper for MIFARE protocol communication.
+ * Adds CRC_A, executes the Transceive command and checks that the response is MF_ACK or a timeout.
+ *
+ * @return STATUS_OK on success, STATUS_??? otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_MIFARE_Transceive(	byte *sendData,		///< Pointer to the data to transfer to the FIFO. Do NOT include the CRC_A.
+										byte sendLen,		///< Number of bytes in sendData.
+										bool acceptTimeout	///< True => A timeout is also success
+									) {
+	byte result;
+	byte cmdBuffer[18]; // We need room for 16 bytes data and 2 bytes CRC_A.
+
+	// Sanity check
+	if (sendData == NULL || sendLen > 16) {
+		return STATUS_INVALID;
+	}
+
+	// Copy sendData[] to cmdBuffer[] and add CRC_A
+	memcpy(cmdBuffer, sendData, sendLen);
+	result = PCD_CRC_A(cmdBuffer, sendLen, &cmdBuffer[sendLen]);
+	if (result != STATUS_OK) {
+		return result;
+	}
+	sendLen += 2;
+
+	// Transceive the data, store the reply in cmdBuffer[]
+	byte waitIRq = 0x30;		// RxIRq and IdleIRq
+	byte cmdBufferSize = sizeof(cmdBuffer);
+	byte validBits = 0;
+	PCD_UseTiming(_timing.transfer);
+	result = PCD_CommunicateWithPICC(PCD_Transceive, waitIRq, cmdBuffer, sendLen, cmdBuffer, &cmdBufferSize, &validBits);
+	if (acceptTimeout && result == STATUS_TIMEOUT) {
+		return STATUS_OK;
+	}
+	if (result != STATUS_OK) {
+		return result;
+	}
+	// The PICC must reply with a 4 bit ACK
+	if (cmdBufferSize != 1 || validBits != 4) {
+		return STATUS_ERROR;
+	}
+	if (cmdBuffer[0] != MF_ACK) {
+		return STATUS_MIFARE_NACK;
+	}
+	return STATUS_OK;
+} // End PCD_MIFARE_Transceive()
+#endif // MFRC522_FEATURE_READ
+
+#if MFRC522_FEATURE_DUMP
+/**
+ * Dumps debug info about the connected PCD to Serial.
+ * Shows all known firmware versions
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PCD_DumpVersionToSerial() {
+	// Get the MFRC522 firmware version
+	byte v = PCD_ReadRegister(VersionReg);
+	Serial.print(F("Firmware Version: 0x"));
+	Serial.print(v, HEX);
+	// Lookup which version
+	switch(v) {
+		case 0x88: Serial.println(F(" = (clone)"));  break;
+		case 0x90: Serial.println(F(" = v0.0"));     break;
+		case 0x91: Serial.println(F(" = v1.0"));     break;
+		case 0x92: Serial.println(F(" = v2.0"));     break;
+		case 0x12: Serial.println(F(" = counterfeit chip"));     break;
+		default:   Serial.println(F(" = (unknown)"));
+	}
+	// When 0x00 or 0xFF is returned, communication probably failed
+	if ((v == 0x00) || (v == 0xFF))
+		Serial.println(F("WARNING: Communication failure, is the MFRC522 properly connected?"));
+} // End PCD_DumpVersionToSerial()
+
+/**
+ * Dumps debug info about the selected PICC to Serial.
+ * On success the PICC is halted after dumping the data.
+ * For MIFARE Classic the factory default key of 0xFFFFFFFFFFFF is tried.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_DumpToSerial(Uid *uid	///< Pointer to Uid struct returned from a successful PICC_Select().
+								) {
+	MIFARE_Key key;
+
+	// UID
+	Serial.print(F("Card UID:"));
+	for (byte i = 0; i < uid->size; i++) {
+		if(uid->uidByte[i] < 0x10)
+			Serial.print(F(" 0"));
+		else
+			Serial.print(F(" "));
+		Serial.print(uid->uidByte[i], HEX);
+	}
+	Serial.println();
+
+	// PICC type
+	byte piccType = PICC_GetType(uid->sak);
+	Serial.print(F("PICC type: "));
+	Serial.println(PICC_GetTypeName(piccType));
+
+	// Dump contents
+	switch (piccType) {
+		case PICC_TYPE_MIFARE_MINI:
+		case PICC_TYPE_MIFARE_1K:
+		case PICC_TYPE_MIFARE_4K:
+			// All keys are set to FFFFFFFFFFFFh at chip delivery from the factory.
+			for (byte i = 0; i < 6; i++) {
+				key.keyByte[i] = 0xFF;
+			}
+			PICC_DumpMifareClassicToSerial(uid, piccType, &key);
+			break;
+
+		case PICC_TYPE_MIFARE_UL:
+			PICC_DumpMifareUltralightToSerial();
+			break;
+
+		case PICC_TYPE_ISO_14443_4:
+		case PICC_TYPE_ISO_18092:
+		case PICC_TYPE_MIFARE_PLUS:
+		case PICC_TYPE_TNP3XXX:
+			Serial.println(F("Dumping memory contents not implemented for that PICC type."));
+			break;
+
+		case PICC_TYPE_UNKNOWN:
+		case PICC_TYPE_NOT_COMPLETE:
+		default:
+			break; // No memory dump here
+	}
+
+	Serial.println();
+	PICC_HaltA(); // Already done if it was a MIFARE Classic PICC.
+} // End PICC_DumpToSerial()
+
+/**
+ * Dumps memory contents of a MIFARE Classic PICC.
+ * On success the PICC is halted after dumping the data.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_DumpMifareClassicToSerial(	Uid *uid,		///< Pointer to Uid struct returned from a successful PICC_Select().
+												byte piccType,	///< One of the PICC_Type enums.
+												MIFARE_Key *key	///< Key A used for all sectors.
+											) {
+	byte no_of_sectors = 0;
+	switch (piccType) {
+		case PICC_TYPE_MIFARE_MINI:
+			// Has 5 sectors * 4 blocks/sector * 16 bytes/block = 320 bytes.
+			no_of_sectors = 5;
+			break;
+
+		case PICC_TYPE_MIFARE_1K:
+			// Has 16 sectors * 4 blocks/sector * 16 bytes/block = 1024 bytes.
+			no_of_sectors = 16;
+			break;
+
+		case PICC_TYPE_MIFARE_4K:
+			// Has (32 sectors * 4 blocks/sector + 8 sectors * 16 blocks/sector) * 16 bytes/block = 4096 bytes.
+			no_of_sectors = 40;
+			break;
+
+		default: // Should not happen. Ignore.
+			break;
+	}
+
+	// Dump sectors, highest address first.
+	if (no_of_sectors) {
+		Serial.println(F("Sector Block   0  1  2  3   4  5  6  7   8  9 10 11  12 13 14 15  AccessBits"));
+		for (int8_t i = no_of_sectors - 1; i >= 0; i--) {
+			PICC_DumpMifareClassicSectorToSerial(uid, key, i);
+		}
+	}
+	PICC_HaltA(); // Halt the PICC before stopping the encrypted session.
+	PCD_StopCrypto1();
+} // End PICC_DumpMifareClassicToSerial()
+
+/**
+ * Dumps memory contents of a sector of a MIFARE Classic PICC.
+ * Uses PCD_Authenticate(), MIFARE_Read() and PCD_StopCrypto1.
+ * Always uses PICC_CMD_MF_AUTH_KEY_A because only Key A can always read the sector trailer access bits.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_DumpMifareClassicSectorToSerial(Uid *uid,			///< Pointer to Uid struct returned from a successful PICC_Select().
+													MIFARE_Key *key,	///< Key A for the sector.
+													byte sector			///< The sector to dump, 0..39.
+													) {
+	byte status;
+	byte firstBlock;		// Address of lowest address to dump actually last block dumped)
+	byte no_of_blocks;		// Number of blocks in sector
+	bool isSectorTrailer;	// Set to true while handling the "last" (ie highest address) in the sector.
+
+	// The access bits are stored in a peculiar fashion.
+	// There are four groups:
+	//		g[3]	Access bits for the sector trailer, block 3 (for sectors 0-31) or block 15 (for sectors 32-39)
+	//		g[2]	Access bits for block 2 (for sectors 0-31) or blocks 10-14 (for sectors 32-39)
+	//		g[1]	Access bits for block 1 (for sectors 0-31) or blocks 5-9 (for sectors 32-39)
+	//		g[0]	Access bits for block 0 (for sectors 0-31) or blocks 0-4 (for sectors 32-39)
+	// Each group has access bits [C1 C2 C3]. In this code C1 is MSB and C3 is LSB.
+	// The four CX bits are stored together in a nible cx and an inverted nible cx_.
+	byte c1, c2, c3;		// Nibbles
+	byte c1_, c2_, c3_;		// Inverted nibbles
+	bool invertedError;		// True if one of the inverted nibbles did not match
+	byte g[4];				// Access bits for each of the four groups.
+	byte group;				// 0-3 - active group for access bits
+	bool firstInGroup;		// True for the first block dumped in the group
+
+	// Determine position and size of sector.
+	if (sector < 32) { // Sectors 0..31 has 4 blocks each
+		no_of_blocks = 4;
+		firstBlock = sector * no_of_blocks;
+	}
+	else if (sector < 40) { // Sectors 32-39 has 16 blocks each
+		no_of_blocks = 16;
+		firstBlock = 128 + (sector - 32) * no_of_blocks;
+	}
+	else { // Illegal input, no MIFARE Classic PICC has more than 40 sectors.
+		return;
+	}
+
+	// Dump blocks, highest address first.
+	byte byteCount;
+	byte buffer[18];
+	byte blockAddr;
+	isSectorTrailer = true;
+	for (int8_t blockOffset = no_of_blocks - 1; blockOffset >= 0; blockOffset--) {
+		blockAddr = firstBlock + blockOffset;
+		// Sector number - only on first line
+		if (isSectorTrailer) {
+			if(sector < 10)
+				Serial.print(F("   ")); // Pad with spaces
+			else
+				Serial.print(F("  ")); // Pad with spaces
+			Serial.print(sector);
+			Serial.print(F("   "));
+		}
+		else {
+			Serial.print(F("       "));
+		}
+		// Block number
+		if(blockAddr < 10)
+			Serial.print(F("   ")); // Pad with spaces
+		else {
+			if(blockAddr < 100)
+				Serial.print(F("  ")); // Pad with spaces
+			else
+				Serial.print(F(" ")); // Pad with spaces
+		}
+		Serial.print(blockAddr);
+		Serial.print(F("  "));
+		// Establish encrypted communications before reading the first block
+		if (isSectorTrailer) {
+			status = PCD_Authenticate(PICC_CMD_MF_AUTH_KEY_A, firstBlock, key, uid);
+			if (status != STATUS_OK) {
+				Serial.print(F("PCD_Authenticate() failed: "));
+				Serial.println(GetStatusCodeName(status));
+				return;
+			}
+		}
+		// Read block
+		byteCount = sizeof(buffer);
+		status = MIFARE_Read(blockAddr, buffer, &byteCount);
+		if (status != STATUS_OK) {
+			Serial.print(F("MIFARE_Read() failed: "));
+			Serial.println(GetStatusCodeName(status));
+			continue;
+		}
+		// Dump data
+		for (byte index = 0; index < 16; index++) {
+			if(buffer[index] < 0x10)
+				Serial.print(F(" 0"));
+			else
+				Serial.print(F(" "));
+			Serial.print(buffer[index], HEX);
+			if ((index % 4) == 3) {
+				Serial.print(F(" "));
+			}
+		}
+		// Parse sector trailer data
+		if (isSectorTrailer) {
+			c1  = buffer[7] >> 4;
+			c2  = buffer[8] & 0xF;
+			c3  = buffer[8] >> 4;
+			c1_ = buffer[6] & 0xF;
+			c2_ = buffer[6] >> 4;
+			c3_ = buffer[7] & 0xF;
+			invertedError = (c1 != (~c1_ & 0xF)) || (c2 != (~c2_ & 0xF)) || (c3 != (~c3_ & 0xF));
+			g[0] = ((c1 & 1) << 2) | ((c2 & 1) << 1) | ((c3 & 1) << 0);
+			g[1] = ((c1 & 2) << 1) | ((c2 & 2) << 0) | ((c3 & 2) >> 1);
+			g[2] = ((c1 & 4) << 0) | ((c2 & 4) >> 1) | ((c3 & 4) >> 2);
+			g[3] = ((c1 & 8) >> 1) | ((c2 & 8) >> 2) | ((c3 & 8) >> 3);
+			isSectorTrailer = false;
+		}
+
+		// Which access group is this block in?
+		if (no_of_blocks == 4) {
+			group = blockOffset;
+			firstInGroup = true;
+		}
+		else {
+			group = blockOffset / 5;
+			firstInGroup = (group == 3) || (group != (blockOffset + 1) / 5);
+		}
+
+		if (firstInGroup) {
+			// Print access bits
+			Serial.print(F(" [ "));
+			Serial.print((g[group] >> 2) & 1, DEC); Serial.print(F(" "));
+			Serial.print((g[group] >> 1) & 1, DEC); Serial.print(F(" "));
+			Serial.print((g[group] >> 0) & 1, DEC);
+			Serial.print(F(" ] "));
+			if (invertedError) {
+				Serial.print(F(" Inverted access bits did not match! "));
+			}
+		}
+
+		if (group != 3 && (g[group] == 1 || g[group] == 6)) { // Not a sector trailer, a value block
+			long value = (long(buffer[3])<<24) | (long(buffer[2])<<16) | (long(buffer[1])<<8) | long(buffer[0]);
+			Serial.print(F(" Value=0x")); Serial.print(value, HEX);
+			Serial.print(F(" Adr=0x")); Serial.print(buffer[12], HEX);
+		}
+		Serial.println();
+	}
+
+	return;
+} // End PICC_DumpMifareClassicSectorToSerial()
+
+/**
+ * Dumps memory contents of a MIFARE Ultralight PICC.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_DumpMifareUltralightToSerial() {
+	byte status;
+	byte byteCount;
+	byte buffer[18];
+	byte i;
+
+	Serial.println(F("Page  0  1  2  3"));
+	// Try the mpages of the original Ultralight. Ultralight C has more pages.
+	for (byte page = 0; page < 16; page +=4) { // Read returns data for 4 pages at a time.
+		// Read pages
+		byteCount = sizeof(buffer);
+		status = MIFARE_Read(page, buffer, &byteCount);
+		if (status != STATUS_OK) {
+			Serial.print(F("MIFARE_Read() failed: "));
+			Serial.println(GetStatusCodeName(status));
+			break;
+		}
+		// Dump data
+		for (byte offset = 0; offset < 4; offset++) {
+			i = page + offset;
+			if(i < 10)
+				Serial.print(F("  ")); // Pad with spaces
+			else
+				Serial.print(F(" ")); // Pad with spaces
+			Serial.print(i);
+			Serial.print(F("  "));
+			for (byte index = 0; index < 4; index++) {
+				i = 4 * offset + index;
+				if(buffer[i] < 0x10)
+					Serial.print(F(" 0"));
+				else
+					Serial.print(F(" "));
+				Serial.print(buffer[i], HEX);
+			}
+			Serial.println();
+		}
+	}
+} // End PICC_DumpMifareUltralightToSerial()
+#endif // MFRC522_FEATURE_DUMP
+
+#if MFRC522_FEATURE_UID_BACKDOOR
+/**
+ * Performs the "magic sequence" needed to get Chinese UID changeable
+ * Mifare cards to allow writing to sector 0, where the card UID is stored.
+ *
+ * Note that you do not need to have selected the card through REQA or WUPA,
+ * this sequence works immediately when the card is in the reader vicinity.
+ * This means you can use this method even on "bricked" cards that your reader does
+ * not recognise anymore (see MFRC522_I2C::MIFARE_UnbrickUidSector).
+ *
+ * Of course with non-bricked devices, you're free to select them before calling this function.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_OpenUidBackdoor(bool logErrors) {
+	// Magic sequence:
+	// > 50 00 57 CD (HALT + CRC)
+	// > 40 (7 bits only)
+	// < A (4 bits only)
+	// > 43
+	// < A (4 bits only)
+	// Then you can write to sector 0 without authenticating
+
+	PICC_HaltA(); // 50 00 57 CD
+	PCD_UseTiming(_timing.transfer);
+
+	byte cmd = 0x40;
+	byte validBits = 7; /* Our command is only 7 bits. After receiving card response,
+						  this will contain amount of valid response bits. */
+	byte response[32]; // Card's response is written here
+	byte received;
+	byte status = PCD_TransceiveData(&cmd, (byte)1, response, &received, &validBits, (byte)0, false); // 40
+	if(status != STATUS_OK) {
+		if(logErrors) {
+			Serial.println(F("Card did not respond to 0x40 after HALT command. Are you sure it is a UID changeable one?"));
+			Serial.print(F("Error name: "));
+			Serial.println(GetStatusCodeName(status));
+		}
+		return false;
+	}
+	if (received != 1 || response[0] != 0x0A) {
+		if (logErrors) {
+			Serial.print(F("Got bad response on backdoor 0x40 command: "));
+			Serial.print(response[0], HEX);
+			Serial.print(F(" ("));
+			Serial.print(validBits);
+			Serial.print(F(" valid bits)\r\n"));
+		}
+		return false;
+	}
+
+	cmd = 0x43;
+	validBits = 8;
+	status = PCD_TransceiveData(&cmd, (byte)1, response, &received, &validBits, (byte)0, false); // 43
+	if(status != STATUS_OK) {
+		if(logErrors) {
+			Serial.println(F("Error in communication at command 0x43, after successfully executing 0x40"));
+			Serial.print(F("Error name: "));
+			Serial.println(GetStatusCodeName(status));
+		}
+		return false;
+	}
+	if (received != 1 || response[0] != 0x0A) {
+		if (logErrors) {
+			Serial.print(F("Got bad response on backdoor 0x43 command: "));
+			Serial.print(response[0], HEX);
+			Serial.print(F(" ("));
+			Serial.print(validBits);
+			Serial.print(F(" valid bits)\r\n"));
+		}
+		return false;
+	}
+
+	// You can now write to sector 0 without authenticating!
+	return true;
+} // End MIFARE_OpenUidBackdoor()
+
+/**
+ * Reads entire block 0, including all manufacturer data, and overwrites
+ * that block with the new UID, a freshly calculated BCC, and the original
+ * manufacturer data.
+ *
+ * It assumes a default KEY A of 0xFFFFFFFFFFFF.
+ * Make sure to have selected the card before this function is called.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_SetUid(byte *newUid, byte uidSize, bool logErrors) {
+
+	// UID + BCC byte can not be larger than 16 together
+	if (!newUid || !uidSize || uidSize > 15) {
+		if (logErrors) {
+			Serial.println(F("New UID buffer empty, size 0, or size > 15 given"));
+		}
+		return false;
+	}
+
+	// Authenticate for reading
+	MIFARE_Key key = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	byte status = PCD_Authenticate(PICC_CMD_MF_AUTH_KEY_A, (byte)1, &key, &uid);
+	if (status != STATUS_OK) {
+
+		if (status == STATUS_TIMEOUT) {
+			// We get a read timeout if no card is selected yet, so let's select one
+
+			// Wake the card up again if sleeping
+//			  byte atqa_answer[2];
+//			  byte atqa_size = 2;
+//			  PICC_WakeupA(atqa_answer, &atqa_size);
+
+			if (!PICC_IsNewCardPresent() || !PICC_ReadCardSerial()) {
+				Serial.println(F("No card was previously selected, and none are available. Failed to set UID."));
+				return false;
+			}
+
+			status = PCD_Authenticate(PICC_CMD_MF_AUTH_KEY_A, (byte)1, &key, &uid);
+			if (status != STATUS_OK) {
+				// We tried, time to give up
+				if (logErrors) {
+					Serial.println(F("Failed to authenticate to card for reading, could not set UID: "));
+					Serial.println(GetStatusCodeName(status));
+				}
+				return false;
+			}
+		}
+		else {
+			if (logErrors) {
+				Serial.print(F("PCD_Authenticate() failed: "));
+				Serial.println(GetStatusCodeName(status));
+			}
+			return false;
+		}
+	}
+
+	// Read block 0
+	byte block0_buffer[18];
+	byte byteCount = sizeof(block0_buffer);
+	status = MIFARE_Read((byte)0, block0_buffer, &byteCount);
+	if (status != STATUS_OK) {
+		if (logErrors) {
+			Serial.print(F("MIFARE_Read() failed: "));
+			Serial.println(GetStatusCodeName(status));
+			Serial.println(F("Are you sure your KEY A for sector 0 is 0xFFFFFFFFFFFF?"));
+		}
+		return false;
+	}
+
+	// Write new UID to the data we just read, and calculate BCC byte
+	byte bcc = 0;
+	for (int i = 0; i < uidSize; i++) {
+		block0_buffer[i] = newUid[i];
+		bcc ^= newUid[i];
+	}
+
+	// Write BCC byte to buffer
+	block0_buffer[uidSize] = bcc;
+
+	// Stop encrypted traffic so we can send raw bytes
+	PCD_StopCrypto1();
+
+	// Activate UID backdoor
+	if (!MIFARE_OpenUidBackdoor(logErrors)) {
+		if (logErrors) {
+			Serial.println(F("Activating the UID backdoor failed."));
+		}
+		return false;
+	}
+
+	// Write modified block 0 back to card
+	status = MIFARE_Write((byte)0, block0_buffer, (byte)16);
+	if (status != STATUS_OK) {
+		if (logErrors) {
+			Serial.print(F("MIFARE_Write() failed: "));
+			Serial.println(GetStatusCodeName(status));
+		}
+		return false;
+	}
+
+	// Wake the card up again
+	byte atqa_answer[2];
+	byte atqa_size = 2;
+	PICC_WakeupA(atqa_answer, &atqa_size);
+
+	return true;
+}
+
+/**
+ * Resets entire sector 0 to zeroes, so the card can be read again by readers.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::MIFARE_UnbrickUidSector(bool logErrors) {
+	MIFARE_OpenUidBackdoor(logErrors);
+
+	byte block0_buffer[] = {0x01, 0x02, 0x03, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+	// Write modified block 0 back to card
+	byte status = MIFARE_Write((byte)0, block0_buffer, (byte)16);
+	if (status != STATUS_OK) {
+		if (logErrors) {
+			Serial.print(F("MIFARE_Write() failed: "));
+			Serial.println(GetStatusCodeName(status));
+		}
+		return false;
+	}
+	return true;
+}
+#endif // MFRC522_FEATURE_UID_BACKDOOR
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Convenience functions - does not add extra functionality
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Returns true if a PICC responds to PICC_CMD_REQA.
+ * Only "new" cards in state IDLE are invited. Sleeping cards in state HALT are ignored.
+ *
+ * @return bool
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_IsNewCardPresent() {
+#if MFRC522_FEATURE_STATS
+	PCD_CallTimer timer(&_stats.isNewCardPresent);
+#endif
+	byte bufferATQA[2];
+	byte bufferSize = sizeof(bufferATQA);
+	byte result = PICC_RequestA(bufferATQA, &bufferSize);
+	return (result == STATUS_OK || result == STATUS_COLLISION);
+} // End PICC_IsNewCardPresent()
+
+/**
+ * Simple wrapper around PICC_Select.
+ * Returns true if a UID could be read.
+ * Remember to call PICC_IsNewCardPresent(), PICC_RequestA() or PICC_WakeupA() first.
+ * The read UID is available in the class variable uid.
+ *
+ * @return bool
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_ReadCardSerial() {
+	byte result = PICC_Select(&uid);
+	return (result == STATUS_OK);
+} // End PICC_ReadCardSerial()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Multi-PICC inventory
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Enumerates the PICCs in the field: WUPA, then rounds of anticollision + SELECT + HLTA until no PICC answers REQA.
+ * A halted PICC ignores REQA, so each round the remaining PICCs resolve among themselves and a different one wins.
+ * The run stops when the field is empty, uids[] is full or budgetMs has passed, whichever comes first.
+ *
+ * On return every PICC found is in state HALT. Use PICC_WakeupA() + PICC_Select() with a known UID,
+ * or PICC_StartPresenceCheck(), to talk to one of them again. The uid member holds the last PICC found.
+ *
+ * @return STATUS_OK if the field was emptied or uids[] filled, STATUS_TIMEOUT if the budget ran out first, STATUS_??? otherwise.
+ * 		   *uidCount is valid in every case.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_Inventory(	Uid *uids,			///< Array that receives the UIDs found
+									byte maxUids,		///< Number of entries in uids[]
+									byte *uidCount,		///< Out: number of entries filled in
+									uint16_t budgetMs	///< Time allowed for the whole inventory
+								) {
+	byte bufferATQA[2];
+	byte bufferSize;
+	byte result;
+	byte command = PICC_CMD_WUPA;					// First round also wakes PICCs halted before the inventory started
+	uint32_t start = millis();
+
+	*uidCount = 0;
+	while (*uidCount < maxUids) {
+		if (millis() - start >= budgetMs) {
+			return STATUS_TIMEOUT;
+		}
+
+		bufferSize = sizeof(bufferATQA);
+		result = PICC_REQA_or_WUPA(command, bufferATQA, &bufferSize);
+		command = PICC_CMD_REQA;
+		if (result == STATUS_TIMEOUT) {				// Nobody left in state IDLE
+			return STATUS_OK;
+		}
+		if (result != STATUS_OK && result != STATUS_COLLISION) {
+			return result;
+		}
+
+		// A failed selection leaves the PICCs in IDLE; the next round simply tries again.
+		if (PICC_Select(&uid) != STATUS_OK) {
+			continue;
+		}
+		PICC_HaltA();
+
+		// A PICC that missed the HLTA is found again; list it once.
+		bool known = false;
+		for (byte i = 0; i < *uidCount; i++) {
+			if (uids[i].size == uid.size && memcmp(uids[i].uidByte, uid.uidByte, uid.size) == 0) {
+				known = true;
+				break;
+			}
+		}
+		if (!known) {
+			memcpy(&uids[(*uidCount)++], &uid, sizeof(Uid));
+		}
+	}
+	return STATUS_OK;
+} // End PICC_Inventory()
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Non-blocking card detection - same result as PICC_IsNewCardPresent() + PICC_ReadCardSerial()
+/////////////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Starts a non-blocking card detection: transmits REQA and returns immediately.
+ * Drive the detection with PICC_PollDetect() until it returns something other than DETECT_PENDING.
+ * Only "new" cards in state IDLE are invited, like PICC_IsNewCardPresent().
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_StartDetect() {
+	PICC_StartDetectRequest(PICC_CMD_REQA, false);
+} // End PICC_StartDetect()
+
+/**
+ * Starts a non-blocking presence check for a PICC whose UID is already known, typically one that was
+ * selected and halted earlier. Drive it with PICC_PollDetect() like PICC_StartDetect().
+ *
+ * WUPA is sent instead of REQA so a halted PICC answers too, and each cascade level is selected directly
+ * with the known UID bytes, skipping the ANTICOLLISION round trip. Only the PICC with that UID can answer
+ * the SELECT, so DETECT_CARD_READY means exactly this card is still in the field.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_StartPresenceCheck(const Uid *known) {
+	if (known != &uid) {
+		memcpy(&uid, known, sizeof(Uid));
+	}
+	PICC_StartDetectRequest(PICC_CMD_WUPA, uid.size == 4 || uid.size == 7 || uid.size == 10);
+} // End PICC_StartPresenceCheck()
+
+/**
+ * Transmits REQA or WUPA for PICC_PollDetect().
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_StartDetectRequest(	byte command,		///< PICC_CMD_REQA or PICC_CMD_WUPA
+											bool knownUid		///< true to select the UID in the uid member instead of running anticollision
+										) {
+	_detectKnownUid = knownUid;
+	_authSector = AUTH_SECTOR_NONE;					// REQA/WUPA + SELECT ends any Crypto1 session
+	PCD_SetBitRate(BITRATE_106);					// REQA/WUPA and anticollision always run at 106 kBd
+	_protocolActive = false;
+	PCD_ClearRegisterBitMask(CollReg, 0x80);		// ValuesAfterColl=1 => Bits received after collision are cleared.
+	PCD_UseTiming(_timing.request);
+	PCD_StartCommunicate(PCD_Transceive, 0x30, &command, 1, 7);	// Short frame, only 7 bits of the last (and only) byte.
+	_detectStep = DETECT_STEP_REQA;
+} // End PICC_StartDetectRequest()
+
+/**
+ * Starts the cascade level in _detectLevel: a SELECT with the known UID bytes when presence checking,
+ * an ANTICOLLISION otherwise.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_StartDetectLevel() {
+	if (!_detectKnownUid) {
+		PICC_StartDetectAnticollision();
+		return;
+	}
+
+	static const byte selCommands[3] = { PICC_CMD_SEL_CL1, PICC_CMD_SEL_CL2, PICC_CMD_SEL_CL3 };
+	byte uidIndex = 3 * (_detectLevel - 1);
+	bool useCascadeTag = (_detectLevel == 1 && uid.size > 4) || (_detectLevel == 2 && uid.size > 7);
+
+	_detectBuffer[0] = selCommands[_detectLevel - 1];
+	if (useCascadeTag) {
+		_detectBuffer[2] = PICC_CMD_CT;
+		memcpy(&_detectBuffer[3], &uid.uidByte[uidIndex], 3);
+	}
+	else {
+		memcpy(&_detectBuffer[2], &uid.uidByte[uidIndex], 4);
+	}
+	_detectBuffer[6] = _detectBuffer[2] ^ _detectBuffer[3] ^ _detectBuffer[4] ^ _detectBuffer[5];	// BCC
+	PCD_UseTiming(_timing.select);
+	if (!PICC_StartDetectSelect()) {
+		_detectStep = DETECT_STEP_IDLE;
+	}
+} // End PICC_StartDetectLevel()
+
+/**
+ * Sends SELECT for _detectLevel with the UID CLn + BCC already in _detectBuffer[2..6].
+ *
+ * @return false if the CRC_A could not be calculated.
+ */
+template <class TwoWireT, byte ChipAddress>
+bool MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_StartDetectSelect() {
+	_detectBuffer[1] = 0x70;						// NVB: Seven whole bytes, this is a SELECT
+	if (PCD_CRC_A(_detectBuffer, 7, &_detectBuffer[7]) != STATUS_OK) {
+		return false;
+	}
+	PCD_StartCommunicate(PCD_Transceive, 0x30, _detectBuffer, 9);
+	_detectStep = DETECT_STEP_SELECT;
+	return true;
+} // End PICC_StartDetectSelect()
+
+/**
+ * Sends ANTICOLLISION with no known UID bits for the cascade level in _detectLevel.
+ */
+template <class TwoWireT, byte ChipAddress>
+void MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_StartDetectAnticollision() {
+	static const byte selCommands[3] = { PICC_CMD_SEL_CL1, PICC_CMD_SEL_CL2, PICC_CMD_SEL_CL3 };
+
+	_detectBuffer[0] = selCommands[_detectLevel - 1];
+	_detectBuffer[1] = 0x20;						// NVB: SEL + NVB only
+	PCD_UseTiming(_timing.select);
+	PCD_StartCommunicate(PCD_Transceive, 0x30, _detectBuffer, 2);
+	_detectStep = DETECT_STEP_ANTICOLL;
+} // End PICC_StartDetectAnticollision()
+
+/**
+ * Advances the detection started by PICC_StartDetect() or PICC_StartPresenceCheck() by at most one step and returns.
+ * While the PICC has not answered, a call costs one ComIrqReg read (none in IRQ pin mode), so it is safe to call from a busy loop.
+ * When an answer is in, the response is collected and the next REQA/ANTICOLLISION/SELECT frame is started.
+ *
+ * On a bit collision (several PICCs in the field) the detection falls back to the blocking PICC_Select(), which resolves it.
+ *
+ * @return DETECT_PENDING, DETECT_CARD_READY (UID in the uid member) or DETECT_NO_CARD.
+ */
+template <class TwoWireT, byte ChipAddress>
+byte MFRC522_I2C_T<TwoWireT, ChipAddress>::PICC_PollDetect() {
+	if (_detectStep == DETECT_STEP_IDLE) {
+		return DETECT_NO_CARD;
+	}
+
+	byte result = PCD_PollCommunicate();
+	if (result == STATUS_PENDING) {
+		return DETECT_PENDING;
+	}
+	byte step = _detectStep;
+	_detectStep = DETECT_STEP_IDLE;
+	if (result != STATUS_OK) {						// Mostly STATUS_TIMEOUT: nobody there
+		return DETECT_NO_CARD;
+	}
+
+	byte response[5];
+	byte responseLength = sizeof(response);
+	byte validBits = 0;
+	result = PCD_FinishCommunicate(response, &responseLength, &validBits);
+
+	switch (step) {
+		case DETECT_STEP_REQA:
+			// Same acceptance as PICC_IsNewCardPresent(): a collision still means someone is there.
+			if (result == STATUS_OK && (responseLength != 2 || validBits != 0)) {	// ATQA must be exactly 16 bits.
+				return DETECT_NO_CARD;
+			}
+			if (result != STATUS_OK && result != STATUS_COLLISION) {
+				return DETECT_NO_CARD;
+			}
+			_detectLevel = 1;
+			PICC_StartDetectLevel();
+			return (_detectStep == DETECT_STEP_IDLE) ? DETECT_NO_CARD : DETECT_PENDING;
+
+		case DETECT_STEP_ANTICOLL:
+			if (result == STATUS_COLLISION && _detectLevel == 1) {
+				// More than one PICC answered. They are all still READY, let the full algorithm pick one.
+				return (PICC_Select(&uid) == STATUS_OK) ? DETECT_CARD_READY : DETECT_NO_CARD;
+			}
+			if (result != STATUS_OK || responseLength != 5 || validBits != 0) {
+				return DETECT_NO_CARD;
+			}
+			if ((response[0] ^ response[1] ^ response[2] ^ response[3]) != response[4]) {	// BCC
+				return DETECT_NO_CARD;
+			}
+			memcpy(&_detectBuffer[2], response, 5);
+			return PICC_StartDetectSelect() ? DETECT_PENDING : DETECT_NO_CARD;
+
+		case DETECT_STEP_SELECT: {
+			// SAK must be exactly 24 bits (1 byte + CRC_A).
+			if (result != STATUS_OK || responseLength != 3 || validBits != 0) {
+				return DETECT_NO_CARD;
+			}
+			byte crc[2];
+			if (PCD_CRC_A(response, 1, crc) != STATUS_OK || crc[0] != response[1] || crc[1] != response[2]) {
+				return DETECT_NO_CARD;
+			}
+
+			// Copy the UID bytes of this cascade level, skipping the Cascade Tag.
+			byte uidIndex = 3 * (_detectLevel - 1);
+			if (_detectBuffer[2] == PICC_CMD_CT) {
+				memcpy(&uid.uidByte[uidIndex], &_detectBuffer[3], 3);
+			}
+			else {
+				memcpy(&uid.uidByte[uidIndex], &_detectBuffer[2], 4);
+			}
+
+			if (response[0] & 0x04) {				// Cascade bit set - UID not complete yet
+				if (_detectLevel >= 3) {
+					return DETECT_NO_CARD;
+				}
+				_detectLevel++;
+				PICC_StartDetectLevel();
+				return (_detectStep == DETECT_STEP_IDLE) ? DETECT_NO_CARD : DETECT_PENDING;
+			}
+			uid.sak = response[0];
+			uid.size = 3 * _detectLevel + 1;
+			return DETECT_CARD_READY;
+		}
+
+		default:
+			return DETECT_NO_CARD;
+	}
+} // End PICC_PollDetect()
+
+#endif
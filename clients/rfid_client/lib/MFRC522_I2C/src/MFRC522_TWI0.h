@@ -0,0 +1,252 @@
+/*
+ * MFRC522_TWI0.h - I2C master on the TWI0 peripheral of the megaAVR 0-series (ATmega4809, Arduino Uno WiFi Rev2),
+ * for use as the bus of MFRC522_I2C_T:
+ *
+ * 		MFRC522_TWI0 twi;
+ * 		MFRC522_I2C_T<MFRC522_TWI0> mfrc522(0x28, resetPin, &twi);
+ *
+ * It has the TwoWire master functions the driver uses, written as inline functions on the TWI0 registers,
+ * so a register read compiles to a handful of register accesses instead of calls into the Wire library and its
+ * buffers. Writes go out byte by byte as they are made, reads are collected in a buffer of one FIFO.
+ * Polled, no interrupts. Do not mix with Wire on the same pins.
+ *
+ * The TWI0 registers are described in chapter 25 of the ATmega4809 datasheet.
+ * Released into the public domain.
+ */
+#ifndef MFRC522_TWI0_h
+#define MFRC522_TWI0_h
+
+#include <Arduino.h>
+#include <MFRC522_I2C.h>
+
+#if defined(TWI0) && defined(TWI_MCMD_gm)
+
+class MFRC522_TWI0 {
+public:
+	// Largest read: the whole FIFO of the MFRC522.
+	static const byte BUFFER_SIZE = MFRC522_I2C_Base::FIFO_SIZE;
+	// Status polls before a transfer is given up with error 5 (timeout), several ms at 16 MHz.
+	static const uint16_t TIMEOUT_POLLS = 20000;
+
+	MFRC522_TWI0();
+	void begin();
+	void end();
+	void setClock(uint32_t clockHz);
+	void beginTransmission(uint8_t address);
+	size_t write(uint8_t value);
+	uint8_t endTransmission(bool sendStop = true);
+	uint8_t requestFrom(uint8_t address, uint8_t quantity);
+	int available();
+	int read();
+
+private:
+	uint32_t _clock;					// Clock set by setClock(), applied again by begin()
+	uint8_t _error;						// endTransmission() code of the transfer in progress: 0 ok, 2 address NACK, 3 data NACK, 4 bus error, 5 timeout
+	uint8_t _rxLength;					// Bytes in _rxBuffer
+	uint8_t _rxIndex;					// Next byte returned by read()
+	uint8_t _rxBuffer[BUFFER_SIZE];
+	bool WaitFor(uint8_t flags);
+	void Stop();
+};
+
+/**
+ * Constructor. The peripheral is left alone until begin().
+ */
+inline MFRC522_TWI0::MFRC522_TWI0() {
+	_clock = 100000;
+	_error = 0;
+	_rxLength = 0;
+	_rxIndex = 0;
+} // End constructor
+
+/**
+ * Enables TWI0 as master at the clock set by setClock(), 100 kHz by default.
+ * Uses the default pin routing (PA2 = SDA, PA3 = SCL on the Uno WiFi Rev2); the pull-ups are expected on the board.
+ */
+inline void MFRC522_TWI0::begin() {
+	TWI0.MCTRLA = 0;
+	setClock(_clock);
+	TWI0.MCTRLA = TWI_ENABLE_bm;
+	TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;				// The bus state is unknown after enabling, assume idle
+} // End begin()
+
+/**
+ * Disables TWI0, the pins are released.
+ */
+inline void MFRC522_TWI0::end() {
+	TWI0.MCTRLA = 0;
+} // End end()
+
+/**
+ * Sets the SCL frequency. f_SCL = F_CPU / (10 + 2 * BAUD), the rise time neglected (datasheet 25.3.2.2.1).
+ * Above 400 kHz the Fast-mode Plus drivers are enabled.
+ */
+inline void MFRC522_TWI0::setClock(uint32_t clockHz	///< I2C clock in Hz, e.g. 100000 or 400000
+								) {
+	_clock = clockHz;
+	uint32_t divider = F_CPU / clockHz;
+	uint32_t baud = (divider > 10) ? (divider - 10) / 2 : 0;
+	byte enabled = TWI0.MCTRLA & TWI_ENABLE_bm;
+	TWI0.MCTRLA = 0;									// MBAUD must only be written while the master is disabled
+	if (clockHz > 400000) {
+		TWI0.CTRLA |= TWI_FMPEN_bm;
+	}
+	else {
+		TWI0.CTRLA &= ~TWI_FMPEN_bm;
+	}
+	TWI0.MBAUD = (baud > 0xFF) ? 0xFF : (byte)baud;
+	if (enabled) {
+		TWI0.MCTRLA = TWI_ENABLE_bm;
+		TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
+	}
+} // End setClock()
+
+/**
+ * Sends START and the address in write mode. Errors are kept for endTransmission().
+ */
+inline void MFRC522_TWI0::beginTransmission(uint8_t address	///< 7 bit I2C address
+											) {
+	_error = 0;
+	TWI0.MADDR = address << 1;
+	if (WaitFor(TWI_WIF_bm) && (TWI0.MSTATUS & TWI_RXACK_bm)) {
+		_error = 2;
+	}
+} // End beginTransmission()
+
+/**
+ * Sends one data byte. Does nothing once the transfer has failed.
+ *
+ * @return 1 if the byte was acknowledged, 0 otherwise.
+ */
+inline size_t MFRC522_TWI0::write(uint8_t value	///< The byte to send
+								) {
+	if (_error != 0) {
+		return 0;
+	}
+	TWI0.MDATA = value;
+	if (!WaitFor(TWI_WIF_bm)) {
+		return 0;
+	}
+	if (TWI0.MSTATUS & TWI_RXACK_bm) {
+		_error = 3;
+		return 0;
+	}
+	return 1;
+} // End write()
+
+/**
+ * Ends the write with STOP. Without sendStop the bus is kept for a repeated START, unless the transfer failed.
+ *
+ * @return 0 on success, 2 address NACK, 3 data NACK, 4 bus error or arbitration lost, 5 timeout. The TwoWire codes.
+ */
+inline uint8_t MFRC522_TWI0::endTransmission(bool sendStop	///< Release the bus
+											) {
+	if (sendStop || _error != 0) {
+		Stop();
+	}
+	return _error;
+} // End endTransmission()
+
+/**
+ * Reads quantity bytes into the receive buffer: START, address in read mode, ACK after every byte but the last, NACK and STOP.
+ *
+ * @return The number of bytes received. Less than quantity if the transfer failed.
+ */
+inline uint8_t MFRC522_TWI0::requestFrom(	uint8_t address,	///< 7 bit I2C address
+											uint8_t quantity	///< Bytes to read, at most BUFFER_SIZE
+										) {
+	_error = 0;
+	_rxLength = 0;
+	_rxIndex = 0;
+	if (quantity > BUFFER_SIZE) {
+		quantity = BUFFER_SIZE;
+	}
+	if (quantity == 0) {
+		return 0;
+	}
+	TWI0.MADDR = (address << 1) | 0x01;
+	while (WaitFor(TWI_RIF_bm | TWI_WIF_bm)) {
+		if (TWI0.MSTATUS & TWI_WIF_bm) {				// Address not acknowledged, nothing to read
+			_error = 2;
+			break;
+		}
+		_rxBuffer[_rxLength++] = TWI0.MDATA;
+		if (_rxLength == quantity) {
+			break;
+		}
+		TWI0.MCTRLB = TWI_MCMD_RECVTRANS_gc;			// ACK and clock in the next byte
+	}
+	Stop();
+	return _rxLength;
+} // End requestFrom()
+
+/**
+ * @return The number of received bytes not read yet.
+ */
+inline int MFRC522_TWI0::available() {
+	return _rxLength - _rxIndex;
+} // End available()
+
+/**
+ * @return The next received byte, -1 if there is none.
+ */
+inline int MFRC522_TWI0::read() {
+	if (_rxIndex >= _rxLength) {
+		return -1;
+	}
+	return _rxBuffer[_rxIndex++];
+} // End read()
+
+/**
+ * Waits until one of flags is set in MSTATUS, for at most TIMEOUT_POLLS polls.
+ *
+ * @return true if a flag was set, false on bus error, lost arbitration or timeout (recorded in _error).
+ */
+inline bool MFRC522_TWI0::WaitFor(uint8_t flags	///< TWI_RIF_bm and/or TWI_WIF_bm
+								) {
+	for (uint16_t polls = 0; polls < TIMEOUT_POLLS; polls++) {
+		byte status = TWI0.MSTATUS;
+		if (status & (TWI_ARBLOST_bm | TWI_BUSERR_bm)) {
+			_error = 4;
+			return false;
+		}
+		if (status & flags) {
+			return true;
+		}
+	}
+	_error = 5;
+	return false;
+} // End WaitFor()
+
+/**
+ * Ends the transfer: NACK (for reads) and STOP. After a bus error or timeout the master no longer owns the bus,
+ * so the flags are cleared and the bus state forced to idle instead.
+ */
+inline void MFRC522_TWI0::Stop() {
+	if (_error >= 4) {
+		TWI0.MSTATUS = TWI_ARBLOST_bm | TWI_BUSERR_bm | TWI_BUSSTATE_IDLE_gc;
+	}
+	else {
+		TWI0.MCTRLB = TWI_ACKACT_bm | TWI_MCMD_STOP_gc;
+	}
+} // End Stop()
+
+/**
+ * PCD_RecoverBus() drives the TWI0 pins, which are the Wire pins.
+ */
+inline void MFRC522_I2C_DefaultRecoveryPins(	MFRC522_TWI0 *,		///< The bus passed to the constructor, unused: there is only one TWI0
+												byte *sdaPin,		///< Out: Arduino pin of SDA
+												byte *sclPin		///< Out: Arduino pin of SCL
+											) {
+#if defined(PIN_WIRE_SDA) && defined(PIN_WIRE_SCL)
+	*sdaPin = PIN_WIRE_SDA;
+	*sclPin = PIN_WIRE_SCL;
+#else
+	*sdaPin = MFRC522_I2C_Base::PIN_NONE;
+	*sclPin = MFRC522_I2C_Base::PIN_NONE;
+#endif
+} // End MFRC522_I2C_DefaultRecoveryPins()
+
+#endif // TWI0
+
+#endif
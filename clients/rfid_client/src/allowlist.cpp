@@ -0,0 +1,120 @@
+#include <EEPROM.h>
+
+#include "allowlist.h"
+
+// Constructor - no filter, every card might be allowed
+Allowlist::Allowlist()
+    : _length(0), _hashes(0)
+{
+  memset(_bits, 0, sizeof(_bits));
+}
+
+// Check the header and size, then take over the bit array
+bool Allowlist::load(const uint8_t *payload, uint16_t length)
+{
+  if (length == 0)
+  {
+    clear();
+    return true;
+  }
+  if (length <= HEADER_SIZE || length - HEADER_SIZE > ALLOWLIST_MAX_BYTES)
+    return false;
+  if (payload[0] != FORMAT || payload[1] == 0 || payload[1] > MAX_HASHES)
+    return false;
+
+  _hashes = payload[1];
+  _length = length - HEADER_SIZE;
+  memcpy(_bits, payload + HEADER_SIZE, _length);
+  return true;
+}
+
+// Remove the filter
+void Allowlist::clear()
+{
+  _length = 0;
+  _hashes = 0;
+}
+
+// True once a filter was loaded
+bool Allowlist::active() const
+{
+  return _length != 0;
+}
+
+// Test the k bits of the UID; one clear bit rules the card out
+bool Allowlist::mightContain(const char *uid) const
+{
+  if (!active())
+    return true;
+
+  // FNV-1a over the UID text
+  uint32_t hash = 2166136261UL;
+  for (const char *c = uid; *c != '\0'; c++)
+  {
+    hash ^= (uint8_t)*c;
+    hash *= 16777619UL;
+  }
+
+  // Double hashing: the k positions step through the filter by h2 from h1
+  const uint16_t m = bits();
+  const uint16_t h2 = (uint16_t)(hash >> 16) | 1;
+  uint32_t position = (uint16_t)hash;
+  for (uint8_t i = 0; i < _hashes; i++)
+  {
+    const uint16_t bit = position % m;
+    if ((_bits[bit >> 3] & (1 << (bit & 7))) == 0)
+      return false;
+    position += h2;
+  }
+  return true;
+}
+
+// Filter size in bits
+uint16_t Allowlist::bits() const
+{
+  return (uint16_t)_length * 8;
+}
+
+// Header first, bit array after; EEPROM.update() skips bytes that already hold the value,
+// so the retained filter arriving again after every reconnect costs no EEPROM writes
+void Allowlist::save(uint16_t address) const
+{
+  EEPROM.update(address, FORMAT);
+  EEPROM.update(address + 1, _hashes);
+  EEPROM.update(address + 2, _length);
+  EEPROM.update(address + 3, checksum());
+  for (uint8_t i = 0; i < _length; i++)
+    EEPROM.update(address + 4 + i, _bits[i]);
+}
+
+// Read the copy back and keep it only if the header and checksum hold
+bool Allowlist::restore(uint16_t address)
+{
+  clear();
+  const uint8_t length = EEPROM.read(address + 2);
+  if (EEPROM.read(address) != FORMAT || length == 0 || length > ALLOWLIST_MAX_BYTES)
+    return false;
+  const uint8_t hashes = EEPROM.read(address + 1);
+  if (hashes == 0 || hashes > MAX_HASHES)
+    return false;
+
+  for (uint8_t i = 0; i < length; i++)
+    _bits[i] = EEPROM.read(address + 4 + i);
+  _hashes = hashes;
+  _length = length;
+  if (checksum() != EEPROM.read(address + 3))
+  {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+// 8-bit sum over k, length and the bit array
+uint8_t Allowlist::checksum() const
+{
+  uint8_t sum = _hashes + _length;
+  for (uint8_t i = 0; i < _length; i++)
+    sum += _bits[i];
+  return sum;
+}
@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <EEPROM.h>
 #include <Wire.h>
 
 #include "config.h"
@@ -6,18 +7,311 @@
 #include "payloads.h"
 #include "rfid_reader.h"
 #include "net_mqtt.h"
+#include "uid_cache.h"
+#include "allowlist.h"
+#include "scan_queue.h"
+
+// RFID reader instances using I2C communication, polled in turn.
+// Add an entry per MFRC522 on this controller (different I2C address and/or TwoWire bus).
+static RfidReader readers[] = {
+    RfidReader(RFID_I2C_ADDR, -1, RFID_IRQ_PIN),
+    // RfidReader(0x29, -1, -1, &Wire),
+    // RfidReader(RFID_I2C_ADDR, -1, -1, &i2cBusTwo), // a second TwoWire, see MFRC522_I2C/examples/dual_i2c_scanner_new
+};
+static const uint8_t READER_COUNT = sizeof(readers) / sizeof(readers[0]);
 
-// RFID reader instance using I2C communication
-static RfidReader rfid(RFID_I2C_ADDR, -1);
 // MQTT network handler
 static NetMqtt net;
 
+// Per-reader detection and deduplication state
+struct ReaderState
+{
+  // True while a non-blocking card detection is in flight
+  bool detecting;
+  // Earliest time the next card detection may start
+  uint32_t nextDetectMs;
+  // Cards published recently, to drop repeated reads
+  UidCache recent;
+  // Keycard filter of this reader's door, from the backend
+  Allowlist allowlist;
+};
+static ReaderState readerStates[READER_COUNT];
+
+// Scans waiting to be published, in order
+static ScanQueue scanQueue;
+// Earliest time the next queued scan may be published
+static uint32_t nextDrainMs;
+
 // Cached unique device identifier
 static String deviceName;
-// Tracks the last read UID to detect duplicate reads
-static String lastUid;
-// Tracks when the last UID was published to the MQTT broker
-static uint32_t lastPublishMs = 0;
+
+#if MFRC522_FEATURE_STATS
+// When the driver counters were last published
+static uint32_t lastStatsMs;
+#endif
+
+// Device ID published for a reader: the controller ID for reader 0, "<id>-<index>" for the others
+static String readerDeviceId(uint8_t index)
+{
+  if (index == 0)
+    return deviceName;
+  String id = deviceName;
+  id += '-';
+  id += String(index, DEC);
+  return id;
+}
+
+// Retained topic carrying the keycard filter of reader `index`
+static String allowlistTopic(uint8_t index)
+{
+  String topic = MQTT_TOPIC_ALLOWLIST;
+  topic += '/';
+  topic += readerDeviceId(index);
+  return topic;
+}
+
+// EEPROM address of reader `index`'s keycard filter, -1 if it is not persisted or does not fit
+static int allowlistAddress(uint8_t index)
+{
+  const uint16_t address = ALLOWLIST_EEPROM_ADDR + (uint16_t)index * Allowlist::EEPROM_SIZE;
+  if (!ALLOWLIST_PERSIST || address + Allowlist::EEPROM_SIZE > EEPROM.length())
+    return -1;
+  // Keep clear of the scan queue
+  if (address < SCAN_QUEUE_EEPROM_ADDR + ScanQueue::EEPROM_SIZE && SCAN_QUEUE_EEPROM_ADDR < address + Allowlist::EEPROM_SIZE)
+    return -1;
+  return address;
+}
+
+// EEPROM address of the scan queue, -1 if it does not fit
+static int scanQueueAddress()
+{
+  if (SCAN_QUEUE_EEPROM_ADDR + ScanQueue::EEPROM_SIZE > EEPROM.length())
+    return -1;
+  return SCAN_QUEUE_EEPROM_ADDR;
+}
+
+// Subscribe to the keycard filter of every reader's door (again after each reconnect)
+static void subscribeAllowlists()
+{
+  if (!ALLOWLIST_ENABLED)
+    return;
+  for (uint8_t i = 0; i < READER_COUNT; i++)
+  {
+    String topic = allowlistTopic(i);
+    bool ok = net.subscribe(topic.c_str());
+    DEBUG_PRINT("Subscribe ");
+    DEBUG_PRINT(topic);
+    DEBUG_PRINTLN(ok ? " OK" : " FAILED");
+  }
+}
+
+// Handle a MQTT message: a keycard filter for one of the readers
+static void onMqttMessage(char *topic, byte *payload, unsigned int length)
+{
+  for (uint8_t i = 0; i < READER_COUNT; i++)
+  {
+    if (allowlistTopic(i) != topic)
+      continue;
+
+    Allowlist &allowlist = readerStates[i].allowlist;
+    if (!allowlist.load(payload, length))
+    {
+      DEBUG_PRINT("Ignored malformed keycard filter on ");
+      DEBUG_PRINTLN(topic);
+      return;
+    }
+    const int address = allowlistAddress(i);
+    if (address >= 0)
+      allowlist.save(address);
+    DEBUG_PRINT("Keycard filter bits: ");
+    DEBUG_PRINTLN(allowlist.bits());
+    return;
+  }
+}
+
+// Publish the oldest queued scan, at most one per SCAN_QUEUE_DRAIN_INTERVAL_MS so a backlog reaches
+// the backend at a bounded rate. While the broker is unreachable the queue goes to EEPROM instead.
+static void drainQueue()
+{
+  const ScanEvent *event = scanQueue.front();
+  if (event == NULL)
+    return;
+  if (!net.connected())
+  {
+    scanQueue.persist();
+    return;
+  }
+
+  const uint32_t now = millis();
+  if ((int32_t)(now - nextDrainMs) < 0)
+    return;
+  nextDrainMs = now + SCAN_QUEUE_DRAIN_INTERVAL_MS;
+
+  // Build MQTT payload with device info, reader index, UID, sequence number and age of the scan
+  char uid[RfidReader::UID_TEXT_SIZE];
+  RfidReader::formatUid(event->card, uid, sizeof(uid));
+  const bool rejected = (event->flags & ScanQueue::FLAG_REJECTED) != 0;
+  const uint32_t ageMs = ScanQueue::ageMs(*event, now);
+  String payload = rejected
+                       ? buildRejectedJson(readerDeviceId(event->reader), uid, event->reader, event->sequence, ageMs)
+                       : buildJsonPayload(readerDeviceId(event->reader), uid, event->reader, event->sequence, ageMs);
+
+  // Publish the UID to the MQTT broker; keep the scan queued if that fails
+  bool ok = net.publish(rejected ? MQTT_TOPIC_REJECTED : MQTT_TOPIC_UID, payload, !rejected && MQTT_RETAIN_UID);
+  if (ok)
+    scanQueue.pop();
+  else
+    scanQueue.persist();
+
+  // Log the MQTT publication result
+  DEBUG_PRINT("MQTT payload: ");
+  DEBUG_PRINTLN(payload);
+  DEBUG_PRINT("MQTT publish ");
+  DEBUG_PRINTLN(ok ? "OK" : "FAILED");
+  DEBUG_PRINT("Queued scans: ");
+  DEBUG_PRINTLN(scanQueue.size());
+}
+
+// Queue a card read by reader `index` for publishing unless it repeats within the deduplication window.
+// Cards the door's keycard filter rules out are reported as rejected instead.
+static void handleCard(uint8_t index, const CardRead &card)
+{
+  ReaderState &state = readerStates[index];
+  char uid[RfidReader::UID_TEXT_SIZE];
+  RfidReader::formatUid(card, uid, sizeof(uid));
+
+  // Log the detected card information to the serial console
+  DEBUG_PRINT("Reader: ");
+  DEBUG_PRINTLN(index);
+  DEBUG_PRINT("PICC type: ");
+  DEBUG_PRINTLN(readers[index].typeName(card));
+  DEBUG_PRINT("UID: ");
+  DEBUG_PRINTLN(uid);
+
+  // Check if this is a duplicate read (same UID published within the deduplication window)
+  const bool duplicate = state.recent.isDuplicate(card, DEDUPE_WINDOW_MS);
+  DEBUG_PRINT("Dedupe hits/misses: ");
+  DEBUG_PRINT(state.recent.hits());
+  DEBUG_PRINT("/");
+  DEBUG_PRINTLN(state.recent.misses());
+  if (duplicate)
+    return;
+
+  // Definitely not a keycard of this door: report it without asking for an access check
+  const bool rejected = ALLOWLIST_ENABLED && !state.allowlist.mightContain(uid);
+  if (rejected)
+  {
+    DEBUG_PRINTLN("Rejected locally by the keycard filter");
+  }
+
+  // Queue the scan and publish it right away if the broker is reachable and nothing is waiting
+  scanQueue.push(card, index, rejected ? ScanQueue::FLAG_REJECTED : 0);
+  drainQueue();
+}
+
+// Publish the other cards presented together with `first` (e.g. two badges in one wallet).
+// Blocks for at most RFID_INVENTORY_BUDGET_MS and leaves every card halted.
+static void handleOtherCards(uint8_t index, const CardRead &first)
+{
+  if (RFID_INVENTORY_MAX_CARDS < 2)
+    return;
+
+  static MFRC522_I2C::Uid found[RFID_INVENTORY_MAX_CARDS];
+  uint8_t count = readers[index].inventory(found, RFID_INVENTORY_MAX_CARDS, RFID_INVENTORY_BUDGET_MS);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    CardRead card;
+    readers[index].describeCard(found[i], card);
+    if (!RfidReader::sameUid(card, first))
+      handleCard(index, card);
+  }
+}
+
+// Advance reader `index` by one non-blocking step
+static void serviceReader(uint8_t index)
+{
+  RfidReader &rfid = readers[index];
+  ReaderState &state = readerStates[index];
+
+  // Start the next step once the pause after the previous one has passed
+  const uint32_t now = millis();
+  if (!state.detecting)
+  {
+    if ((int32_t)(now - state.nextDetectMs) < 0)
+      return;
+    if (RFID_PRESENCE_TRACKING)
+      rfid.startPresence();
+    else
+      rfid.startDetect();
+    state.detecting = true;
+    return;
+  }
+
+  // Advance the step; while this reader waits on its card the others get the bus
+  CardRead card;
+  if (RFID_PRESENCE_TRACKING)
+  {
+    RfidReader::PresenceEvent event = rfid.pollPresence(card);
+    if (event == RfidReader::PresenceEvent::Pending)
+      return;
+    state.detecting = false;
+    state.nextDetectMs = millis() + rfid.pollIntervalMs();
+
+    // Publish once per card presentation; the reader keeps the card halted while it stays in the field
+    if (event == RfidReader::PresenceEvent::Arrived)
+    {
+      handleCard(index, card);
+      handleOtherCards(index, card);
+    }
+    else if (event == RfidReader::PresenceEvent::Removed && DEBUG_MODE)
+    {
+      char uid[RfidReader::UID_TEXT_SIZE];
+      RfidReader::formatUid(card, uid, sizeof(uid));
+      DEBUG_PRINT("Card removed: ");
+      DEBUG_PRINTLN(uid);
+    }
+    return;
+  }
+
+  RfidReader::DetectResult result = rfid.poll(card);
+  if (result == RfidReader::DetectResult::Pending)
+    return;
+  state.detecting = false;
+  if (result == RfidReader::DetectResult::NoCard)
+  {
+    state.nextDetectMs = now + rfid.pollIntervalMs();
+    return;
+  }
+
+  handleCard(index, card);
+
+  // Put the card into halt mode; halted cards ignore REQA, so the next detection can follow right away
+  rfid.halt();
+  handleOtherCards(index, card);
+  state.nextDetectMs = millis() + rfid.pollIntervalMs();
+}
+
+#if MFRC522_FEATURE_STATS
+// Publish every reader's driver counters once per RFID_STATS_INTERVAL_MS and start the next interval
+static void publishStats()
+{
+  const uint32_t now = millis();
+  if (now - lastStatsMs < RFID_STATS_INTERVAL_MS)
+    return;
+  lastStatsMs = now;
+
+  for (uint8_t i = 0; i < READER_COUNT; i++)
+  {
+    String payload = buildStatsJson(readerDeviceId(i), i, readers[i].stats(), readerStates[i].recent);
+    readers[i].resetStats();
+    bool ok = net.publish(MQTT_TOPIC_STATS, payload, false);
+    DEBUG_PRINT("RFID stats: ");
+    DEBUG_PRINTLN(payload);
+    DEBUG_PRINT("MQTT publish ");
+    DEBUG_PRINTLN(ok ? "OK" : "FAILED");
+  }
+}
+#endif
 
 void setup()
 {
@@ -28,16 +322,44 @@ void setup()
     delay(10);
   }
 
-  // Initialize I2C communication for RFID reader
-  Wire.begin();
+  // Initialize I2C communication on every bus a reader sits on
+  RfidReader::beginBuses(readers, READER_COUNT);
   delay(50);
 
-  // Initialize RFID reader
-  rfid.begin();
+  // Initialize RFID readers
+  for (uint8_t i = 0; i < READER_COUNT; i++)
+  {
+    readers[i].begin();
+    if (RFID_DUTY_CYCLE)
+      readers[i].setDutyCycle(RFID_POLL_INTERVAL_MS, RFID_MAX_DETECT_LATENCY_MS, RFID_DUTY_HOLD_MS);
+
+    // Start with the last keycard filter received, until the broker delivers the current one
+    const int address = allowlistAddress(i);
+    if (ALLOWLIST_ENABLED && address >= 0)
+      readerStates[i].allowlist.restore(address);
+  }
+
+  // Readers sharing a bus run at the slowest clock any of them verified
+  for (uint8_t i = 0; i < READER_COUNT; i++)
+  {
+    uint32_t clock = readers[i].i2cClock();
+    for (uint8_t j = 0; j < READER_COUNT; j++)
+    {
+      if (readers[j].bus() == readers[i].bus() && readers[j].i2cClock() < clock)
+        clock = readers[j].i2cClock();
+    }
+    readers[i].setBusClock(clock);
+  }
   DEBUG_PRINTLN("RFID2 (I2C) ready. Tap a card/tag...");
 
+  // Take back the scans a previous run could not publish
+  scanQueue.begin(scanQueueAddress(), SCAN_QUEUE_PERSIST);
+  DEBUG_PRINT("Queued scans from before the restart: ");
+  DEBUG_PRINTLN(scanQueue.size());
+
   // Initialize network and WiFi
   net.begin();
+  net.setCallback(onMqttMessage);
   net.ensureWiFi();
 
   // Get and cache unique device identifier
@@ -46,53 +368,25 @@ void setup()
   DEBUG_PRINTLN(deviceName);
 
   // Connect to MQTT broker
-  net.ensureMQTT(deviceName);
+  if (net.ensureMQTT(deviceName))
+    subscribeAllowlists();
 }
 
 void loop()
 {
-  // Maintain MQTT connection and process incoming messages
-  net.ensureMQTT(deviceName);
+  // Maintain MQTT connection (one attempt per MQTT_RETRY_INTERVAL_MS, a pending socket checked every pass) and process incoming messages
+  if (net.ensureMQTT(deviceName))
+    subscribeAllowlists();
   net.loop();
 
-  // Attempt to read an RFID card/tag
-  String uid, piccType;
-  if (!rfid.readUid(uid, piccType))
-  {
-    delay(20);
-    return;
-  }
-
-  // Log the detected card information to the serial console
-  DEBUG_PRINT("PICC type: ");
-  DEBUG_PRINTLN(piccType);
-  DEBUG_PRINT("UID: ");
-  DEBUG_PRINTLN(uid);
-
-  // Check if this is a duplicate read (same UID within deduplication window)
-  const uint32_t now = millis();
-  const bool duplicate = (uid == lastUid) && (now - lastPublishMs < DEDUPE_WINDOW_MS);
-
-  if (!duplicate)
-  {
-    // Build MQTT payload with device info and UID
-    String payload = buildJsonPayload(deviceName, uid);
+  // Give every reader one step per pass so their RF waits overlap
+  for (uint8_t i = 0; i < READER_COUNT; i++)
+    serviceReader(i);
 
-    // Publish the UID to the MQTT broker
-    bool ok = net.publish(MQTT_TOPIC_UID, payload, MQTT_RETAIN_UID);
+  // Publish waiting scans, or keep them in EEPROM while offline
+  drainQueue();
 
-    // Log the MQTT publication result
-    DEBUG_PRINT("MQTT payload: ");
-    DEBUG_PRINTLN(payload);
-    DEBUG_PRINT("MQTT publish ");
-    DEBUG_PRINTLN(ok ? "OK" : "FAILED");
-
-    // Update last read tracking
-    lastUid = uid;
-    lastPublishMs = now;
-  }
-
-  // Put the RFID reader into halt mode and wait before next read
-  rfid.halt();
-  delay(250);
+#if MFRC522_FEATURE_STATS
+  publishStats();
+#endif
 }
@@ -1,83 +1,164 @@
+#include <utility/server_drv.h>
+
 #include "net_mqtt.h"
 #include "config.h"
 #include "device_id.h"
 #include "payloads.h"
 
 // Constructor - initialize MQTT client with WiFi connection
-NetMqtt::NetMqtt() : _mqtt(_wifi) {}
+NetMqtt::NetMqtt()
+    : _mqtt(_wifi), _nextAttemptMs(0), _joinStartMs(0), _joining(false), _socket(NO_SOCKET_AVAIL), _openStartMs(0),
+      _opening(false)
+{
+}
 
-// Initialize MQTT server connection parameters
+// Initialize MQTT server connection parameters and the network timeouts
 void NetMqtt::begin()
 {
   _mqtt.setServer(MQTT_HOST, MQTT_PORT);
+
+  // WiFi.begin() polls the module for up to this long; 0 only starts the join, ensureWiFi() polls later
+  WiFi.setTimeout(0);
+  // Bound the waits for the broker inside _mqtt.connect(), CONNACK and socket reads (PubSubClient takes whole seconds,
+  // at least 1). The TCP handshake is not waited for there: ensureMQTT() opens the socket itself.
+  _wifi.setTimeout(MQTT_CONNECT_TIMEOUT_MS);
+  _mqtt.setSocketTimeout(MQTT_CONNECT_TIMEOUT_MS < 1000 ? 1 : MQTT_CONNECT_TIMEOUT_MS / 1000);
 }
 
-// Ensure WiFi connection is established
-void NetMqtt::ensureWiFi()
+// Start a WiFi join if none is pending, otherwise check on it; never waits for the access point
+bool NetMqtt::ensureWiFi()
 {
-  // Return early if already connected
-  if (WiFi.status() == WL_CONNECTED)
-    return;
+  const uint8_t status = WiFi.status();
+  if (status == WL_CONNECTED)
+  {
+    // Report the connection with the assigned IP once
+    if (_joining)
+    {
+      _joining = false;
+      DEBUG_PRINT("WiFi connected. IP: ");
+      DEBUG_PRINTLN(WiFi.localIP());
+    }
+    return true;
+  }
 
   // Check if WiFi module is present
-  if (WiFi.status() == WL_NO_MODULE)
+  if (status == WL_NO_MODULE)
   {
     DEBUG_PRINTLN("WiFi module not found. Check WiFiNINA module/firmware.");
+    return false;
   }
 
-  // Initiate WiFi connection
+  // Give the pending join time before starting over (the module keeps trying in the background)
+  if (_joining && (millis() - _joinStartMs) < WIFI_JOIN_TIMEOUT_MS)
+    return false;
+  if (_joining)
+    DEBUG_PRINTLN("WiFi connection failed");
+
+  // Start the join; with WiFi.setTimeout(0) this returns at once and a later call sees the result
   DEBUG_PRINT("Connecting to WiFi SSID: ");
   DEBUG_PRINTLN(WIFI_SSID);
+  _joining = true;
+  _joinStartMs = millis();
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  return false;
+}
 
-  // Block until WiFi connection succeeds
-  while (WiFi.begin(WIFI_SSID, WIFI_PASSWORD) != WL_CONNECTED)
+// Try to (re)connect to the broker; while the socket opens and between attempts return right away so the readers keep scanning
+bool NetMqtt::ensureMQTT(const String &clientId)
+{
+  if (_mqtt.connected())
+    return false;
+
+  if (!_opening)
   {
-    DEBUG_PRINT(".");
-    delay(500);
+    // Space the attempts MQTT_RETRY_INTERVAL_MS apart
+    const uint32_t now = millis();
+    if ((int32_t)(now - _nextAttemptMs) < 0)
+      return false;
+    _nextAttemptMs = now + MQTT_RETRY_INTERVAL_MS;
+
+    // Ensure WiFi is available before attempting MQTT connection
+    if (!ensureWiFi())
+      return false;
+    openBrokerSocket();
+    return false;
+  }
+  if (!brokerSocketReady())
+    return false;
+
+  // The socket is up, so PubSubClient skips its own (blocking) TCP connect and only sends CONNECT
+  DEBUG_PRINT("Connecting to MQTT as ");
+  DEBUG_PRINT(clientId);
+  DEBUG_PRINT(" ... ");
+
+  bool ok = false;
+  if (mqttHasAuth())
+    ok = _mqtt.connect(clientId.c_str(), MQTT_USER, MQTT_PASS);
+  else
+    ok = _mqtt.connect(clientId.c_str());
+
+  // Handle connection result
+  if (!ok)
+  {
+    DEBUG_PRINT("failed, rc=");
+    DEBUG_PRINT(_mqtt.state());
+    DEBUG_PRINTLN(". Retrying later...");
+    return false;
   }
 
-  // Report successful connection with assigned IP
-  DEBUG_PRINTLN("");
-  DEBUG_PRINT("WiFi connected. IP: ");
-  DEBUG_PRINTLN(WiFi.localIP());
+  DEBUG_PRINTLN("connected!");
+  // Publish online status message
+  publishOnlineStatus(clientId);
+  return true;
 }
 
-// Ensure MQTT connection is established and maintained
-void NetMqtt::ensureMQTT(const String &clientId)
+// WiFiClient::connect() waits up to 10 s for the handshake; start it in the module and poll instead
+bool NetMqtt::openBrokerSocket()
 {
-  // Retry connection loop until successful
-  while (!_mqtt.connected())
+  // An IP address costs nothing; a host name is looked up here, which waits for the DNS answer
+  IPAddress broker;
+  if (!broker.fromString(MQTT_HOST) && WiFi.hostByName(MQTT_HOST, broker) != 1)
   {
-    // Ensure WiFi is available before attempting MQTT connection
-    ensureWiFi();
-
-    // Attempt MQTT connection with optional authentication
-    DEBUG_PRINT("Connecting to MQTT as ");
-    DEBUG_PRINT(clientId);
-    DEBUG_PRINT(" ... ");
+    DEBUG_PRINTLN("MQTT broker address not resolved. Retrying later...");
+    return false;
+  }
 
-    bool ok = false;
-    if (mqttHasAuth())
-      ok = _mqtt.connect(clientId.c_str(), MQTT_USER, MQTT_PASS);
-    else
-      ok = _mqtt.connect(clientId.c_str());
+  _socket = ServerDrv::getSocket();
+  if (_socket == NO_SOCKET_AVAIL)
+  {
+    DEBUG_PRINTLN("No free WiFi socket for MQTT. Retrying later...");
+    return false;
+  }
+  ServerDrv::startClient(uint32_t(broker), MQTT_PORT, _socket);
+  _opening = true;
+  _openStartMs = millis();
+  return true;
+}
 
-    // Handle connection result
-    if (ok)
-    {
-      DEBUG_PRINTLN("connected!");
-      // Publish online status message
-      publishOnlineStatus(clientId);
-    }
-    else
-    {
-      // Retry connection after delay
-      DEBUG_PRINT("failed, rc=");
-      DEBUG_PRINT(_mqtt.state());
-      DEBUG_PRINTLN(". Retrying in 2s...");
-      delay(2000);
-    }
+// One status query per call; the socket goes to the MQTT client once the handshake is done
+bool NetMqtt::brokerSocketReady()
+{
+  if (ServerDrv::getClientState(_socket) == ESTABLISHED)
+  {
+    _opening = false;
+    _wifi = WiFiClient(_socket);
+    return true;
   }
+  if (millis() - _openStartMs < MQTT_CONNECT_TIMEOUT_MS)
+    return false;
+
+  // Give up without WiFiClient::stop(), which waits for the close as well
+  DEBUG_PRINTLN("MQTT broker not reachable. Retrying later...");
+  ServerDrv::stopClient(_socket);
+  _opening = false;
+  _socket = NO_SOCKET_AVAIL;
+  return false;
+}
+
+// True while connected to the broker
+bool NetMqtt::connected()
+{
+  return _mqtt.connected();
 }
 
 // Publish device online status to MQTT broker
@@ -104,6 +185,18 @@ bool NetMqtt::publish(const char *topic, const String &payload, bool retain)
   return _mqtt.publish(topic, payload.c_str(), retain);
 }
 
+// Subscribe to a MQTT topic
+bool NetMqtt::subscribe(const char *topic)
+{
+  return _mqtt.subscribe(topic);
+}
+
+// Set the handler for messages on subscribed topics
+void NetMqtt::setCallback(mqtt_callback_t callback)
+{
+  _mqtt.setCallback(callback);
+}
+
 // Check if MQTT authentication credentials are configured
 bool NetMqtt::mqttHasAuth()
 {
@@ -13,15 +13,91 @@ String buildStatusJson(const String &deviceId, const String &status)
   return json;
 }
 
-// Build JSON payload containing device ID and RFID UID for MQTT publishing. \n for readability.
-String buildJsonPayload(const String &deviceId, const String &uid)
+// Build JSON payload containing device ID, reader index, RFID UID, the scan's sequence number and how long
+// ago the scan happened (ms; for scans from before a restart, the time since the restart) for MQTT publishing.
+// \n for readability.
+String buildJsonPayload(const String &deviceId, const char *uid, uint8_t readerIndex, uint32_t sequence,
+                        uint32_t ageMs)
 {
   String json;
   json += "{\n";
   json += "  \"deviceId\": \"";
   json += deviceId;
-  json += "\",\n  \"rfidUid\": \"";
+  json += "\",\n  \"reader\": ";
+  json += String(readerIndex, DEC);
+  json += ",\n  \"rfidUid\": \"";
   json += uid;
-  json += "\"\n}";
+  json += "\",\n  \"seq\": ";
+  json += String(sequence, DEC);
+  json += ",\n  \"ageMs\": ";
+  json += String(ageMs, DEC);
+  json += "\n}";
+  return json;
+}
+
+// Build compact JSON for a locally rejected card: same fields as buildJsonPayload, no whitespace
+String buildRejectedJson(const String &deviceId, const char *uid, uint8_t readerIndex, uint32_t sequence,
+                         uint32_t ageMs)
+{
+  String json;
+  json += "{\"deviceId\":\"";
+  json += deviceId;
+  json += "\",\"reader\":";
+  json += String(readerIndex, DEC);
+  json += ",\"rfidUid\":\"";
+  json += uid;
+  json += "\",\"seq\":";
+  json += String(sequence, DEC);
+  json += ",\"ageMs\":";
+  json += String(ageMs, DEC);
+  json += "}";
+  return json;
+}
+
+#if MFRC522_FEATURE_STATS
+// Append `,"name": value` to a JSON object that already has a member
+static void appendMember(String &json, const char *name, uint32_t value)
+{
+  json += ",\n  \"";
+  json += name;
+  json += "\": ";
+  json += String(value, DEC);
+}
+
+// Build JSON payload containing device ID, reader index, the driver counters of one interval and the
+// deduplication totals since start-up. Flat, one counter per line.
+String buildStatsJson(const String &deviceId, uint8_t readerIndex, const MFRC522_I2C::PCD_Stats &stats,
+                      const UidCache &recent)
+{
+  String json;
+  json += "{\n  \"deviceId\": \"";
+  json += deviceId;
+  json += "\"";
+  appendMember(json, "reader", readerIndex);
+  appendMember(json, "regReads", stats.regReads);
+  appendMember(json, "regWrites", stats.regWrites);
+  appendMember(json, "bytesRead", stats.bytesRead);
+  appendMember(json, "bytesWritten", stats.bytesWritten);
+  appendMember(json, "commPolls", stats.commPolls);
+  appendMember(json, "crcPolls", stats.crcPolls);
+  appendMember(json, "timeoutsRequest", stats.timeouts.request);
+  appendMember(json, "timeoutsSelect", stats.timeouts.select);
+  appendMember(json, "timeoutsHalt", stats.timeouts.halt);
+  appendMember(json, "timeoutsAuth", stats.timeouts.auth);
+  appendMember(json, "timeoutsTransfer", stats.timeouts.transfer);
+  appendMember(json, "timeoutsCrc", stats.timeouts.crc);
+  appendMember(json, "isNewCardPresentCalls", stats.isNewCardPresent.calls);
+  appendMember(json, "isNewCardPresentUs", stats.isNewCardPresent.totalUs);
+  appendMember(json, "isNewCardPresentMaxUs", stats.isNewCardPresent.maxUs);
+  appendMember(json, "selectCalls", stats.select.calls);
+  appendMember(json, "selectUs", stats.select.totalUs);
+  appendMember(json, "selectMaxUs", stats.select.maxUs);
+  appendMember(json, "haltCalls", stats.haltA.calls);
+  appendMember(json, "haltUs", stats.haltA.totalUs);
+  appendMember(json, "haltMaxUs", stats.haltA.maxUs);
+  appendMember(json, "dedupeHits", recent.hits());
+  appendMember(json, "dedupeMisses", recent.misses());
+  json += "\n}";
   return json;
 }
+#endif
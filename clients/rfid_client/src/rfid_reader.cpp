@@ -1,21 +1,181 @@
 #include "rfid_reader.h"
+#include "config.h"
 #include <Wire.h>
 
-// Constructor - initialize RFID reader with I2C address and optional reset pin
-RfidReader::RfidReader(uint8_t i2cAddr, int8_t resetPin)
-    : _mfrc(i2cAddr, resetPin)
+// Constructor - initialize RFID reader with I2C address, optional reset pin, optional IRQ pin and I2C bus
+RfidReader::RfidReader(uint8_t i2cAddr, int8_t resetPin, int8_t irqPin, Bus *bus)
+    : _mfrc(i2cAddr, resetPin, bus), _bus(bus), _i2cClock(100000), _i2cVerifyErrors(0),
+      _irqPin(irqPin), _tracking(false), _presenceMisses(0), _dutyCycle(false), _sleeping(false),
+      _startDeferred(false), _fieldOnUs(0), _intervalMs(RFID_POLL_INTERVAL_MS),
+      _minIntervalMs(RFID_POLL_INTERVAL_MS), _maxIntervalMs(RFID_POLL_INTERVAL_MS), _holdMs(0), _lastActivityMs(0)
 {
 }
 
 // Initialize the RFID reader module
 void RfidReader::begin()
 {
+  // Mirror the configuration registers in RAM so bit updates on the
+  // polling path cost a single I2C write instead of a read + write.
+  _mfrc.PCD_SetRegisterCache(true);
+
+  // Bring the reader up at the standard 100 kHz, then find the fastest clock the wiring handles
+  _mfrc.PCD_SetBusClock(100000);
   _mfrc.PCD_Init();
+  negotiateBusClock();
+
+  // Wait for command completion on the IRQ pin instead of polling over I2C.
+  // Falls back to polling if the pin cannot raise an interrupt.
+  if (_irqPin >= 0 && !_mfrc.PCD_SetIrqPin(_irqPin))
+  {
+    DEBUG_PRINTLN("RFID IRQ pin unavailable, polling over I2C");
+  }
+
+#if MFRC522_FEATURE_STATS
+  // Count from here on: the start-up traffic would swamp the first interval
+  _mfrc.PCD_ResetStats();
+#endif
+}
+
+// Step the I2C clock up through 400 kHz and 1 MHz, keeping the fastest one that passes verification
+void RfidReader::negotiateBusClock()
+{
+  static const uint32_t CLOCKS[] = {400000, 1000000};
+
+  // Reference reading at 100 kHz; 0x00/0xFF means nobody answers, so there is nothing to speed up
+  const byte version = _mfrc.PCD_ReadRegister(MFRC522_I2C::VersionReg);
+  if (version == 0x00 || version == 0xFF || !verifyLink(version))
+  {
+    _i2cVerifyErrors++;
+    DEBUG_PRINTLN("RFID I2C link check failed at 100 kHz");
+    return;
+  }
+
+  for (uint8_t i = 0; i < sizeof(CLOCKS) / sizeof(CLOCKS[0]) && CLOCKS[i] <= RFID_I2C_MAX_CLOCK; i++)
+  {
+    _mfrc.PCD_SetBusClock(CLOCKS[i]);
+    if (!verifyLink(version))
+    {
+      _i2cVerifyErrors++;
+      break;
+    }
+    _i2cClock = CLOCKS[i];
+  }
+
+  // Settle on the fastest stable clock and make sure the link is still sound there
+  _mfrc.PCD_SetBusClock(_i2cClock);
+  if (!verifyLink(version))
+  {
+    _i2cVerifyErrors++;
+    _i2cClock = 100000;
+    _mfrc.PCD_SetBusClock(_i2cClock);
+  }
+  DEBUG_PRINT("RFID I2C clock: ");
+  DEBUG_PRINTLN(_i2cClock);
+}
+
+// Check register traffic at the current clock: VersionReg reads and a FIFO write/readback
+bool RfidReader::verifyLink(byte expectedVersion)
+{
+  for (uint8_t round = 0; round < RFID_I2C_VERIFY_ROUNDS; round++)
+  {
+    if (_mfrc.PCD_ReadRegister(MFRC522_I2C::VersionReg) != expectedVersion)
+      return false;
+
+    // Alternating bit patterns, shifted every round, through the FIFO and back
+    byte pattern[8], echo[8];
+    for (uint8_t i = 0; i < sizeof(pattern); i++)
+      pattern[i] = ((i + round) & 1) ? 0xAA : 0x55;
+    pattern[round % sizeof(pattern)] = round;
+
+    _mfrc.PCD_WriteRegister(MFRC522_I2C::FIFOLevelReg, 0x80);
+    _mfrc.PCD_WriteRegister(MFRC522_I2C::FIFODataReg, sizeof(pattern), pattern);
+    if ((_mfrc.PCD_ReadRegister(MFRC522_I2C::FIFOLevelReg) & 0x7F) != sizeof(pattern))
+      return false;
+    _mfrc.PCD_ReadRegister(MFRC522_I2C::FIFODataReg, sizeof(echo), echo);
+    if (memcmp(pattern, echo, sizeof(pattern)) != 0)
+      return false;
+  }
+  return true;
+}
+
+// Fastest I2C clock verified in begin()
+uint32_t RfidReader::i2cClock() const
+{
+  return _i2cClock;
+}
+
+// Clock steps that failed verification in begin()
+uint8_t RfidReader::i2cVerifyErrors() const
+{
+  return _i2cVerifyErrors;
+}
+
+// Set the I2C clock of the reader's bus; also used when the bus is recovered after an error
+void RfidReader::setBusClock(uint32_t clockHz)
+{
+  _mfrc.PCD_SetBusClock(clockHz);
+}
+
+// I2C error counters since start-up
+MFRC522_I2C::PCD_BusStats RfidReader::busStats()
+{
+  return _mfrc.PCD_GetBusStats();
+}
+
+#if MFRC522_FEATURE_STATS
+// Driver operation counters since begin() or resetStats()
+MFRC522_I2C::PCD_Stats RfidReader::stats()
+{
+  return _mfrc.PCD_GetStats();
+}
+
+// Start a new counting interval
+void RfidReader::resetStats()
+{
+  _mfrc.PCD_ResetStats();
+}
+#endif
+
+// The I2C bus the reader sits on
+RfidReader::Bus *RfidReader::bus() const
+{
+  return _bus;
+}
+
+// The bus readers use when none is given: Wire, or TWI0 with RFID_DIRECT_TWI
+RfidReader::Bus *RfidReader::defaultBus()
+{
+#if RFID_DIRECT_TWI
+  static MFRC522_TWI0 twi0;
+  return &twi0;
+#else
+  return &Wire;
+#endif
+}
+
+// Readers sharing a bus are skipped after the first, so each bus sees one begin()
+void RfidReader::beginBuses(RfidReader *readers, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    bool started = false;
+    for (uint8_t j = 0; j < i && !started; j++)
+      started = readers[j]._bus == readers[i]._bus;
+    if (!started)
+      readers[i]._bus->begin();
+  }
 }
 
 // Attempt to read an RFID card/tag present in the field
-bool RfidReader::readUid(String &outUid, String &outPiccType)
+bool RfidReader::readUid(CardRead &out)
 {
+  // Blocking read: wait out the field settling time here
+  if (_sleeping)
+  {
+    wake();
+    delayMicroseconds(RFID_FIELD_SETTLE_US);
+  }
+
   // Check if a new card is present in the field
   if (!_mfrc.PICC_IsNewCardPresent())
     return false;
@@ -23,45 +183,328 @@ bool RfidReader::readUid(String &outUid, String &outPiccType)
   if (!_mfrc.PICC_ReadCardSerial())
     return false;
 
-  // Convert UID to formatted string
-  outUid = uidToString();
+  describeCard(_mfrc.uid, out);
+  return true;
+}
+
+// Start a non-blocking card detection; drive it with poll()
+void RfidReader::startDetect()
+{
+  if (!deferStart())
+    _mfrc.PICC_StartDetect();
+}
 
-  // Determine the card type and get its name
-  byte piccType = _mfrc.PICC_GetType(_mfrc.uid.sak);
-  outPiccType = _mfrc.PICC_GetTypeName(piccType);
+// Advance the detection started by startDetect() without waiting on the RF field
+RfidReader::DetectResult RfidReader::poll(CardRead &out)
+{
+  if (_startDeferred)
+  {
+    if (micros() - _fieldOnUs < RFID_FIELD_SETTLE_US)
+      return DetectResult::Pending;
+    _startDeferred = false;
+    _mfrc.PICC_StartDetect();
+  }
+
+  switch (_mfrc.PICC_PollDetect())
+  {
+  case MFRC522_I2C::DETECT_PENDING:
+    return DetectResult::Pending;
+  case MFRC522_I2C::DETECT_CARD_READY:
+    endStep(true);
+    describeCard(_mfrc.uid, out);
+    return DetectResult::CardReady;
+  default:
+    endStep(false);
+    return DetectResult::NoCard;
+  }
+}
+
+// Start the next presence tracking step; drive it with pollPresence()
+void RfidReader::startPresence()
+{
+  if (deferStart())
+    return;
+  if (_tracking)
+    _mfrc.PICC_StartPresenceCheck(&_trackedUid);
+  else
+    _mfrc.PICC_StartDetect();
+}
+
+// Advance the presence step started by startPresence()
+RfidReader::PresenceEvent RfidReader::pollPresence(CardRead &out)
+{
+  // Only a reader with an empty field sleeps, so the deferred step is always a detection
+  if (_startDeferred)
+  {
+    if (micros() - _fieldOnUs < RFID_FIELD_SETTLE_US)
+      return PresenceEvent::Pending;
+    _startDeferred = false;
+    _mfrc.PICC_StartDetect();
+  }
+
+  byte status = _mfrc.PICC_PollDetect();
+  if (status == MFRC522_I2C::DETECT_PENDING)
+    return PresenceEvent::Pending;
+
+  if (status == MFRC522_I2C::DETECT_CARD_READY)
+  {
+    // Halt the card again so a plain REQA from another reader or a
+    // detection after removal does not pick it up as new
+    _presenceMisses = 0;
+    endStep(true);
+    if (_tracking)
+    {
+      halt();
+      return PresenceEvent::None;
+    }
+    _tracking = true;
+    _trackedUid = _mfrc.uid;
+    describeCard(_mfrc.uid, out);
+    halt();
+    return PresenceEvent::Arrived;
+  }
+
+  if (!_tracking)
+  {
+    endStep(false);
+    return PresenceEvent::None;
+  }
 
+  // A single missed answer is usually RF noise or a card at the edge of the field
+  if (++_presenceMisses < RFID_PRESENCE_MISSES)
+  {
+    endStep(true);
+    return PresenceEvent::None;
+  }
+
+  _tracking = false;
+  _presenceMisses = 0;
+  endStep(true);
+  describeCard(_trackedUid, out);
+  return PresenceEvent::Removed;
+}
+
+// True while a card is tracked
+bool RfidReader::tracking() const
+{
+  return _tracking;
+}
+
+// Enable duty cycling: sleep between empty steps, pause minIntervalMs..(maxLatencyMs - wake-up and detection time)
+void RfidReader::setDutyCycle(uint16_t minIntervalMs, uint16_t maxLatencyMs, uint16_t holdMs)
+{
+  const uint16_t overheadMs = RFID_FIELD_SETTLE_US / 1000 + DETECT_TIME_MS;
+  _dutyCycle = true;
+  _minIntervalMs = minIntervalMs;
+  _maxIntervalMs = (maxLatencyMs > overheadMs + minIntervalMs) ? maxLatencyMs - overheadMs : minIntervalMs;
+  _holdMs = holdMs;
+  _intervalMs = minIntervalMs;
+  _lastActivityMs = millis();
+}
+
+// Pause before the next step
+uint16_t RfidReader::pollIntervalMs() const
+{
+  return _intervalMs;
+}
+
+// True while the MFRC522 is powered down between steps
+bool RfidReader::sleeping() const
+{
+  return _sleeping;
+}
+
+// Power the MFRC522 up and switch the field on; cards need RFID_FIELD_SETTLE_US of field before they answer
+void RfidReader::wake()
+{
+  if (!_mfrc.PCD_SoftPowerUp())
+  {
+    DEBUG_PRINTLN("RFID reader did not wake up, resetting");
+    _mfrc.PCD_Init();
+  }
+  _mfrc.PCD_AntennaOn();
+  _sleeping = false;
+  _fieldOnUs = micros();
+}
+
+// Wake a sleeping reader at the start of a step; the detection then waits in poll()/pollPresence()
+bool RfidReader::deferStart()
+{
+  if (!_sleeping)
+    return false;
+  wake();
+  _startDeferred = true;
+  return true;
+}
+
+// Shrink the pause on activity, grow it once idle for _holdMs, and sleep until the next step if nothing is in the field
+void RfidReader::endStep(bool activity)
+{
+  const uint32_t now = millis();
+  if (activity)
+  {
+    _lastActivityMs = now;
+    _intervalMs = _minIntervalMs;
+    return;
+  }
+  if (!_dutyCycle || _tracking)
+    return;
+  if (now - _lastActivityMs >= _holdMs)
+    _intervalMs = (_intervalMs > _maxIntervalMs / 2) ? _maxIntervalMs : _intervalMs * 2;
+
+  // Power-down stops the field; halted cards lose power and come back in IDLE
+  _mfrc.PCD_AntennaOff();
+  _mfrc.PCD_SoftPowerDown();
+  _sleeping = true;
+}
+
+// Enumerate every card in the field; each one is selected once and halted
+uint8_t RfidReader::inventory(MFRC522_I2C::Uid *uids, uint8_t maxUids, uint16_t budgetMs)
+{
+  byte count = 0;
+  _mfrc.PICC_Inventory(uids, maxUids, &count, budgetMs);
+  return count;
+}
+
+#if MFRC522_FEATURE_READ
+// Read MIFARE Classic blocks of the selected card with key A, one authentication per sector
+bool RfidReader::readBlocks(uint8_t firstBlock, uint8_t blockCount, uint8_t *buffer, uint8_t bufferSize,
+                            const MFRC522_I2C::MIFARE_Key &key, MFRC522_I2C::MIFARE_ReadTimings *timings)
+{
+  byte status = _mfrc.MIFARE_ReadBlocks(firstBlock, blockCount, buffer, bufferSize, &key,
+                                        MFRC522_I2C::PICC_CMD_MF_AUTH_KEY_A, timings);
+  if (status != MFRC522_I2C::STATUS_OK)
+  {
+    DEBUG_PRINT("MIFARE read failed: ");
+    DEBUG_PRINTLN(_mfrc.GetStatusCodeName(status));
+    return false;
+  }
+  return true;
+}
+
+// Read the data blocks of a MIFARE Classic sector of the selected card with key A
+bool RfidReader::readSector(uint8_t sector, uint8_t *buffer, uint8_t bufferSize,
+                            const MFRC522_I2C::MIFARE_Key &key, MFRC522_I2C::MIFARE_ReadTimings *timings)
+{
+  byte status = _mfrc.MIFARE_ReadSector(sector, buffer, bufferSize, &key,
+                                        MFRC522_I2C::PICC_CMD_MF_AUTH_KEY_A, timings);
+  if (status != MFRC522_I2C::STATUS_OK)
+  {
+    DEBUG_PRINT("MIFARE read failed: ");
+    DEBUG_PRINTLN(_mfrc.GetStatusCodeName(status));
+    return false;
+  }
   return true;
 }
 
+// Read pages of the selected Ultralight/NTAG card, FAST_READ first and READ as fallback
+bool RfidReader::readPages(uint8_t startPage, uint8_t pageCount, uint8_t *buffer, uint8_t bufferSize)
+{
+  byte status = _mfrc.MIFARE_Ultralight_ReadPages(startPage, pageCount, buffer, bufferSize);
+  if (status != MFRC522_I2C::STATUS_OK)
+  {
+    DEBUG_PRINT("Page read failed: ");
+    DEBUG_PRINTLN(_mfrc.GetStatusCodeName(status));
+    return false;
+  }
+  return true;
+}
+#endif
+
+// Negotiate a higher RF bit rate with the selected card
+bool RfidReader::negotiateBitRate(MFRC522_I2C::PCD_BitRate maxRate)
+{
+  byte status = _mfrc.PICC_NegotiateBitRate(maxRate);
+  if (status != MFRC522_I2C::STATUS_OK)
+  {
+    DEBUG_PRINT("Bit rate negotiation failed: ");
+    DEBUG_PRINTLN(_mfrc.GetStatusCodeName(status));
+    return false;
+  }
+  return true;
+}
+
+// Current RF bit rate in kbps
+uint16_t RfidReader::bitRateKbps()
+{
+  return 106u << _mfrc.PCD_GetBitRate();
+}
+
+// Duration of the last card command in microseconds
+uint32_t RfidReader::lastTransceiveUs()
+{
+  return _mfrc.PCD_GetLastTransceiveUs();
+}
+
 // Stop reading and halt the current card
 void RfidReader::halt()
 {
   // Halt the currently selected RFID card so it stops responding,
   // preventing repeated reads and allowing other cards to be detected.
   // The card remains powered and can be woken by REQA/WUPA or removal.
-  _mfrc.PICC_HaltA();
+  // An ISO 14443-4 card is released with DESELECT instead, which also halts it.
+  if (_mfrc.PICC_IsProtocolActive())
+    _mfrc.PICC_Deselect();
+  else
+    _mfrc.PICC_HaltA();
 
   // Stop any encrypted communication and reset the reader state
   _mfrc.PCD_StopCrypto1();
 }
 
-// Convert the RFID UID bytes to a formatted hexadecimal string
-String RfidReader::uidToString()
+// Fill a card record from a UID returned by the driver
+void RfidReader::describeCard(const MFRC522_I2C::Uid &uid, CardRead &out)
+{
+  copyUid(uid, out);
+  // Only the type code here; the name is looked up by typeName() when someone prints it
+  out.type = (MFRC522_I2C::PICC_Type)_mfrc.PICC_GetType(uid.sak);
+  out.timestampMs = millis();
+}
+
+// Copy UID bytes, size and SAK into a card record
+void RfidReader::copyUid(const MFRC522_I2C::Uid &uid, CardRead &out)
+{
+  out.uidSize = uid.size <= sizeof(out.uid) ? uid.size : sizeof(out.uid);
+  memcpy(out.uid, uid.uidByte, out.uidSize);
+  out.sak = uid.sak;
+}
+
+// Name of the card type, from flash
+const __FlashStringHelper *RfidReader::typeName(const CardRead &card)
+{
+  return _mfrc.PICC_GetTypeName(card.type);
+}
+
+// Replace the per-command RF timeouts used by the driver
+void RfidReader::setTimingProfile(const MFRC522_I2C::PCD_TimingProfile &profile)
+{
+  _mfrc.PCD_SetTimingProfile(&profile);
+}
+
+// Write the UID as colon separated upper case hex into a caller buffer, two table lookups per byte
+uint8_t RfidReader::formatUid(const CardRead &card, char *out, uint8_t outSize)
 {
-  String s;
-  // Iterate through each byte of the UID
-  for (byte i = 0; i < _mfrc.uid.size; i++)
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+  uint8_t length = 0;
+  if (outSize == 0)
+    return 0;
+  for (uint8_t i = 0; i < card.uidSize; i++)
   {
-    // Pad single-digit hex values with leading zero
-    if (_mfrc.uid.uidByte[i] < 0x10)
-      s += '0';
-    // Append the byte as hexadecimal
-    s += String(_mfrc.uid.uidByte[i], HEX);
-    // Add colon separator between bytes (except after last byte)
-    if (i + 1 < _mfrc.uid.size)
-      s += ':';
+    // Two digits, plus the separator before every byte but the first
+    const uint8_t needed = (i == 0) ? 2 : 3;
+    if (length + needed >= outSize)
+      break;
+    if (i != 0)
+      out[length++] = ':';
+    out[length++] = HEX_DIGITS[card.uid[i] >> 4];
+    out[length++] = HEX_DIGITS[card.uid[i] & 0x0F];
   }
-  // Convert the result to uppercase
-  s.toUpperCase();
-  return s;
+  out[length] = '\0';
+  return length;
+}
+
+// Compare UID size and bytes; SAK, type and timestamp do not matter
+bool RfidReader::sameUid(const CardRead &a, const CardRead &b)
+{
+  return a.uidSize == b.uidSize && memcmp(a.uid, b.uid, a.uidSize) == 0;
 }
@@ -0,0 +1,216 @@
+#include <EEPROM.h>
+
+#include "scan_queue.h"
+
+// Slot status byte: written last when an event is stored, cleared when it was sent.
+// Anything else (0xFF on a blank EEPROM) is a free slot.
+static const uint8_t SLOT_PENDING = 0x5A;
+static const uint8_t SLOT_SENT = 0x00;
+
+// Constructor - empty, no EEPROM
+ScanQueue::ScanQueue()
+    : _tail(0), _count(0), _boot(0), _counter(0), _dropped(0), _address(-1), _persist(false), _nextSlot(0)
+{
+  memset(_events, 0, sizeof(_events));
+}
+
+// Bump the boot number, then take back what the last run did not send
+void ScanQueue::begin(int address, bool persist)
+{
+  _address = address;
+  _persist = persist && address >= 0;
+  if (_address < 0)
+    return;
+
+  // A blank EEPROM reads 0xFFFF, the first boot is then 0
+  _boot = (uint16_t)(EEPROM.read(_address) | (EEPROM.read(_address + 1) << 8)) + 1;
+  saveBoot();
+  if (_persist)
+    restore();
+}
+
+// Assign the sequence number and append; the oldest event makes room when the ring is full
+void ScanQueue::push(const CardRead &card, uint8_t reader, uint8_t flags)
+{
+  if (_count == SCAN_QUEUE_SIZE)
+  {
+    pop();
+    _dropped++;
+  }
+
+  ScanEvent &event = _events[(_tail + _count) % SCAN_QUEUE_SIZE];
+  event.card = card;
+  event.sequence = ((uint32_t)_boot << 16) | _counter;
+  event.reader = reader;
+  event.flags = flags;
+  event.slot = NO_SLOT;
+  _count++;
+
+  // 65536 scans in one run: carry into the boot number so the sequence keeps increasing
+  if (++_counter == 0)
+  {
+    _boot++;
+    saveBoot();
+  }
+}
+
+// Oldest event, NULL if empty
+const ScanEvent *ScanQueue::front() const
+{
+  return _count == 0 ? NULL : &_events[_tail];
+}
+
+// Free the oldest event and its slot
+void ScanQueue::pop()
+{
+  if (_count == 0)
+    return;
+  release(_events[_tail]);
+  _tail = (_tail + 1) % SCAN_QUEUE_SIZE;
+  _count--;
+}
+
+// Store every queued event that has no slot yet
+void ScanQueue::persist()
+{
+  if (!_persist)
+    return;
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    ScanEvent &event = _events[(_tail + i) % SCAN_QUEUE_SIZE];
+    if (event.slot == NO_SLOT)
+      store(event);
+  }
+}
+
+// Events waiting
+uint8_t ScanQueue::size() const
+{
+  return _count;
+}
+
+// Events dropped because the ring was full
+uint32_t ScanQueue::dropped() const
+{
+  return _dropped;
+}
+
+// The millis() clock of the scan is gone after a restart, so a restored event never passes as recent
+uint32_t ScanQueue::ageMs(const ScanEvent &event, uint32_t now)
+{
+  if (event.flags & FLAG_RESTORED)
+    return AGE_UNKNOWN;
+  return now - event.card.timestampMs;
+}
+
+// Slots follow the 2-byte boot number
+int ScanQueue::slotAddress(uint8_t slot) const
+{
+  return _address + 2 + slot * SLOT_SIZE;
+}
+
+// True if no queued event is stored in the slot
+bool ScanQueue::slotFree(uint8_t slot) const
+{
+  for (uint8_t i = 0; i < _count; i++)
+  {
+    if (_events[(_tail + i) % SCAN_QUEUE_SIZE].slot == slot)
+      return false;
+  }
+  return true;
+}
+
+// Take the next free slot round-robin; the status byte goes last so a cut-off write leaves the slot free
+void ScanQueue::store(ScanEvent &event)
+{
+  uint8_t slot = _nextSlot;
+  while (!slotFree(slot))
+    slot = (slot + 1) % SCAN_QUEUE_SIZE;
+  _nextSlot = (slot + 1) % SCAN_QUEUE_SIZE;
+
+  uint8_t bytes[SLOT_SIZE];
+  memset(bytes, 0, sizeof(bytes));
+  bytes[2] = (event.reader << 4) | (event.flags & 0x0F);
+  bytes[3] = event.card.uidSize;
+  for (uint8_t i = 0; i < 4; i++)
+    bytes[4 + i] = (uint8_t)(event.sequence >> (8 * i));
+  memcpy(bytes + 8, event.card.uid, event.card.uidSize);
+  bytes[1] = slotChecksum(bytes);
+
+  const int address = slotAddress(slot);
+  for (uint8_t i = 1; i < SLOT_SIZE; i++)
+    EEPROM.update(address + i, bytes[i]);
+  EEPROM.update(address, SLOT_PENDING);
+  event.slot = slot;
+}
+
+// One status byte write per sent event that had been stored
+void ScanQueue::release(ScanEvent &event)
+{
+  if (event.slot == NO_SLOT)
+    return;
+  EEPROM.update(slotAddress(event.slot), SLOT_SENT);
+  event.slot = NO_SLOT;
+}
+
+// Insert every valid pending slot into the ring by sequence number
+void ScanQueue::restore()
+{
+  for (uint8_t slot = 0; slot < SCAN_QUEUE_SIZE; slot++)
+  {
+    const int address = slotAddress(slot);
+    if (EEPROM.read(address) != SLOT_PENDING)
+      continue;
+    uint8_t bytes[SLOT_SIZE];
+    for (uint8_t i = 0; i < SLOT_SIZE; i++)
+      bytes[i] = EEPROM.read(address + i);
+    if (bytes[1] != slotChecksum(bytes) || bytes[3] == 0 || bytes[3] > sizeof(CardRead::uid))
+    {
+      EEPROM.update(address, SLOT_SENT);
+      continue;
+    }
+
+    ScanEvent event;
+    memset(&event, 0, sizeof(event));
+    event.card.uidSize = bytes[3];
+    memcpy(event.card.uid, bytes + 8, event.card.uidSize);
+    for (uint8_t i = 0; i < 4; i++)
+      event.sequence |= (uint32_t)bytes[4 + i] << (8 * i);
+    event.reader = bytes[2] >> 4;
+    // millis() restarted: the scan is older than anything this run can measure
+    event.flags = (bytes[2] & 0x0F) | FLAG_RESTORED;
+    event.slot = slot;
+
+    // Shift newer events up one place, then put this one in order
+    uint8_t position = _count;
+    while (position > 0 && _events[(_tail + position - 1) % SCAN_QUEUE_SIZE].sequence > event.sequence)
+    {
+      _events[(_tail + position) % SCAN_QUEUE_SIZE] = _events[(_tail + position - 1) % SCAN_QUEUE_SIZE];
+      position--;
+    }
+    _events[(_tail + position) % SCAN_QUEUE_SIZE] = event;
+    _count++;
+  }
+
+  // Continue the round-robin after the newest stored event
+  if (_count != 0)
+    _nextSlot = (_events[(_tail + _count - 1) % SCAN_QUEUE_SIZE].slot + 1) % SCAN_QUEUE_SIZE;
+}
+
+// Boot number, little endian
+void ScanQueue::saveBoot()
+{
+  if (_address < 0)
+    return;
+  EEPROM.update(_address, (uint8_t)_boot);
+  EEPROM.update(_address + 1, (uint8_t)(_boot >> 8));
+}
+
+// 8-bit sum over the slot bytes after the checksum
+uint8_t ScanQueue::slotChecksum(const uint8_t *slot)
+{
+  uint8_t sum = 0;
+  for (uint8_t i = 2; i < SLOT_SIZE; i++)
+    sum += slot[i];
+  return sum;
+}
@@ -0,0 +1,64 @@
+#include "uid_cache.h"
+
+// Constructor - empty cache, counters at zero
+UidCache::UidCache()
+    : _hits(0), _misses(0)
+{
+  memset(_entries, 0, sizeof(_entries));
+}
+
+// Look the card up; record it as published unless it is a duplicate
+bool UidCache::isDuplicate(const CardRead &card, uint32_t windowMs)
+{
+  const uint32_t hash = hashUid(card);
+  const uint32_t now = card.timestampMs;
+
+  // Find the card, and the entry to replace should it not be there: a free one, else the least recently seen
+  Entry *victim = &_entries[0];
+  for (uint8_t i = 0; i < DEDUPE_CACHE_SIZE; i++)
+  {
+    Entry &entry = _entries[i];
+    if (entry.hash == hash)
+    {
+      entry.seenMs = now;
+      if (now - entry.publishedMs < windowMs)
+      {
+        _hits++;
+        return true;
+      }
+      entry.publishedMs = now;
+      _misses++;
+      return false;
+    }
+    if (victim->hash != 0 && (entry.hash == 0 || now - entry.seenMs > now - victim->seenMs))
+      victim = &entry;
+  }
+
+  victim->hash = hash;
+  victim->publishedMs = now;
+  victim->seenMs = now;
+  _misses++;
+  return false;
+}
+
+// Reads suppressed as duplicates since start-up
+uint32_t UidCache::hits() const
+{
+  return _hits;
+}
+
+// Reads let through since start-up
+uint32_t UidCache::misses() const
+{
+  return _misses;
+}
+
+// 32-bit FNV-1a; 0 is reserved for free entries
+uint32_t UidCache::hashUid(const CardRead &card)
+{
+  uint32_t hash = 2166136261u;
+  hash = (hash ^ card.uidSize) * 16777619u;
+  for (uint8_t i = 0; i < card.uidSize; i++)
+    hash = (hash ^ card.uid[i]) * 16777619u;
+  return hash != 0 ? hash : 1;
+}
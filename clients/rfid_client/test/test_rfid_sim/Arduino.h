@@ -0,0 +1,146 @@
+#pragma once
+// Host stand-in for the Arduino core, just what rfid_reader.cpp and MFRC522_I2C use.
+// Time is virtual: it only moves on I2C transfers (see Wire.h), delays and time queries.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+
+#define HEX 16
+#define DEC 10
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define NOT_AN_INTERRUPT -1
+
+class __FlashStringHelper;
+#define F(s) ((const __FlashStringHelper *)(s))
+
+// Virtual clock of the simulation
+class SimClock
+{
+public:
+  // Cost of a millis()/micros() call, so busy-wait loops on the clock make progress
+  static const uint32_t QUERY_NS = 1000;
+
+  // Nanoseconds since the start of the run
+  static uint64_t nowNs();
+
+  // Let time pass
+  static void advanceNs(uint64_t ns);
+
+private:
+  static uint64_t _nowNs;
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// No pins on the host: every pin reads HIGH, so the driver takes the soft reset path
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(int interrupt, void (*handler)(), int mode);
+void detachInterrupt(int interrupt);
+void noInterrupts();
+void interrupts();
+
+// Arduino String on top of std::string, with the operations the client uses
+class String : public std::string
+{
+public:
+  String() {}
+  String(const char *s) : std::string(s) {}
+  String(const std::string &s) : std::string(s) {}
+  String(const __FlashStringHelper *s) : std::string((const char *)s) {}
+  String(char c) : std::string(1, c) {}
+  String(unsigned char value, int base = DEC) { assign(format(value, base)); }
+  String(int value, int base = DEC) { assign(format(value, base)); }
+  String(unsigned int value, int base = DEC) { assign(format(value, base)); }
+  String(long value, int base = DEC) { assign(format(value, base)); }
+  String(unsigned long value, int base = DEC) { assign(format(value, base)); }
+
+  unsigned int length() const { return (unsigned int)size(); }
+  void toUpperCase()
+  {
+    for (size_t i = 0; i < size(); i++)
+      (*this)[i] = (char)toupper((unsigned char)(*this)[i]);
+  }
+  String &operator+=(const String &s)
+  {
+    append(s);
+    return *this;
+  }
+  String &operator+=(const char *s)
+  {
+    append(s);
+    return *this;
+  }
+  String &operator+=(char c)
+  {
+    push_back(c);
+    return *this;
+  }
+
+private:
+  static std::string format(long value, int base)
+  {
+    char buffer[24];
+    if (base == HEX)
+      snprintf(buffer, sizeof(buffer), "%lx", (unsigned long)value);
+    else
+      snprintf(buffer, sizeof(buffer), "%ld", value);
+    return buffer;
+  }
+};
+
+// Serial console, written to stdout
+class HostSerial
+{
+public:
+  void begin(unsigned long) {}
+  operator bool() const { return true; }
+  void print(const char *s) { fputs(s, stdout); }
+  void print(const __FlashStringHelper *s) { fputs((const char *)s, stdout); }
+  void print(const String &s) { fputs(s.c_str(), stdout); }
+  void print(char c) { putchar(c); }
+  void print(long value, int base = DEC) { printf(base == HEX ? "%lX" : "%ld", value); }
+  void print(int value, int base = DEC) { print((long)value, base); }
+  void print(unsigned int value, int base = DEC) { print((long)value, base); }
+  void print(unsigned long value, int base = DEC) { print((long)value, base); }
+  void print(unsigned char value, int base = DEC) { print((long)value, base); }
+  template <class T>
+  void println(T value)
+  {
+    print(value);
+    putchar('\n');
+  }
+  template <class T>
+  void println(T value, int base)
+  {
+    print(value, base);
+    putchar('\n');
+  }
+  void println() { putchar('\n'); }
+};
+extern HostSerial Serial;
@@ -0,0 +1,42 @@
+#pragma once
+// Host stand-in for the Arduino EEPROM library: 256 bytes (ATmega4809) in RAM, erased (0xFF) at start-up.
+// Counts the cell writes so tests can check the wear.
+#include <Arduino.h>
+
+class EEPROMClass
+{
+public:
+  static const uint16_t SIZE = 256;
+
+  EEPROMClass() { erase(); }
+
+  uint8_t read(int index) const { return _data[index]; }
+  void write(int index, uint8_t value)
+  {
+    _data[index] = value;
+    _writes++;
+  }
+  // Write only if the cell holds a different value
+  void update(int index, uint8_t value)
+  {
+    if (_data[index] != value)
+      write(index, value);
+  }
+  uint16_t length() const { return SIZE; }
+
+  // Cell writes since the last erase()
+  uint32_t writes() const { return _writes; }
+
+  // Back to a blank EEPROM
+  void erase()
+  {
+    memset(_data, 0xFF, sizeof(_data));
+    _writes = 0;
+  }
+
+private:
+  uint8_t _data[SIZE];
+  uint32_t _writes;
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,86 @@
+#pragma once
+// Host stand-in for the Wire library: an I2C master that hands every transfer to the simulated
+// device at the addressed slot and books its cost (transactions, bytes, bus time).
+#include <Arduino.h>
+
+// Same receive/transmit buffer as the megaAVR Wire library
+#define BUFFER_LENGTH 128
+
+// I2C slave on the simulated bus
+class SimI2cDevice
+{
+public:
+  virtual ~SimI2cDevice() {}
+
+  // A write transfer: the bytes after the address byte
+  virtual void i2cWrite(const uint8_t *data, uint8_t length) = 0;
+
+  // A read transfer: fill length bytes
+  virtual void i2cRead(uint8_t *data, uint8_t length) = 0;
+};
+
+// I2C traffic counted by the simulated bus
+struct SimBusCounters
+{
+  uint32_t transactions; // START ... STOP sequences, also the ones nobody acknowledged
+  uint32_t bytesWritten; // Data bytes to the slaves, without the address bytes
+  uint32_t bytesRead;    // Data bytes from the slaves
+  uint64_t busTimeNs;    // Time SCL was running
+};
+
+class TwoWire
+{
+public:
+  static const uint8_t MAX_DEVICES = 8;
+
+  TwoWire();
+
+  void begin();
+  void end();
+  void setClock(uint32_t clockHz);
+  void beginTransmission(uint8_t address);
+  size_t write(uint8_t value);
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity);
+  int available();
+  int read();
+
+  // Put a device on the bus at address, or take it off with nullptr
+  void attach(uint8_t address, SimI2cDevice *device);
+
+  // Take every device off the bus and clear the counters
+  void reset();
+
+  // Counters since the last reset()
+  const SimBusCounters &counters() const;
+
+  // Calls of begin() since the last reset(); until the first one no transfer reaches the bus
+  uint8_t beginCount() const;
+
+  // Current SCL frequency in Hz
+  uint32_t clock() const;
+
+private:
+  struct Slot
+  {
+    uint8_t address;
+    SimI2cDevice *device;
+  };
+  Slot _devices[MAX_DEVICES];
+  uint32_t _clockHz;
+  uint8_t _beginCount;
+  SimBusCounters _counters;
+  uint8_t _txAddress;
+  uint8_t _txBuffer[BUFFER_LENGTH];
+  uint8_t _txLength;
+  uint8_t _rxBuffer[BUFFER_LENGTH];
+  uint8_t _rxLength;
+  uint8_t _rxIndex;
+
+  // Device at address, nullptr if nobody acknowledges it
+  SimI2cDevice *find(uint8_t address);
+
+  // Book one transfer of dataBytes after the address byte: START, 9 clocks per byte, STOP
+  void bookTransfer(uint8_t dataBytes);
+};
+extern TwoWire Wire;
@@ -0,0 +1,231 @@
+// Host implementations of the Arduino core, Wire and EEPROM stand-ins
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Wire.h>
+
+HostSerial Serial;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+uint64_t SimClock::_nowNs = 0;
+
+// Nanoseconds since the start of the run
+uint64_t SimClock::nowNs()
+{
+  return _nowNs;
+}
+
+// Let time pass
+void SimClock::advanceNs(uint64_t ns)
+{
+  _nowNs += ns;
+}
+
+unsigned long millis()
+{
+  SimClock::advanceNs(SimClock::QUERY_NS);
+  return (unsigned long)(SimClock::nowNs() / 1000000);
+}
+
+unsigned long micros()
+{
+  SimClock::advanceNs(SimClock::QUERY_NS);
+  return (unsigned long)(SimClock::nowNs() / 1000);
+}
+
+void delay(unsigned long ms)
+{
+  SimClock::advanceNs((uint64_t)ms * 1000000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  SimClock::advanceNs((uint64_t)us * 1000);
+}
+
+void yield()
+{
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t, uint8_t)
+{
+}
+
+int digitalRead(uint8_t)
+{
+  return HIGH;
+}
+
+int digitalPinToInterrupt(uint8_t)
+{
+  return NOT_AN_INTERRUPT;
+}
+
+void attachInterrupt(int, void (*)(), int)
+{
+}
+
+void detachInterrupt(int)
+{
+}
+
+void noInterrupts()
+{
+}
+
+void interrupts()
+{
+}
+
+TwoWire::TwoWire()
+    : _clockHz(100000), _beginCount(0), _txAddress(0), _txLength(0), _rxLength(0), _rxIndex(0)
+{
+  reset();
+}
+
+void TwoWire::begin()
+{
+  _beginCount++;
+}
+
+void TwoWire::end()
+{
+}
+
+void TwoWire::setClock(uint32_t clockHz)
+{
+  _clockHz = clockHz;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+  _txAddress = address;
+  _txLength = 0;
+}
+
+size_t TwoWire::write(uint8_t value)
+{
+  if (_txLength >= BUFFER_LENGTH)
+    return 0;
+  _txBuffer[_txLength++] = value;
+  return 1;
+}
+
+// The slave sees the bytes once the STOP is on the bus
+uint8_t TwoWire::endTransmission(bool)
+{
+  if (_beginCount == 0)
+    return 4; // TWI not enabled: nothing goes out
+  SimI2cDevice *device = find(_txAddress);
+  if (device == nullptr)
+  {
+    bookTransfer(0);
+    return 2;
+  }
+  bookTransfer(_txLength);
+  _counters.bytesWritten += _txLength;
+  device->i2cWrite(_txBuffer, _txLength);
+  return 0;
+}
+
+// The slave is sampled when the transfer starts
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity)
+{
+  _rxLength = 0;
+  _rxIndex = 0;
+  if (quantity > BUFFER_LENGTH)
+    quantity = BUFFER_LENGTH;
+  if (_beginCount == 0)
+    return 0;
+  SimI2cDevice *device = find(address);
+  if (device == nullptr)
+  {
+    bookTransfer(0);
+    return 0;
+  }
+  device->i2cRead(_rxBuffer, quantity);
+  bookTransfer(quantity);
+  _counters.bytesRead += quantity;
+  _rxLength = quantity;
+  return quantity;
+}
+
+int TwoWire::available()
+{
+  return _rxLength - _rxIndex;
+}
+
+int TwoWire::read()
+{
+  if (_rxIndex >= _rxLength)
+    return -1;
+  return _rxBuffer[_rxIndex++];
+}
+
+// Put a device on the bus at address, or take it off with nullptr
+void TwoWire::attach(uint8_t address, SimI2cDevice *device)
+{
+  for (uint8_t i = 0; i < MAX_DEVICES; i++)
+  {
+    if (_devices[i].device != nullptr && _devices[i].address == address)
+      _devices[i].device = nullptr;
+  }
+  if (device == nullptr)
+    return;
+  for (uint8_t i = 0; i < MAX_DEVICES; i++)
+  {
+    if (_devices[i].device == nullptr)
+    {
+      _devices[i].address = address;
+      _devices[i].device = device;
+      return;
+    }
+  }
+}
+
+// Take every device off the bus and clear the counters
+void TwoWire::reset()
+{
+  memset(_devices, 0, sizeof(_devices));
+  memset(&_counters, 0, sizeof(_counters));
+  _beginCount = 0;
+}
+
+const SimBusCounters &TwoWire::counters() const
+{
+  return _counters;
+}
+
+uint8_t TwoWire::beginCount() const
+{
+  return _beginCount;
+}
+
+uint32_t TwoWire::clock() const
+{
+  return _clockHz;
+}
+
+SimI2cDevice *TwoWire::find(uint8_t address)
+{
+  for (uint8_t i = 0; i < MAX_DEVICES; i++)
+  {
+    if (_devices[i].device != nullptr && _devices[i].address == address)
+      return _devices[i].device;
+  }
+  return nullptr;
+}
+
+// START, address and data bytes with their ACK bit, STOP
+void TwoWire::bookTransfer(uint8_t dataBytes)
+{
+  const uint64_t clocks = 1 + 9 * (1 + (uint64_t)dataBytes) + 1;
+  const uint64_t ns = clocks * 1000000000ull / _clockHz;
+  _counters.transactions++;
+  _counters.busTimeNs += ns;
+  SimClock::advanceNs(ns);
+}
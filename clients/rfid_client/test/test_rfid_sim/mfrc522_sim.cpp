@@ -0,0 +1,956 @@
+#include "mfrc522_sim.h"
+
+namespace
+{
+// MFRC522 registers (datasheet chapter 9)
+enum : uint8_t
+{
+  CommandReg = 0x01,
+  ComIEnReg = 0x02,
+  DivIEnReg = 0x03,
+  ComIrqReg = 0x04,
+  DivIrqReg = 0x05,
+  ErrorReg = 0x06,
+  Status1Reg = 0x07,
+  Status2Reg = 0x08,
+  FIFODataReg = 0x09,
+  FIFOLevelReg = 0x0A,
+  WaterLevelReg = 0x0B,
+  ControlReg = 0x0C,
+  BitFramingReg = 0x0D,
+  CollReg = 0x0E,
+  ModeReg = 0x11,
+  TxModeReg = 0x12,
+  RxModeReg = 0x13,
+  TxControlReg = 0x14,
+  CRCResultRegH = 0x21,
+  CRCResultRegL = 0x22,
+  TModeReg = 0x2A,
+  TPrescalerReg = 0x2B,
+  TReloadRegH = 0x2C,
+  TReloadRegL = 0x2D,
+  VersionReg = 0x37
+};
+
+// CommandReg[3..0]
+enum : uint8_t
+{
+  CmdIdle = 0x0,
+  CmdCalcCRC = 0x3,
+  CmdNoCmdChange = 0x7,
+  CmdTransceive = 0xC,
+  CmdMFAuthent = 0xE,
+  CmdSoftReset = 0xF
+};
+
+// ComIrqReg bits
+const uint8_t IRQ_TX = 0x40;
+const uint8_t IRQ_RX = 0x20;
+const uint8_t IRQ_IDLE = 0x10;
+const uint8_t IRQ_ERR = 0x02;
+const uint8_t IRQ_TIMER = 0x01;
+
+// ErrorReg bits
+const uint8_t ERR_BUFFER_OVFL = 0x10;
+const uint8_t ERR_COLL = 0x08;
+const uint8_t ERR_CRC = 0x04;
+
+// Reset values of the registers that are not 0x00 (datasheet table 20)
+const uint8_t RESET_VALUES[][2] = {
+    {CommandReg, 0x20}, {ComIEnReg, 0x80}, {ComIrqReg, 0x14}, {Status1Reg, 0x21},
+    {WaterLevelReg, 0x08}, {ControlReg, 0x10}, {CollReg, 0x80}, {ModeReg, 0x3F},
+    {TxControlReg, 0x80}, {0x16, 0x10}, {0x17, 0x84}, {0x18, 0x84}, {0x19, 0x4D},
+    {0x1C, 0x62}, {0x1F, 0xEB}, {CRCResultRegH, 0xFF}, {CRCResultRegL, 0xFF},
+    {0x24, 0x26}, {0x26, 0x48}, {0x27, 0x88}, {0x28, 0x20}, {0x29, 0x20},
+    {VersionReg, SimMfrc522::VERSION}};
+
+// Status2Reg bits
+const uint8_t STATUS2_CRYPTO1_ON = 0x08;
+
+// ISO 14443-3 type A commands
+const uint8_t PICC_REQA = 0x26;
+const uint8_t PICC_WUPA = 0x52;
+const uint8_t PICC_HLTA = 0x50;
+const uint8_t PICC_CT = 0x88;
+const uint8_t PICC_SEL[3] = {0x93, 0x95, 0x97};
+
+// MIFARE and NTAG commands
+const uint8_t PICC_AUTH_KEY_A = 0x60;
+const uint8_t PICC_READ = 0x30;
+const uint8_t PICC_FAST_READ = 0x3A;
+const uint8_t PICC_NAK = 0x0; // 4 bit answer: invalid argument or command
+
+// ISO 14443-4
+const uint8_t PICC_RATS = 0xE0;
+const uint8_t PICC_PPS = 0xD0;    // PPSS with CID in the low nibble
+const uint8_t PICC_I_BLOCK = 0x02; // PCB, block number in bit 0
+const uint8_t PICC_DESELECT = 0xC2;
+
+// Carrier frequency, one bit at 106 kbps is 128 carrier periods
+const uint64_t FC_HZ = 13560000;
+// Frame delay time from the end of the reader frame to the card answer: 1236 / fc
+const uint64_t FDT_NS = 1236ull * 1000000000ull / FC_HZ;
+// SoftReset and wake-up from soft power-down: oscillator start-up plus 37.74 us (datasheet 8.8.2)
+const uint64_t STARTUP_NS = 100000;
+
+// CRC_A (ISO 14443-3 annex B) from the given preset
+uint16_t crcA(const uint8_t *data, uint16_t length, uint16_t crc = 0x6363)
+{
+  for (uint16_t i = 0; i < length; i++)
+  {
+    uint8_t b = data[i] ^ (uint8_t)(crc & 0xFF);
+    b ^= (uint8_t)(b << 4);
+    crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+  }
+  return crc;
+}
+
+// Append the CRC_A to the first length bytes of frame
+void appendCrc(SimFrame &frame, uint16_t length)
+{
+  uint16_t crc = crcA(frame.data, length);
+  frame.data[length] = crc & 0xFF;
+  frame.data[length + 1] = crc >> 8;
+  frame.bits = (length + 2) * 8;
+}
+
+// True if the last two of length bytes are the CRC_A of the others
+bool crcOk(const uint8_t *data, uint16_t length)
+{
+  uint16_t crc = crcA(data, length - 2);
+  return data[length - 2] == (crc & 0xFF) && data[length - 1] == (crc >> 8);
+}
+
+void setBit(uint8_t *data, uint16_t n, bool value)
+{
+  if (value)
+    data[n / 8] |= 1 << (n % 8);
+  else
+    data[n / 8] &= ~(1 << (n % 8));
+}
+
+// Duration of a frame: start bit, data with one parity bit per full byte, end of frame
+uint64_t frameNs(uint16_t bits, uint64_t bitNs)
+{
+  return (2 + bits + bits / 8) * bitNs;
+}
+
+// MIFARE Classic sector of a block: 4 blocks each up to block 127, 16 each after (4K)
+uint8_t sectorOf(uint8_t block)
+{
+  return (block < 128) ? block / 4 : 32 + (block - 128) / 16;
+}
+} // namespace
+
+// uidSize 4, 7 or 10; the ATQA follows from the UID size unless given
+SimPicc::SimPicc(const uint8_t *uid, uint8_t uidSize, uint8_t sak, uint16_t atqa)
+    : replyDelayUs(0), memory(nullptr), memorySize(0), fastRead(false), ats(nullptr), _uidSize(uidSize), _sak(sak),
+      _atqa(atqa), _state(Idle), _level(1), _fromHalt(false), _authSector(NO_SECTOR), _protocol(false),
+      _ppsAllowed(false), _rate(0)
+{
+  memset(keyA, 0xFF, sizeof(keyA));
+  memcpy(_uid, uid, uidSize);
+  if (_atqa == 0)
+    _atqa = (uidSize == 4) ? 0x0004 : (uidSize == 7) ? 0x0044 : 0x0084;
+}
+
+// Answer a frame from the reader; returns false if the card stays silent
+bool SimPicc::receive(const SimFrame &in, SimFrame &out)
+{
+  out.bits = 0;
+  if (in.rate != _rate)
+    return false; // Noise at this bit rate
+
+  // Short frame: REQA wakes Idle cards, WUPA also halted ones
+  if (in.bits == 7)
+  {
+    const uint8_t command = in.data[0] & 0x7F;
+    const bool wakes = (command == PICC_REQA && _state == Idle) ||
+                       (command == PICC_WUPA && (_state == Idle || _state == Halt));
+    if (!wakes)
+    {
+      if (_state == Ready || _state == Active)
+        reject();
+      return false;
+    }
+    _fromHalt = (_state == Halt);
+    _state = Ready;
+    _level = 1;
+    out.data[0] = _atqa & 0xFF;
+    out.data[1] = _atqa >> 8;
+    out.bits = 16;
+    return true;
+  }
+
+  if (_state == Idle || _state == Halt)
+    return false;
+  if (in.bits < 16)
+  {
+    reject();
+    return false;
+  }
+
+  if (_state == Active)
+    return receiveActive(in, out);
+
+  // Ready: ANTICOLLISION or SELECT of the current cascade level
+  if (in.data[0] != PICC_SEL[_level - 1])
+  {
+    reject();
+    return false;
+  }
+  uint8_t cascade[5];
+  cascadeBytes(cascade);
+  const uint8_t nvb = in.data[1];
+
+  if (nvb == 0x70)
+  {
+    if (in.bits != 72 || !crcOk(in.data, 9) || memcmp(&in.data[2], cascade, 5) != 0)
+    {
+      reject();
+      return false;
+    }
+    const uint8_t levels = (_uidSize == 4) ? 1 : (_uidSize == 7) ? 2 : 3;
+    if (_level < levels)
+    {
+      out.data[0] = 0x04; // Cascade bit: UID not complete
+      _level++;
+    }
+    else
+    {
+      out.data[0] = _sak & ~0x04;
+      _state = Active;
+    }
+    appendCrc(out, 1);
+    return true;
+  }
+
+  // The reader sends the UID bits it knows; a card with those bits answers with the rest
+  const int16_t known = ((nvb >> 4) - 2) * 8 + (nvb & 0x0F);
+  if (known < 0 || known >= 40 || in.bits != 16 + known)
+  {
+    reject();
+    return false;
+  }
+  for (int16_t i = 0; i < known; i++)
+  {
+    if (in.bit(16 + i) != (bool)((cascade[i / 8] >> (i % 8)) & 1))
+      return false; // Not this card, it stays Ready and silent
+  }
+  memset(out.data, 0, sizeof(out.data));
+  for (int16_t i = known; i < 40; i++)
+    setBit(out.data, i - known, (cascade[i / 8] >> (i % 8)) & 1);
+  out.bits = 40 - known;
+  return true;
+}
+
+// Active: HLTA, READ, FAST_READ and RATS; ISO 14443-4 blocks once RATS was answered
+bool SimPicc::receiveActive(const SimFrame &in, SimFrame &out)
+{
+  // Whole bytes with a good CRC_A only. Plain text to an authenticated card, or the other way round, is noise.
+  const uint16_t length = in.bits / 8;
+  if (in.bits % 8 != 0 || length < 3 || !crcOk(in.data, length) || in.crypto != (_authSector != NO_SECTOR))
+  {
+    if (!_protocol)
+      reject();
+    return false;
+  }
+  if (_protocol)
+    return receiveBlock(in.data, length - 2, out);
+
+  const uint8_t command = in.data[0];
+  if (command == PICC_HLTA && length == 4 && in.data[1] == 0)
+  {
+    _state = Halt;
+    _authSector = NO_SECTOR;
+    return false;
+  }
+  if (command == PICC_RATS && length == 4 && ats != nullptr)
+  {
+    memcpy(out.data, ats, ats[0]);
+    appendCrc(out, ats[0]);
+    _protocol = true;
+    _ppsAllowed = true;
+    return true;
+  }
+  if (command == PICC_READ && length == 4 && memory != nullptr)
+    return read(in.data[1], out);
+  if (command == PICC_FAST_READ && length == 5 && memory != nullptr && pageBased())
+    return fastRead ? fastReadPages(in.data[1], in.data[2], out) : nak(out);
+  reject();
+  return false;
+}
+
+// ISO 14443-4: PPS right after the ATS, I-blocks come back unchanged (a loopback card), S(DESELECT) ends the protocol
+bool SimPicc::receiveBlock(const uint8_t *data, uint16_t length, SimFrame &out)
+{
+  const bool ppsAllowed = _ppsAllowed;
+  _ppsAllowed = false;
+  const uint8_t pcb = data[0];
+
+  if ((pcb & 0xF0) == PICC_PPS && ppsAllowed && length == 3 && data[1] == 0x11)
+  {
+    // PPS1: DSI (card to reader) and DRI (reader to card); only rates TA(1) offers both ways
+    const uint8_t dri = data[2] & 0x03;
+    const uint8_t dsi = (data[2] >> 2) & 0x03;
+    const uint8_t ta = (ats[0] >= 3 && (ats[1] & 0x10)) ? ats[2] : 0x00;
+    if (dri != dsi || (dri != 0 && !((ta >> 4) & ta & (1 << (dri - 1)))))
+      return false;
+    out.data[0] = pcb;
+    appendCrc(out, 1);
+    _rate = dri; // The answer still goes out at the old rate
+    return true;
+  }
+  if ((pcb & 0xFE) == PICC_I_BLOCK)
+  {
+    memcpy(out.data, data, length);
+    appendCrc(out, length);
+    return true;
+  }
+  if (pcb == PICC_DESELECT && length == 1)
+  {
+    out.data[0] = pcb;
+    appendCrc(out, 1);
+    _state = Halt;
+    _protocol = false;
+    _rate = 0;
+    return true;
+  }
+  return false;
+}
+
+// READ: 16 bytes from a page (rolling over at the end of memory) or from an authenticated block
+bool SimPicc::read(uint8_t address, SimFrame &out)
+{
+  if (pageBased())
+  {
+    if (address * 4 >= memorySize)
+      return nak(out);
+    for (uint8_t i = 0; i < 16; i++)
+      out.data[i] = memory[(address * 4 + i) % memorySize];
+  }
+  else
+  {
+    if ((address + 1) * 16 > memorySize || sectorOf(address) != _authSector)
+      return nak(out);
+    memcpy(out.data, &memory[address * 16], 16);
+  }
+  appendCrc(out, 16);
+  return true;
+}
+
+// FAST_READ: pages startPage..endPage in one answer
+bool SimPicc::fastReadPages(uint8_t startPage, uint8_t endPage, SimFrame &out)
+{
+  const uint16_t length = (endPage - startPage + 1) * 4;
+  if (endPage < startPage || (endPage + 1) * 4 > memorySize || length > SimFrame::MAX_BYTES - 2)
+    return nak(out);
+  memcpy(out.data, &memory[startPage * 4], length);
+  appendCrc(out, length);
+  return true;
+}
+
+// Ultralight and NTAG (SAK 0x00) have 4 byte pages and no authentication
+bool SimPicc::pageBased() const
+{
+  return _sak == 0x00;
+}
+
+// A 4 bit NAK, after which the card leaves the Active state
+bool SimPicc::nak(SimFrame &out)
+{
+  out.data[0] = PICC_NAK;
+  out.bits = 4;
+  reject();
+  return true;
+}
+
+// MFAuthent of the reader for the sector of block; false (and the card drops out) on a wrong key or UID
+bool SimPicc::authenticate(uint8_t keyType, uint8_t block, const uint8_t *key, const uint8_t *uid)
+{
+  if (_state != Active || _protocol)
+    return false;
+  if (memory == nullptr || pageBased() || keyType != PICC_AUTH_KEY_A || (block + 1) * 16 > memorySize ||
+      memcmp(key, keyA, sizeof(keyA)) != 0 || memcmp(uid, &_uid[_uidSize - 4], 4) != 0)
+  {
+    reject();
+    return false;
+  }
+  _authSector = sectorOf(block);
+  return true;
+}
+
+// The field went off: back to Idle
+void SimPicc::powerOff()
+{
+  _state = Idle;
+  _level = 1;
+  _fromHalt = false;
+  _authSector = NO_SECTOR;
+  _protocol = false;
+  _ppsAllowed = false;
+  _rate = 0;
+}
+
+SimPicc::State SimPicc::state() const
+{
+  return _state;
+}
+
+// Bit rate agreed with PPS
+uint8_t SimPicc::bitRate() const
+{
+  return _rate;
+}
+
+// UID CLn + BCC for the current cascade level
+void SimPicc::cascadeBytes(uint8_t out[5]) const
+{
+  const uint8_t index = 3 * (_level - 1);
+  const bool cascadeTag = (_level == 1 && _uidSize > 4) || (_level == 2 && _uidSize > 7);
+  if (cascadeTag)
+  {
+    out[0] = PICC_CT;
+    memcpy(&out[1], &_uid[index], 3);
+  }
+  else
+  {
+    memcpy(out, &_uid[index], 4);
+  }
+  out[4] = out[0] ^ out[1] ^ out[2] ^ out[3];
+}
+
+// A command the card does not expect in its state (ISO 14443-3 figure 7)
+void SimPicc::reject()
+{
+  _state = _fromHalt ? Halt : Idle;
+  _level = 1;
+  _authSector = NO_SECTOR;
+  _protocol = false;
+}
+
+SimMfrc522::SimMfrc522()
+    : _pointer(0), _fifoLength(0), _piccCount(0), _txActive(false), _txStartNs(0), _txLength(0), _rxDoneNs(0),
+      _timerDoneNs(0), _responseCollision(false), _collisionBit(0), _rxProgressive(false), _rxStartNs(0),
+      _rxDelivered(0), _authDoneNs(0), _readyNs(0), _fieldOn(false), _fieldOnSinceNs(0), _fieldOnTotalNs(0),
+      _framesSent(0)
+{
+  memset(_piccs, 0, sizeof(_piccs));
+  memset(&_txFrame, 0, sizeof(_txFrame));
+  softReset();
+  _readyNs = 0;
+  _regs[CommandReg] = 0x20;
+}
+
+// Cards in the field
+void SimMfrc522::addPicc(SimPicc *picc)
+{
+  if (_piccCount < MAX_PICCS)
+    _piccs[_piccCount++] = picc;
+}
+
+void SimMfrc522::removePicc(SimPicc *picc)
+{
+  for (uint8_t i = 0; i < _piccCount; i++)
+  {
+    if (_piccs[i] == picc)
+    {
+      picc->powerOff();
+      _piccs[i] = _piccs[--_piccCount];
+      return;
+    }
+  }
+}
+
+// Time the RF field has been on
+uint64_t SimMfrc522::fieldOnNs()
+{
+  update();
+  uint64_t total = _fieldOnTotalNs;
+  if (_fieldOn)
+    total += SimClock::nowNs() - _fieldOnSinceNs;
+  return total;
+}
+
+// Frames sent to the cards
+uint32_t SimMfrc522::framesSent() const
+{
+  return _framesSent;
+}
+
+// First byte: register address. The rest goes to that register, the address does not increment.
+void SimMfrc522::i2cWrite(const uint8_t *data, uint8_t length)
+{
+  if (length == 0)
+    return;
+  _pointer = data[0] & 0x3F;
+  for (uint8_t i = 1; i < length; i++)
+    writeRegister(_pointer, data[i]);
+}
+
+void SimMfrc522::i2cRead(uint8_t *data, uint8_t length)
+{
+  for (uint8_t i = 0; i < length; i++)
+    data[i] = readRegister(_pointer);
+}
+
+// All registers back to their reset values; the chip is busy for STARTUP_NS
+void SimMfrc522::softReset()
+{
+  memset(_regs, 0, sizeof(_regs));
+  for (size_t i = 0; i < sizeof(RESET_VALUES) / sizeof(RESET_VALUES[0]); i++)
+    _regs[RESET_VALUES[i][0]] = RESET_VALUES[i][1];
+  _regs[CommandReg] = 0x20 | CmdSoftReset;
+  _fifoLength = 0;
+  _txActive = false;
+  _rxDoneNs = 0;
+  _timerDoneNs = 0;
+  _authDoneNs = 0;
+  _readyNs = SimClock::nowNs() + STARTUP_NS;
+  updateField();
+}
+
+void SimMfrc522::writeRegister(uint8_t reg, uint8_t value)
+{
+  update();
+  switch (reg)
+  {
+  case CommandReg:
+    setCommand(value);
+    break;
+  case ComIrqReg:
+  case DivIrqReg:
+    // Set1/Set2: 1 sets the marked bits, 0 clears them
+    if (value & 0x80)
+      _regs[reg] |= value & 0x7F;
+    else
+      _regs[reg] &= ~value;
+    break;
+  case FIFODataReg:
+    if (_fifoLength < sizeof(_fifo))
+      _fifo[_fifoLength++] = value;
+    else
+      _regs[ErrorReg] |= ERR_BUFFER_OVFL;
+    break;
+  case FIFOLevelReg:
+    if (value & 0x80)
+    {
+      _fifoLength = 0;
+      _regs[ErrorReg] &= ~ERR_BUFFER_OVFL;
+    }
+    break;
+  case BitFramingReg:
+    _regs[reg] = value & 0x7F;
+    if ((value & 0x80) && (_regs[CommandReg] & 0x0F) == CmdTransceive)
+      startSend();
+    break;
+  case Status2Reg:
+    _regs[reg] = (_regs[reg] & ~0x08) | (_regs[reg] & value & 0x08); // MFCrypto1On can only be cleared
+    break;
+  case ErrorReg:
+  case Status1Reg:
+  case ControlReg:
+  case VersionReg:
+    break; // Read-only here
+  case TxControlReg:
+    _regs[reg] = value;
+    updateField();
+    break;
+  default:
+    _regs[reg] = value;
+    break;
+  }
+}
+
+uint8_t SimMfrc522::readRegister(uint8_t reg)
+{
+  update();
+  switch (reg)
+  {
+  case FIFODataReg:
+  {
+    if (_fifoLength == 0)
+      return 0;
+    const uint8_t value = _fifo[0];
+    memmove(_fifo, &_fifo[1], --_fifoLength);
+    return value;
+  }
+  case FIFOLevelReg:
+    return _fifoLength;
+  case Status1Reg:
+  {
+    const uint8_t water = _regs[WaterLevelReg] & 0x3F;
+    uint8_t value = 0x20; // CRCReady
+    if (_fifoLength <= water)
+      value |= 0x01; // LoAlert
+    if (sizeof(_fifo) - _fifoLength <= water)
+      value |= 0x02; // HiAlert
+    if (_timerDoneNs != 0)
+      value |= 0x08; // TRunning
+    if ((_regs[ComIrqReg] & _regs[ComIEnReg] & 0x7F) || (_regs[DivIrqReg] & _regs[DivIEnReg] & 0x14))
+      value |= 0x10; // IRq
+    return value;
+  }
+  default:
+    return _regs[reg];
+  }
+}
+
+void SimMfrc522::setCommand(uint8_t value)
+{
+  const bool wasPowerDown = (_regs[CommandReg] & 0x10) != 0;
+  uint8_t command = value & 0x0F;
+  if (command == CmdSoftReset)
+  {
+    softReset();
+    return;
+  }
+  if (command == CmdNoCmdChange)
+    command = _regs[CommandReg] & 0x0F;
+
+  if (value & 0x10)
+  {
+    // Soft power-down: oscillator and antenna drivers stop, the running command with them
+    _regs[CommandReg] = (value & 0x30) | CmdIdle;
+    _txActive = false;
+    _rxDoneNs = 0;
+    _timerDoneNs = 0;
+    _authDoneNs = 0;
+    updateField();
+    return;
+  }
+  if (wasPowerDown)
+  {
+    // PowerDown reads 1 until the oscillator runs again
+    _regs[CommandReg] = (value & 0x20) | 0x10 | command;
+    _readyNs = SimClock::nowNs() + STARTUP_NS;
+    return;
+  }
+
+  _regs[CommandReg] = (value & 0x20) | command;
+  switch (command)
+  {
+  case CmdIdle:
+    // Simplification: the frame, reply and timer of an abandoned Transceive are dropped with it
+    _txActive = false;
+    _rxDoneNs = 0;
+    _timerDoneNs = 0;
+    _authDoneNs = 0;
+    break;
+  case CmdCalcCRC:
+    calcCrc();
+    break;
+  case CmdTransceive:
+    break; // Waits for StartSend
+  case CmdMFAuthent:
+    mfAuthent();
+    break;
+  default:
+    // Mem, GenerateRandomID, Transmit, Receive are not simulated: they end at once
+    _regs[ComIrqReg] |= IRQ_IDLE;
+    _regs[CommandReg] = (value & 0x20) | CmdIdle;
+    break;
+  }
+}
+
+// StartSend: the frame goes on air and takes its bytes from the FIFO as it goes, see transmit()
+void SimMfrc522::startSend()
+{
+  if (_txActive)
+    return;
+  _txActive = true;
+  _txStartNs = SimClock::nowNs();
+  _txLength = 0;
+  _regs[ErrorReg] = 0;
+  _regs[CollReg] = (_regs[CollReg] & 0x80) | 0x20; // CollPosNotValid until a collision is seen
+  _rxDoneNs = 0;
+  _rxDelivered = 0;
+  transmit(_txStartNs);
+}
+
+// Each byte leaves the FIFO when the one before it goes on air; a FIFO found empty ends the frame
+void SimMfrc522::transmit(uint64_t now)
+{
+  const uint64_t byteNs = 9 * bitNs(TxModeReg);
+  while (_txActive && _txStartNs + _txLength * byteNs <= now)
+  {
+    if (_fifoLength == 0)
+    {
+      finishTransmit();
+      return;
+    }
+    if (_txLength < SimFrame::MAX_BYTES - 2)
+      _txFrame.data[_txLength] = _fifo[0];
+    _txLength++;
+    memmove(_fifo, &_fifo[1], --_fifoLength);
+  }
+}
+
+// The frame is complete: the cards in the field hear it, their answer and the timer are scheduled
+void SimMfrc522::finishTransmit()
+{
+  _txActive = false;
+  SimFrame &frame = _txFrame;
+  const uint8_t txLastBits = _regs[BitFramingReg] & 0x07;
+  const uint16_t length = (_txLength < SimFrame::MAX_BYTES - 2) ? _txLength : SimFrame::MAX_BYTES - 2;
+  frame.bits = length ? (length - 1) * 8 + (txLastBits ? txLastBits : 8) : 0;
+  if ((_regs[TxModeReg] & 0x80) && txLastBits == 0 && length > 0)
+    appendCrc(frame, length);
+  frame.rate = (_regs[TxModeReg] >> 4) & 0x03;
+  frame.crypto = (_regs[Status2Reg] & STATUS2_CRYPTO1_ON) != 0;
+  _regs[ComIrqReg] |= IRQ_TX;
+  _framesSent++;
+
+  const uint64_t txDoneNs = _txStartNs + frameNs(frame.bits, bitNs(TxModeReg));
+  _timerDoneNs = (_regs[TModeReg] & 0x80) ? txDoneNs + timerNs() : 0; // TAuto
+  _rxDoneNs = 0;
+  if (!_fieldOn || frame.bits == 0)
+    return;
+
+  // Every card in the field hears the frame; answers that differ collide at the first differing bit
+  uint8_t answers = 0;
+  uint32_t delayUs = 0;
+  _responseCollision = false;
+  for (uint8_t i = 0; i < _piccCount; i++)
+  {
+    SimFrame answer;
+    if (!_piccs[i]->receive(frame, answer))
+      continue;
+    if (answers++ == 0)
+    {
+      _response = answer;
+      delayUs = _piccs[i]->replyDelayUs;
+      continue;
+    }
+    if (_piccs[i]->replyDelayUs < delayUs)
+      delayUs = _piccs[i]->replyDelayUs;
+    const uint16_t common = (answer.bits < _response.bits) ? answer.bits : _response.bits;
+    uint16_t diff = common;
+    for (uint16_t n = 0; n < common; n++)
+    {
+      if (answer.bit(n) != _response.bit(n))
+      {
+        diff = n;
+        break;
+      }
+    }
+    if (diff < common || answer.bits != _response.bits)
+    {
+      if (!_responseCollision || diff < _collisionBit)
+        _collisionBit = diff;
+      _responseCollision = true;
+      if (answer.bits > _response.bits)
+        _response.bits = answer.bits;
+    }
+  }
+  // The answer comes at the rate of the frame; a receiver set to another rate misses it
+  if (answers == 0 || ((_regs[RxModeReg] >> 4) & 0x03) != frame.rate)
+    return;
+
+  // TAuto: the timer stops when the answer starts
+  const uint64_t replyNs = txDoneNs + FDT_NS + (uint64_t)delayUs * 1000;
+  if (_timerDoneNs != 0 && replyNs < _timerDoneNs)
+    _timerDoneNs = 0;
+  _rxStartNs = replyNs;
+  _rxDoneNs = replyNs + frameNs(_response.bits, bitNs(RxModeReg));
+  _rxProgressive = !_responseCollision && _response.bits % 8 == 0 && (_regs[BitFramingReg] & 0x70) == 0;
+}
+
+// MFAuthent with the command, block address, key and UID from the FIFO. The two passes take about four
+// short frames; a wrong key gets no answer, so the timer runs out.
+void SimMfrc522::mfAuthent()
+{
+  bool ok = false;
+  if (_fieldOn && _fifoLength >= 12)
+  {
+    for (uint8_t i = 0; i < _piccCount && !ok; i++)
+    {
+      if (_piccs[i]->state() == SimPicc::Active)
+        ok = _piccs[i]->authenticate(_fifo[0], _fifo[1], &_fifo[2], &_fifo[8]);
+    }
+  }
+  _fifoLength = 0;
+  _framesSent++;
+
+  const uint64_t now = SimClock::nowNs();
+  const uint64_t bit = bitNs(TxModeReg);
+  if (ok)
+    _authDoneNs = now + 3 * frameNs(32, bit) + frameNs(64, bit) + 3 * FDT_NS;
+  else if (_regs[TModeReg] & 0x80)
+    _timerDoneNs = now + frameNs(32, bit) + timerNs();
+}
+
+// CRC of the FIFO content with the preset in ModeReg[1..0]
+void SimMfrc522::calcCrc()
+{
+  static const uint16_t presets[4] = {0x0000, 0x6363, 0xA671, 0xFFFF};
+  const uint16_t crc = crcA(_fifo, _fifoLength, presets[_regs[ModeReg] & 0x03]);
+  _fifoLength = 0;
+  _regs[CRCResultRegH] = crc >> 8;
+  _regs[CRCResultRegL] = crc & 0xFF;
+  _regs[DivIrqReg] |= 0x04; // CRCIRq
+}
+
+// Whole bytes of the answer that have arrived by now enter the FIFO; the CRC_A stays out with RxCRCEn
+void SimMfrc522::receiveBytes(uint64_t now)
+{
+  const uint64_t bit = bitNs(RxModeReg);
+  if (_rxDoneNs == 0 || !_rxProgressive || now < _rxStartNs + bit)
+    return;
+  uint16_t length = _response.bits / 8;
+  if ((_regs[RxModeReg] & 0x80) && length >= 3)
+    length -= 2;
+  uint64_t arrived = (now - _rxStartNs - bit) / (9 * bit); // Start bit first, then 9 bits per byte
+  if (arrived > length)
+    arrived = length;
+  for (; _rxDelivered < arrived; _rxDelivered++)
+  {
+    if (_fifoLength < sizeof(_fifo))
+      _fifo[_fifoLength++] = _response.data[_rxDelivered];
+    else
+      _regs[ErrorReg] |= ERR_BUFFER_OVFL;
+  }
+}
+
+// The answer is complete: the rest into the FIFO at RxAlign, with RxLastBits, CollReg and the IRQ bits
+void SimMfrc522::receiveResponse()
+{
+  _rxDoneNs = 0;
+  const uint8_t rxAlign = (_regs[BitFramingReg] >> 4) & 0x07;
+  SimFrame received = _response;
+
+  // ValuesAfterColl = 0: every bit from the collision on reads 0
+  if (_responseCollision && !(_regs[CollReg] & 0x80))
+  {
+    for (uint16_t n = _collisionBit; n < received.bits; n++)
+      setBit(received.data, n, false);
+  }
+
+  uint8_t aligned[SimFrame::MAX_BYTES + 1];
+  memset(aligned, 0, sizeof(aligned));
+  for (uint16_t n = 0; n < received.bits; n++)
+    setBit(aligned, rxAlign + n, received.bit(n));
+  const uint16_t totalBits = rxAlign + received.bits;
+  uint16_t length = (totalBits + 7) / 8;
+
+  if ((_regs[RxModeReg] & 0x80) && length >= 3 && totalBits % 8 == 0)
+  {
+    if (!crcOk(aligned, length))
+      _regs[ErrorReg] |= ERR_CRC;
+    length -= 2;
+  }
+  for (uint16_t i = _rxDelivered; i < length; i++)
+  {
+    if (_fifoLength < sizeof(_fifo))
+      _fifo[_fifoLength++] = aligned[i];
+    else
+      _regs[ErrorReg] |= ERR_BUFFER_OVFL;
+  }
+  _rxDelivered = 0;
+  _regs[ControlReg] = (_regs[ControlReg] & ~0x07) | (totalBits % 8);
+
+  // CollPos counts from the first bit of the first FIFO byte, RxAlign included; 0 means bit 32
+  if (_responseCollision)
+  {
+    const uint16_t position = rxAlign + _collisionBit + 1;
+    _regs[ErrorReg] |= ERR_COLL;
+    _regs[CollReg] = (_regs[CollReg] & 0x80) | ((position <= 32) ? (position & 0x1F) : 0x20);
+    _regs[ComIrqReg] |= IRQ_ERR;
+  }
+  if (_regs[ErrorReg] & (ERR_BUFFER_OVFL | ERR_CRC))
+    _regs[ComIrqReg] |= IRQ_ERR;
+  _regs[ComIrqReg] |= IRQ_RX;
+}
+
+// Apply the events that are due: start-up done, frame sent, answer bytes received, authentication done, timer expired
+void SimMfrc522::update()
+{
+  const uint64_t now = SimClock::nowNs();
+  if (_readyNs != 0 && now >= _readyNs)
+  {
+    _readyNs = 0;
+    _regs[CommandReg] &= ~0x1F; // Idle, PowerDown cleared
+    updateField();
+  }
+  transmit(now);
+  receiveBytes(now);
+  if (_authDoneNs != 0 && now >= _authDoneNs)
+  {
+    _authDoneNs = 0;
+    _regs[Status2Reg] |= STATUS2_CRYPTO1_ON;
+    _regs[ComIrqReg] |= IRQ_IDLE;
+    _regs[CommandReg] &= ~0x0F;
+  }
+  if (_timerDoneNs != 0 && now >= _timerDoneNs && (_rxDoneNs == 0 || _timerDoneNs <= _rxDoneNs))
+  {
+    _timerDoneNs = 0;
+    _regs[ComIrqReg] |= IRQ_TIMER;
+  }
+  if (_rxDoneNs != 0 && now >= _rxDoneNs)
+    receiveResponse();
+  if (_timerDoneNs != 0 && now >= _timerDoneNs)
+  {
+    _timerDoneNs = 0;
+    _regs[ComIrqReg] |= IRQ_TIMER;
+  }
+}
+
+// The field is on while TX1 or TX2 drives and the oscillator runs; cards lose power when it goes off
+void SimMfrc522::updateField()
+{
+  const bool on = (_regs[TxControlReg] & 0x03) && !(_regs[CommandReg] & 0x10) && _readyNs == 0;
+  if (on == _fieldOn)
+    return;
+  const uint64_t now = SimClock::nowNs();
+  if (on)
+  {
+    _fieldOnSinceNs = now;
+  }
+  else
+  {
+    _fieldOnTotalNs += now - _fieldOnSinceNs;
+    for (uint8_t i = 0; i < _piccCount; i++)
+      _piccs[i]->powerOff();
+  }
+  _fieldOn = on;
+}
+
+// Duration of one bit at the speed in TxModeReg/RxModeReg: 128 / fc at 106 kbps, halved per step
+uint64_t SimMfrc522::bitNs(uint8_t modeReg) const
+{
+  const uint8_t speed = (_regs[modeReg] >> 4) & 0x03;
+  return (128ull * 1000000000ull / FC_HZ) >> speed;
+}
+
+// Timer period: (2 * TPrescaler + 1) * (TReload + 1) / fc
+uint64_t SimMfrc522::timerNs() const
+{
+  const uint64_t prescaler = ((uint64_t)(_regs[TModeReg] & 0x0F) << 8) | _regs[TPrescalerReg];
+  const uint64_t reload = ((uint64_t)_regs[TReloadRegH] << 8) | _regs[TReloadRegL];
+  return (2 * prescaler + 1) * (reload + 1) * 1000000000ull / FC_HZ;
+}
+
+SimMeter::SimMeter(const TwoWire &bus)
+    : _bus(bus), _start(bus.counters()), _startNs(SimClock::nowNs())
+{
+}
+
+SimMeter::Cost SimMeter::cost() const
+{
+  const SimBusCounters &now = _bus.counters();
+  Cost cost;
+  cost.transactions = now.transactions - _start.transactions;
+  cost.bytesWritten = now.bytesWritten - _start.bytesWritten;
+  cost.bytesRead = now.bytesRead - _start.bytesRead;
+  cost.busUs = (uint32_t)((now.busTimeNs - _start.busTimeNs) / 1000);
+  cost.elapsedUs = (uint32_t)((SimClock::nowNs() - _startNs) / 1000);
+  return cost;
+}
+
+// Print one line of the cost table
+void SimMeter::report(const char *operation, const Cost &cost)
+{
+  printf("[cost] %-34s %5u transactions %6u bytes out %6u bytes in %8u us bus %8u us total\n",
+         operation, (unsigned)cost.transactions, (unsigned)cost.bytesWritten, (unsigned)cost.bytesRead,
+         (unsigned)cost.busUs, (unsigned)cost.elapsedUs);
+}
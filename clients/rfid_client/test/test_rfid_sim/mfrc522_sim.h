@@ -0,0 +1,203 @@
+#pragma once
+// Register-level simulation of an MFRC522 on I2C and of ISO 14443-3 type A cards in its field.
+//
+// Covers what the driver needs to find, select and read cards: the register file, the 64 byte FIFO
+// with its water level alerts, Transceive with StartSend/TxLastBits/RxAlign, the TAuto timer, bit
+// collisions during anticollision (CollReg, ValuesAfterColl), MFAuthent, CalcCRC, SoftReset, soft
+// power-down and the antenna switch. A frame takes its bytes from the FIFO while it is on air and ends
+// when the FIFO runs empty; the answer enters the FIFO byte by byte as it arrives, so frames longer than
+// the FIFO work when the driver keeps up.
+// Cards answer REQA, WUPA, ANTICOLLISION, SELECT and HLTA, and with memory READ, FAST_READ and MFAuthent
+// (Crypto1 itself is not simulated: the traffic stays plain). Cards with an ATS answer RATS, then PPS and
+// ISO 14443-4 blocks. Anything else goes unanswered.
+// RF timing follows ISO 14443-3 at the programmed bit rate, so slow or late cards hit the timer like on hardware.
+#include <Arduino.h>
+#include <Wire.h>
+
+// A frame on the RF interface, LSB first
+struct SimFrame
+{
+  static const uint16_t MAX_BYTES = 258;
+  uint8_t data[MAX_BYTES];
+  uint16_t bits;
+  // Bit rate, 0 (106 kBd) to 3 (848 kBd); a card at another rate hears noise
+  uint8_t rate;
+  // Sent with MFCrypto1On
+  bool crypto;
+
+  // Bit n of the frame
+  bool bit(uint16_t n) const { return (data[n / 8] >> (n % 8)) & 1; }
+};
+
+// ISO 14443-3 type A card (PICC)
+class SimPicc
+{
+public:
+  enum State : uint8_t
+  {
+    Idle,
+    Ready,
+    Active,
+    Halt
+  };
+
+  // uidSize 4, 7 or 10; the ATQA follows from the UID size unless given
+  SimPicc(const uint8_t *uid, uint8_t uidSize, uint8_t sak, uint16_t atqa = 0);
+
+  // Extra delay before every answer, on top of the ISO frame delay time (a slow card)
+  uint32_t replyDelayUs;
+
+  // Memory returned by READ and FAST_READ, nullptr (the default) for none. With SAK 0x00 it is
+  // Ultralight/NTAG pages of 4 bytes, otherwise MIFARE Classic blocks of 16 bytes behind keyA.
+  const uint8_t *memory;
+  uint16_t memorySize;
+  // NTAG21x: FAST_READ is answered. False (the default) makes an Ultralight, which answers it with NAK.
+  bool fastRead;
+  // MIFARE Classic key A of every sector, FFFFFFFFFFFFh by default
+  uint8_t keyA[6];
+  // ATS sent in answer to RATS (TL first, without CRC_A); nullptr (the default): no ISO 14443-4.
+  // After RATS the card takes PPS up to the rates in TA(1) and answers every I-block with the same INF.
+  const uint8_t *ats;
+
+  // Answer a frame from the reader; returns false if the card stays silent
+  bool receive(const SimFrame &in, SimFrame &out);
+
+  // MFAuthent of the reader for the sector of block; false (and the card drops out) on a wrong key or UID
+  bool authenticate(uint8_t keyType, uint8_t block, const uint8_t *key, const uint8_t *uid);
+
+  // The field went off: back to Idle
+  void powerOff();
+
+  State state() const;
+
+  // Bit rate agreed with PPS, 0 (106 kBd) to 3 (848 kBd)
+  uint8_t bitRate() const;
+
+private:
+  uint8_t _uid[10];
+  uint8_t _uidSize;
+  uint8_t _sak;
+  uint16_t _atqa;
+  State _state;
+  // Cascade level being selected, 1..3
+  uint8_t _level;
+  // Woken from Halt by WUPA: a bad command sends it back to Halt instead of Idle
+  bool _fromHalt;
+  // Sector MFAuthent opened, NO_SECTOR if none
+  uint8_t _authSector;
+  // ISO 14443-4 active after RATS; PPS is only taken as the first block
+  bool _protocol;
+  bool _ppsAllowed;
+  uint8_t _rate;
+
+  static const uint8_t NO_SECTOR = 0xFF;
+
+  // UID CLn + BCC for the current cascade level
+  void cascadeBytes(uint8_t out[5]) const;
+  bool receiveActive(const SimFrame &in, SimFrame &out);
+  bool receiveBlock(const uint8_t *data, uint16_t length, SimFrame &out);
+  bool read(uint8_t address, SimFrame &out);
+  bool fastReadPages(uint8_t startPage, uint8_t endPage, SimFrame &out);
+  bool pageBased() const;
+  bool nak(SimFrame &out);
+  void reject();
+};
+
+// MFRC522 on the simulated I2C bus
+class SimMfrc522 : public SimI2cDevice
+{
+public:
+  static const uint8_t MAX_PICCS = 8;
+  static const uint8_t VERSION = 0x92;
+
+  SimMfrc522();
+
+  // Cards in the field
+  void addPicc(SimPicc *picc);
+  void removePicc(SimPicc *picc);
+
+  // Time the RF field has been on
+  uint64_t fieldOnNs();
+
+  // Commands executed and frames sent to the cards
+  uint32_t framesSent() const;
+
+  void i2cWrite(const uint8_t *data, uint8_t length) override;
+  void i2cRead(uint8_t *data, uint8_t length) override;
+
+private:
+  uint8_t _regs[64];
+  uint8_t _pointer;
+  uint8_t _fifo[64];
+  uint8_t _fifoLength;
+  SimPicc *_piccs[MAX_PICCS];
+  uint8_t _piccCount;
+
+  // Frame on air: bytes leave the FIFO one byte time apart from _txStartNs, _txLength so far
+  bool _txActive;
+  uint64_t _txStartNs;
+  SimFrame _txFrame;
+  uint16_t _txLength;
+
+  // Transceive in progress: answer and timer events, 0 if none pending
+  uint64_t _rxDoneNs;
+  uint64_t _timerDoneNs;
+  SimFrame _response;
+  bool _responseCollision;
+  uint16_t _collisionBit;
+  // Answer bytes already in the FIFO; only whole byte answers without collision arrive byte by byte
+  bool _rxProgressive;
+  uint64_t _rxStartNs;
+  uint16_t _rxDelivered;
+  // MFAuthent succeeds at this time, 0 if none pending
+  uint64_t _authDoneNs;
+  // Soft reset or wake-up from power-down completes at this time
+  uint64_t _readyNs;
+
+  bool _fieldOn;
+  uint64_t _fieldOnSinceNs;
+  uint64_t _fieldOnTotalNs;
+  uint32_t _framesSent;
+
+  void softReset();
+  void writeRegister(uint8_t reg, uint8_t value);
+  uint8_t readRegister(uint8_t reg);
+  void setCommand(uint8_t value);
+  void startSend();
+  void transmit(uint64_t now);
+  void finishTransmit();
+  void mfAuthent();
+  void calcCrc();
+  void receiveBytes(uint64_t now);
+  void receiveResponse();
+  void update();
+  void updateField();
+  uint64_t bitNs(uint8_t modeReg) const;
+  uint64_t timerNs() const;
+};
+
+// Cost of an operation: I2C traffic and virtual time from construction to cost()
+class SimMeter
+{
+public:
+  struct Cost
+  {
+    uint32_t transactions;
+    uint32_t bytesWritten;
+    uint32_t bytesRead;
+    uint32_t busUs;
+    uint32_t elapsedUs;
+  };
+
+  explicit SimMeter(const TwoWire &bus);
+
+  Cost cost() const;
+
+  // Print one line of the cost table
+  static void report(const char *operation, const Cost &cost);
+
+private:
+  const TwoWire &_bus;
+  SimBusCounters _start;
+  uint64_t _startNs;
+};
@@ -0,0 +1,1001 @@
+// Runs RfidReader and the MFRC522_I2C driver against the simulated reader and cards on the host:
+//   pio test -e native, and pio test -e native_read for the card memory reads (MFRC522_FEATURE_READ=1)
+// Every test prints a "[cost]" line per operation: I2C transactions, bytes and bus time, and the virtual time it took.
+// Compare those lines before and after a driver change. The budgets below fail the run if the polling paths get dearer.
+#include <stdio.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include "mfrc522_sim.h"
+#include "rfid_reader.h"
+#include "uid_cache.h"
+#include "allowlist.h"
+#include "scan_queue.h"
+
+// Transaction budgets of the paths the door reader runs all day
+static const uint32_t EMPTY_READ_UID_MAX_TRANSACTIONS = 48;
+static const uint32_t EMPTY_DETECT_MAX_TRANSACTIONS = 48;
+
+static const uint8_t UID_4[] = {0xDE, 0xAD, 0xBE, 0xEF};
+static const uint8_t UID_4_OTHER[] = {0x12, 0x34, 0x56, 0x78};
+static const uint8_t UID_7[] = {0x04, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+static const uint8_t UID_10[] = {0x04, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+
+// Simulated reader on Wire at the configured address
+static SimMfrc522 *chip;
+
+// A card record from the reader with its UID as text
+struct TestCard
+{
+  CardRead card;
+  char text[RfidReader::UID_TEXT_SIZE];
+
+  void format() { RfidReader::formatUid(card, text, sizeof(text)); }
+  const char *c_str() const { return text; }
+};
+
+void setUp()
+{
+  Wire.reset();
+  Wire.begin();
+  chip = new SimMfrc522();
+  Wire.attach(RFID_I2C_ADDR, chip);
+}
+
+void tearDown()
+{
+  Wire.reset();
+  delete chip;
+  chip = nullptr;
+}
+
+// Bring the reader up and report what begin() cost
+static void beginReader(RfidReader &reader)
+{
+  SimMeter meter(Wire);
+  reader.begin();
+  SimMeter::report("begin()", meter.cost());
+}
+
+// readUid() with its cost reported under name
+static bool readUid(RfidReader &reader, const char *name, TestCard &uid)
+{
+  SimMeter meter(Wire);
+  bool ok = reader.readUid(uid.card);
+  SimMeter::report(name, meter.cost());
+  uid.format();
+  return ok;
+}
+
+// Run startDetect()/poll() to completion
+static RfidReader::DetectResult detect(RfidReader &reader, TestCard &uid)
+{
+  RfidReader::DetectResult result;
+  reader.startDetect();
+  do
+  {
+    result = reader.poll(uid.card);
+  } while (result == RfidReader::DetectResult::Pending);
+  uid.format();
+  return result;
+}
+
+// Run startPresence()/pollPresence() to completion
+static RfidReader::PresenceEvent presenceStep(RfidReader &reader, TestCard &uid)
+{
+  RfidReader::PresenceEvent event;
+  reader.startPresence();
+  do
+  {
+    event = reader.pollPresence(uid.card);
+  } while (event == RfidReader::PresenceEvent::Pending);
+  uid.format();
+  return event;
+}
+
+void test_begin_negotiates_fastest_clock()
+{
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TEST_ASSERT_EQUAL_UINT32(RFID_I2C_MAX_CLOCK, reader.i2cClock());
+  TEST_ASSERT_EQUAL_UINT8(0, reader.i2cVerifyErrors());
+  TEST_ASSERT_EQUAL_UINT32(0, reader.busStats().errors);
+}
+
+void test_read_uid_empty_field()
+{
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  SimMeter meter(Wire);
+  TEST_ASSERT_FALSE(readUid(reader, "readUid() empty field", uid));
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(EMPTY_READ_UID_MAX_TRANSACTIONS, meter.cost().transactions);
+}
+
+void test_read_uid_single_size()
+{
+  SimPicc card(UID_4, sizeof(UID_4), 0x08);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() 4 byte UID", uid));
+  TEST_ASSERT_EQUAL_STRING("DE:AD:BE:EF", uid.c_str());
+  TEST_ASSERT_EQUAL_UINT8(4, uid.card.uidSize);
+  TEST_ASSERT_EQUAL_UINT8(0x08, uid.card.sak);
+  TEST_ASSERT_EQUAL(MFRC522_I2C::PICC_TYPE_MIFARE_1K, uid.card.type);
+  TEST_ASSERT_EQUAL(SimPicc::Active, card.state());
+}
+
+// Two readers on one bus and a third on a second TwoWire (as in examples/dual_i2c_scanner_new): beginBuses()
+// starts each bus once, and every reader finds its card. The simulated buses carry nothing before begin().
+void test_readers_on_two_buses()
+{
+  TwoWire busOne;
+  TwoWire busTwo;
+  SimMfrc522 chipOne;
+  SimMfrc522 chipOneOther;
+  SimMfrc522 chipTwo;
+  busOne.attach(RFID_I2C_ADDR, &chipOne);
+  busOne.attach(0x29, &chipOneOther);
+  busTwo.attach(RFID_I2C_ADDR, &chipTwo);
+  SimPicc cardOne(UID_4, sizeof(UID_4), 0x08);
+  SimPicc cardOneOther(UID_4_OTHER, sizeof(UID_4_OTHER), 0x08);
+  SimPicc cardTwo(UID_7, sizeof(UID_7), 0x00);
+  chipOne.addPicc(&cardOne);
+  chipOneOther.addPicc(&cardOneOther);
+  chipTwo.addPicc(&cardTwo);
+
+  RfidReader readers[] = {
+      RfidReader(RFID_I2C_ADDR, -1, -1, &busOne),
+      RfidReader(0x29, -1, -1, &busOne),
+      RfidReader(RFID_I2C_ADDR, -1, -1, &busTwo),
+  };
+  RfidReader::beginBuses(readers, 3);
+  TEST_ASSERT_EQUAL_UINT8(1, busOne.beginCount());
+  TEST_ASSERT_EQUAL_UINT8(1, busTwo.beginCount());
+
+  const char *expected[] = {"DE:AD:BE:EF", "12:34:56:78", "04:11:22:33:44:55:66"};
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    readers[i].begin();
+    TestCard uid;
+    TEST_ASSERT_TRUE(readers[i].readUid(uid.card));
+    uid.format();
+    TEST_ASSERT_EQUAL_STRING(expected[i], uid.c_str());
+  }
+}
+
+// The formatter stops at the last whole byte that fits and always terminates
+void test_format_uid_truncates()
+{
+  CardRead card;
+  memcpy(card.uid, UID_10, sizeof(UID_10));
+  card.uidSize = sizeof(UID_10);
+  char text[RfidReader::UID_TEXT_SIZE];
+  TEST_ASSERT_EQUAL_UINT8(29, RfidReader::formatUid(card, text, sizeof(text)));
+  TEST_ASSERT_EQUAL_STRING("04:01:02:03:04:05:06:07:08:09", text);
+  TEST_ASSERT_EQUAL_UINT8(8, RfidReader::formatUid(card, text, 10));
+  TEST_ASSERT_EQUAL_STRING("04:01:02", text);
+  TEST_ASSERT_EQUAL_UINT8(0, RfidReader::formatUid(card, text, 2));
+  TEST_ASSERT_EQUAL_STRING("", text);
+}
+
+void test_read_uid_double_size()
+{
+  SimPicc card(UID_7, sizeof(UID_7), 0x00);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() 7 byte UID", uid));
+  TEST_ASSERT_EQUAL_STRING("04:11:22:33:44:55:66", uid.c_str());
+}
+
+void test_read_uid_triple_size()
+{
+  SimPicc card(UID_10, sizeof(UID_10), 0x20);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() 10 byte UID", uid));
+  TEST_ASSERT_EQUAL_STRING("04:01:02:03:04:05:06:07:08:09", uid.c_str());
+}
+
+// Two cards answer anticollision together; each read selects one, halting it lets the other through
+void test_read_uid_collision()
+{
+  SimPicc first(UID_4, sizeof(UID_4), 0x08);
+  SimPicc second(UID_4_OTHER, sizeof(UID_4_OTHER), 0x08);
+  chip->addPicc(&first);
+  chip->addPicc(&second);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+
+  TestCard uidA, uidB;
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() two cards, collision", uidA));
+  reader.halt();
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() second card", uidB));
+  reader.halt();
+  TEST_ASSERT_FALSE(RfidReader::sameUid(uidA.card, uidB.card));
+  TEST_ASSERT_TRUE(strcmp(uidA.c_str(), "DE:AD:BE:EF") == 0 || strcmp(uidB.c_str(), "DE:AD:BE:EF") == 0);
+  TEST_ASSERT_TRUE(strcmp(uidA.c_str(), "12:34:56:78") == 0 || strcmp(uidB.c_str(), "12:34:56:78") == 0);
+  TEST_ASSERT_EQUAL(SimPicc::Halt, first.state());
+  TEST_ASSERT_EQUAL(SimPicc::Halt, second.state());
+}
+
+void test_inventory_two_cards()
+{
+  SimPicc first(UID_4, sizeof(UID_4), 0x08);
+  SimPicc second(UID_7, sizeof(UID_7), 0x00);
+  chip->addPicc(&first);
+  chip->addPicc(&second);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+
+  MFRC522_I2C::Uid uids[4];
+  SimMeter meter(Wire);
+  uint8_t count = reader.inventory(uids, 4, 100);
+  SimMeter::report("inventory() two cards", meter.cost());
+  TEST_ASSERT_EQUAL_UINT8(2, count);
+  TEST_ASSERT_EQUAL(SimPicc::Halt, first.state());
+  TEST_ASSERT_EQUAL(SimPicc::Halt, second.state());
+}
+
+// A card answering late still reads while its answer starts before the request timer runs out
+void test_slow_card()
+{
+  SimPicc card(UID_4, sizeof(UID_4), 0x08);
+  card.replyDelayUs = 500;
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() card +500 us", uid));
+  reader.halt();
+
+  card.powerOff();
+  card.replyDelayUs = 3000;
+  TEST_ASSERT_FALSE(readUid(reader, "readUid() card +3 ms, default timing", uid));
+
+  MFRC522_I2C::PCD_TimingProfile slow = MFRC522_I2C::DefaultTimingProfile;
+  slow.request.timeoutUs = 5000;
+  slow.select.timeoutUs = 5000;
+  reader.setTimingProfile(slow);
+  card.powerOff();
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() card +3 ms, slow timing", uid));
+  TEST_ASSERT_EQUAL_STRING("DE:AD:BE:EF", uid.c_str());
+}
+
+void test_detect_empty_field()
+{
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  SimMeter meter(Wire);
+  TEST_ASSERT_EQUAL(RfidReader::DetectResult::NoCard, detect(reader, uid));
+  SimMeter::Cost cost = meter.cost();
+  SimMeter::report("startDetect()/poll() empty field", cost);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(EMPTY_DETECT_MAX_TRANSACTIONS, cost.transactions);
+}
+
+void test_detect_card()
+{
+  SimPicc card(UID_7, sizeof(UID_7), 0x00);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+  SimMeter meter(Wire);
+  TEST_ASSERT_EQUAL(RfidReader::DetectResult::CardReady, detect(reader, uid));
+  SimMeter::report("startDetect()/poll() 7 byte UID", meter.cost());
+  TEST_ASSERT_EQUAL_STRING("04:11:22:33:44:55:66", uid.c_str());
+}
+
+// Arrived once, nothing while the card stays, Removed after RFID_PRESENCE_MISSES missed checks
+void test_presence_tracking()
+{
+  SimPicc card(UID_4, sizeof(UID_4), 0x08);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TestCard uid;
+
+  SimMeter arrive(Wire);
+  TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::Arrived, presenceStep(reader, uid));
+  SimMeter::report("presence: arrival + halt", arrive.cost());
+  TEST_ASSERT_EQUAL_STRING("DE:AD:BE:EF", uid.c_str());
+
+  SimMeter check(Wire);
+  TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::None, presenceStep(reader, uid));
+  SimMeter::report("presence: card still there", check.cost());
+  TEST_ASSERT_TRUE(reader.tracking());
+
+  chip->removePicc(&card);
+  for (uint8_t i = 1; i < RFID_PRESENCE_MISSES; i++)
+    TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::None, presenceStep(reader, uid));
+  TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::Removed, presenceStep(reader, uid));
+  TEST_ASSERT_EQUAL_STRING("DE:AD:BE:EF", uid.c_str());
+  TEST_ASSERT_FALSE(reader.tracking());
+}
+
+// ATS of an ISO 14443-4 card: TA(1) offers 212 and 424 kBd both ways, FSC 256 bytes
+static const uint8_t ATS_424[] = {0x05, 0x78, 0x33, 0x80, 0x02};
+
+// The driver on its own at 400 kHz, for what RfidReader does not wrap
+static void beginDriver(MFRC522_I2C &mfrc)
+{
+  mfrc.PCD_SetBusClock(400000);
+  mfrc.PCD_Init();
+}
+
+// Select the card in the field and send RATS
+static void activateIso14443_4(MFRC522_I2C &mfrc)
+{
+  TEST_ASSERT_TRUE(mfrc.PICC_IsNewCardPresent());
+  TEST_ASSERT_TRUE(mfrc.PICC_ReadCardSerial());
+  byte ats[MFRC522_I2C::FIFO_SIZE];
+  byte atsLength = sizeof(ats);
+  TEST_ASSERT_EQUAL(MFRC522_I2C::STATUS_OK, mfrc.PICC_RequestATS(ats, &atsLength));
+}
+
+// Frame for PCD_TransceiveStream() and what came back
+struct StreamBuffer
+{
+  const uint8_t *frame;
+  uint16_t frameLength;
+  uint16_t sent;
+  uint8_t received[SimFrame::MAX_BYTES];
+  uint16_t receivedLength;
+};
+
+// Hands out the frame in the pieces the driver asks for
+static byte streamSource(void *context, byte *buffer, byte maxLength)
+{
+  StreamBuffer *stream = static_cast<StreamBuffer *>(context);
+  uint16_t count = stream->frameLength - stream->sent;
+  if (count > maxLength)
+    count = maxLength;
+  memcpy(buffer, &stream->frame[stream->sent], count);
+  stream->sent += count;
+  return (byte)count;
+}
+
+static void streamSink(void *context, const byte *data, byte length)
+{
+  StreamBuffer *stream = static_cast<StreamBuffer *>(context);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(sizeof(stream->received), stream->receivedLength + length);
+  memcpy(&stream->received[stream->receivedLength], data, length);
+  stream->receivedLength += length;
+}
+
+// Stream an I-block of length bytes to the selected loopback card and check that it comes back unchanged
+static void assertLoopback(MFRC522_I2C &mfrc, const char *name, uint16_t length)
+{
+  uint8_t frame[SimFrame::MAX_BYTES - 2];
+  frame[0] = 0x02; // I-block, block number 0
+  for (uint16_t i = 1; i < length; i++)
+    frame[i] = (uint8_t)(i * 7);
+  StreamBuffer stream = {frame, length, 0, {0}, 0};
+  const uint32_t framesBefore = chip->framesSent();
+  SimMeter meter(Wire);
+  uint16_t receivedLength = 0;
+  TEST_ASSERT_EQUAL(MFRC522_I2C::STATUS_OK, mfrc.PCD_TransceiveStream(streamSource, streamSink, &stream, &receivedLength));
+  SimMeter::report(name, meter.cost());
+
+  TEST_ASSERT_EQUAL_UINT32(framesBefore + 1, chip->framesSent());
+  TEST_ASSERT_EQUAL_UINT16(length + 2, receivedLength); // The sink also gets the CRC_A
+  TEST_ASSERT_EQUAL_UINT16(receivedLength, stream.receivedLength);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, stream.received, length);
+}
+
+// Loop an I-block of length bytes through a fresh ISO 14443-4 card
+static void streamLoopback(const char *name, uint16_t length)
+{
+  SimPicc card(UID_7, sizeof(UID_7), 0x20);
+  card.ats = ATS_424;
+  chip->addPicc(&card);
+  MFRC522_I2C mfrc(RFID_I2C_ADDR, MFRC522_I2C::PIN_NONE);
+  beginDriver(mfrc);
+  activateIso14443_4(mfrc);
+  assertLoopback(mfrc, name, length);
+  chip->removePicc(&card);
+}
+
+// The whole frame fits in the FIFO before StartSend and fills it past the water level: the outgoing
+// bytes raise HiAlert, and must not be read back as the answer
+void test_stream_prefilled_frame()
+{
+  streamLoopback("PCD_TransceiveStream() 60 bytes", 60);
+}
+
+// Longer than the FIFO both ways: refilled on LoAlert while sending, drained on HiAlert while receiving
+void test_stream_long_frame()
+{
+  streamLoopback("PCD_TransceiveStream() 150 bytes", 150);
+}
+
+// Straight after PICC_HaltA() the 1 ms halt timeout is set; the stream must not inherit it, or a card that takes
+// a few ms to answer times out. A card in the ISO 14443-4 protocol ignores HLTA, so it is still there to answer.
+void test_stream_after_halt()
+{
+  SimPicc card(UID_7, sizeof(UID_7), 0x20);
+  card.ats = ATS_424;
+  chip->addPicc(&card);
+  MFRC522_I2C mfrc(RFID_I2C_ADDR, MFRC522_I2C::PIN_NONE);
+  beginDriver(mfrc);
+  activateIso14443_4(mfrc);
+  card.replyDelayUs = 5000;
+  mfrc.PICC_HaltA();
+  assertLoopback(mfrc, "PCD_TransceiveStream() 150 bytes after halt", 150);
+  chip->removePicc(&card);
+}
+
+// RATS, then PPS to the fastest rate in TA(1): I-blocks keep flowing at 424 kBd both ways. The answer
+// stays within the FIFO; at 424 kBd a longer one arrives faster than 400 kHz I2C can drain it.
+void test_negotiate_bit_rate()
+{
+  SimPicc card(UID_7, sizeof(UID_7), 0x20);
+  card.ats = ATS_424;
+  chip->addPicc(&card);
+  MFRC522_I2C mfrc(RFID_I2C_ADDR, MFRC522_I2C::PIN_NONE);
+  beginDriver(mfrc);
+  TEST_ASSERT_TRUE(mfrc.PICC_IsNewCardPresent());
+  TEST_ASSERT_TRUE(mfrc.PICC_ReadCardSerial());
+  SimMeter meter(Wire);
+  TEST_ASSERT_EQUAL(MFRC522_I2C::STATUS_OK, mfrc.PICC_NegotiateBitRate(MFRC522_I2C::BITRATE_848));
+  SimMeter::report("PICC_NegotiateBitRate() to 424 kBd", meter.cost());
+  TEST_ASSERT_EQUAL_UINT8(MFRC522_I2C::BITRATE_424, mfrc.PCD_GetBitRate());
+  TEST_ASSERT_EQUAL_UINT8(MFRC522_I2C::BITRATE_424, card.bitRate());
+  assertLoopback(mfrc, "PCD_TransceiveStream() 40 bytes at 424 kBd", 40);
+  chip->removePicc(&card);
+}
+
+#if MFRC522_FEATURE_READ
+// Recognisable card memory: byte i holds i * 3 + 1
+static void fillMemory(uint8_t *memory, uint16_t size)
+{
+  for (uint16_t i = 0; i < size; i++)
+    memory[i] = (uint8_t)(i * 3 + 1);
+}
+
+// poll() a card into the selected state for the read calls
+static void selectCard(RfidReader &reader)
+{
+  beginReader(reader);
+  TestCard uid;
+  TEST_ASSERT_EQUAL(RfidReader::DetectResult::CardReady, detect(reader, uid));
+}
+
+// NTAG216 sized memory (45 pages): 10 pages fit in one FAST_READ, 40 pages take one streamed FAST_READ
+void test_read_pages_ntag()
+{
+  static uint8_t memory[180];
+  fillMemory(memory, sizeof(memory));
+  SimPicc card(UID_7, sizeof(UID_7), 0x00);
+  card.memory = memory;
+  card.memorySize = sizeof(memory);
+  card.fastRead = true;
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  selectCard(reader);
+
+  uint8_t buffer[160];
+  uint32_t framesBefore = chip->framesSent();
+  SimMeter meter(Wire);
+  TEST_ASSERT_TRUE(reader.readPages(4, 10, buffer, sizeof(buffer)));
+  SimMeter::report("readPages() 10 pages FAST_READ", meter.cost());
+  TEST_ASSERT_EQUAL_UINT32(framesBefore + 1, chip->framesSent());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&memory[16], buffer, 40);
+
+  framesBefore = chip->framesSent();
+  SimMeter streamMeter(Wire);
+  TEST_ASSERT_TRUE(reader.readPages(0, 40, buffer, sizeof(buffer)));
+  SimMeter::report("readPages() 40 pages streamed FAST_READ", streamMeter.cost());
+  TEST_ASSERT_EQUAL_UINT32(framesBefore + 1, chip->framesSent());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(memory, buffer, 160);
+  TEST_ASSERT_EQUAL(SimPicc::Active, card.state());
+}
+
+// An Ultralight answers FAST_READ with NAK: the reader wakes it again and falls back to READ,
+// both for a range that fits one FAST_READ and for one that would be streamed
+void test_read_pages_ultralight_nak()
+{
+  static uint8_t memory[64];
+  fillMemory(memory, sizeof(memory));
+  SimPicc card(UID_7, sizeof(UID_7), 0x00);
+  card.memory = memory;
+  card.memorySize = sizeof(memory);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  selectCard(reader);
+
+  uint8_t buffer[64];
+  SimMeter meter(Wire);
+  TEST_ASSERT_TRUE(reader.readPages(4, 8, buffer, sizeof(buffer)));
+  SimMeter::report("readPages() 8 pages after NAK", meter.cost());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&memory[16], buffer, 32);
+
+  SimMeter streamMeter(Wire);
+  TEST_ASSERT_TRUE(reader.readPages(0, 16, buffer, sizeof(buffer)));
+  SimMeter::report("readPages() 16 pages after streamed NAK", streamMeter.cost());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(memory, buffer, 64);
+  TEST_ASSERT_EQUAL(SimPicc::Active, card.state());
+}
+
+// MIFARE Classic 1K: blocks 4-11 span sectors 1 and 2, one authentication each
+void test_read_blocks_classic()
+{
+  static uint8_t memory[1024];
+  fillMemory(memory, sizeof(memory));
+  SimPicc card(UID_4, sizeof(UID_4), 0x08);
+  card.memory = memory;
+  card.memorySize = sizeof(memory);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  selectCard(reader);
+
+  MFRC522_I2C::MIFARE_Key key;
+  memset(key.keyByte, 0xFF, sizeof(key.keyByte));
+  uint8_t buffer[128];
+  MFRC522_I2C::MIFARE_ReadTimings timings;
+  SimMeter meter(Wire);
+  TEST_ASSERT_TRUE(reader.readBlocks(4, 8, buffer, sizeof(buffer), key, &timings));
+  SimMeter::report("readBlocks() 8 blocks, 2 sectors", meter.cost());
+  TEST_ASSERT_EQUAL_UINT8(2, timings.authCount);
+  TEST_ASSERT_EQUAL_UINT8(8, timings.blocksRead);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&memory[64], buffer, 128);
+
+  // Sector 2 is still open: no new authentication
+  TEST_ASSERT_TRUE(reader.readSector(2, buffer, sizeof(buffer), key, &timings));
+  TEST_ASSERT_EQUAL_UINT8(0, timings.authCount);
+  TEST_ASSERT_EQUAL_UINT8(3, timings.blocksRead);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&memory[128], buffer, 48);
+}
+
+// A wrong key fails the authentication and reads nothing
+void test_read_blocks_wrong_key()
+{
+  static uint8_t memory[1024];
+  fillMemory(memory, sizeof(memory));
+  SimPicc card(UID_4, sizeof(UID_4), 0x08);
+  card.memory = memory;
+  card.memorySize = sizeof(memory);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  selectCard(reader);
+
+  MFRC522_I2C::MIFARE_Key key;
+  memset(key.keyByte, 0xA0, sizeof(key.keyByte));
+  uint8_t buffer[48];
+  MFRC522_I2C::MIFARE_ReadTimings timings;
+  TEST_ASSERT_FALSE(reader.readSector(1, buffer, sizeof(buffer), key, &timings));
+  TEST_ASSERT_EQUAL_UINT8(1, timings.authCount);
+  TEST_ASSERT_EQUAL_UINT8(0, timings.blocksRead);
+}
+#endif
+
+// Card record with a 4 byte UID ending in `last`, read at timeMs
+static CardRead cardAt(uint8_t last, uint32_t timeMs)
+{
+  CardRead card;
+  memset(&card, 0, sizeof(card));
+  memcpy(card.uid, UID_4, sizeof(UID_4));
+  card.uid[3] = last;
+  card.uidSize = sizeof(UID_4);
+  card.timestampMs = timeMs;
+  return card;
+}
+
+// Two cards taking turns within the window are each published once
+void test_uid_cache_alternating()
+{
+  UidCache cache;
+  for (uint32_t t = 0; t < 1000; t += 100)
+  {
+    TEST_ASSERT_EQUAL(t > 0, cache.isDuplicate(cardAt(1, t), 1500));
+    TEST_ASSERT_EQUAL(t > 0, cache.isDuplicate(cardAt(2, t + 50), 1500));
+  }
+  TEST_ASSERT_EQUAL_UINT32(2, cache.misses());
+  TEST_ASSERT_EQUAL_UINT32(18, cache.hits());
+}
+
+// The window runs from the publish, not from the last read
+void test_uid_cache_window()
+{
+  UidCache cache;
+  TEST_ASSERT_FALSE(cache.isDuplicate(cardAt(1, 0), 1500));
+  TEST_ASSERT_TRUE(cache.isDuplicate(cardAt(1, 1000), 1500));
+  TEST_ASSERT_TRUE(cache.isDuplicate(cardAt(1, 1499), 1500));
+  TEST_ASSERT_FALSE(cache.isDuplicate(cardAt(1, 1500), 1500));
+  TEST_ASSERT_TRUE(cache.isDuplicate(cardAt(1, 2000), 1500));
+}
+
+// A full cache evicts the card seen longest ago
+void test_uid_cache_lru()
+{
+  UidCache cache;
+  for (uint8_t i = 0; i < DEDUPE_CACHE_SIZE; i++)
+    TEST_ASSERT_FALSE(cache.isDuplicate(cardAt(i, i), 60000));
+  TEST_ASSERT_TRUE(cache.isDuplicate(cardAt(0, 100), 60000)); // Card 0 is now the most recent, card 1 the oldest
+  TEST_ASSERT_FALSE(cache.isDuplicate(cardAt(0xEE, 200), 60000));
+  TEST_ASSERT_TRUE(cache.isDuplicate(cardAt(0, 300), 60000));
+  TEST_ASSERT_FALSE(cache.isDuplicate(cardAt(1, 400), 60000));
+}
+
+// Keycard filter payload of `bytes` bytes with k hash functions and the given bits set
+static uint16_t allowlistPayload(uint8_t *payload, uint8_t bytes, uint8_t k, const uint16_t *bits, uint8_t count)
+{
+  memset(payload, 0, Allowlist::HEADER_SIZE + bytes);
+  payload[0] = Allowlist::FORMAT;
+  payload[1] = k;
+  for (uint8_t i = 0; i < count; i++)
+    payload[Allowlist::HEADER_SIZE + bits[i] / 8] |= 1 << (bits[i] % 8);
+  return Allowlist::HEADER_SIZE + bytes;
+}
+
+// The backend sets bits 114, 93, 72 and 51 of 512 for E3:89:6E:AF with k = 4 (backend/src/tests/bloom.test.ts)
+void test_allowlist_positions()
+{
+  static const uint16_t BITS[] = {114, 93, 72, 51};
+  uint8_t payload[Allowlist::HEADER_SIZE + 64];
+  Allowlist allowlist;
+  TEST_ASSERT_TRUE(allowlist.mightContain("E3:89:6E:AF")); // No filter yet: nothing is rejected
+
+  TEST_ASSERT_TRUE(allowlist.load(payload, allowlistPayload(payload, 64, 4, BITS, 4)));
+  TEST_ASSERT_EQUAL(512, allowlist.bits());
+  TEST_ASSERT_TRUE(allowlist.mightContain("E3:89:6E:AF"));
+  TEST_ASSERT_FALSE(allowlist.mightContain("FE:79:D8:03"));
+  for (uint8_t missing = 0; missing < 4; missing++)
+  {
+    uint16_t others[3];
+    for (uint8_t i = 0, n = 0; i < 4; i++)
+      if (i != missing)
+        others[n++] = BITS[i];
+    TEST_ASSERT_TRUE(allowlist.load(payload, allowlistPayload(payload, 64, 4, others, 3)));
+    TEST_ASSERT_FALSE(allowlist.mightContain("E3:89:6E:AF"));
+  }
+
+  // A cleared retained topic removes the filter
+  TEST_ASSERT_TRUE(allowlist.load(payload, 0));
+  TEST_ASSERT_FALSE(allowlist.active());
+  TEST_ASSERT_TRUE(allowlist.mightContain("FE:79:D8:03"));
+}
+
+// Malformed or oversized payloads leave the current filter in place
+void test_allowlist_malformed()
+{
+  static const uint16_t BITS[] = {114, 93, 72, 51};
+  uint8_t payload[Allowlist::HEADER_SIZE + ALLOWLIST_MAX_BYTES + 1];
+  Allowlist allowlist;
+  TEST_ASSERT_TRUE(allowlist.load(payload, allowlistPayload(payload, 64, 4, BITS, 4)));
+
+  uint8_t bad[Allowlist::HEADER_SIZE + 8];
+  allowlistPayload(bad, 8, 4, BITS, 0);
+  bad[0] = Allowlist::FORMAT + 1;
+  TEST_ASSERT_FALSE(allowlist.load(bad, sizeof(bad)));
+  allowlistPayload(bad, 8, 0, BITS, 0);
+  TEST_ASSERT_FALSE(allowlist.load(bad, sizeof(bad)));
+  TEST_ASSERT_FALSE(allowlist.load(bad, Allowlist::HEADER_SIZE));
+  TEST_ASSERT_FALSE(allowlist.load(payload, allowlistPayload(payload, ALLOWLIST_MAX_BYTES + 1, 4, BITS, 0)));
+
+  TEST_ASSERT_EQUAL(512, allowlist.bits());
+  TEST_ASSERT_TRUE(allowlist.mightContain("E3:89:6E:AF"));
+  TEST_ASSERT_FALSE(allowlist.mightContain("FE:79:D8:03"));
+}
+
+// The EEPROM copy survives a restart; the same filter again costs no writes, a corrupt copy is dropped
+void test_allowlist_eeprom()
+{
+  static const uint16_t BITS[] = {114, 93, 72, 51};
+  uint8_t payload[Allowlist::HEADER_SIZE + 64];
+  EEPROM.erase();
+  Allowlist restored;
+  TEST_ASSERT_FALSE(restored.restore(ALLOWLIST_EEPROM_ADDR)); // Blank EEPROM
+
+  Allowlist allowlist;
+  allowlist.load(payload, allowlistPayload(payload, 64, 4, BITS, 4));
+  allowlist.save(ALLOWLIST_EEPROM_ADDR);
+  const uint32_t writes = EEPROM.writes();
+  allowlist.save(ALLOWLIST_EEPROM_ADDR);
+  TEST_ASSERT_EQUAL(writes, EEPROM.writes());
+
+  TEST_ASSERT_TRUE(restored.restore(ALLOWLIST_EEPROM_ADDR));
+  TEST_ASSERT_EQUAL(512, restored.bits());
+  TEST_ASSERT_TRUE(restored.mightContain("E3:89:6E:AF"));
+  TEST_ASSERT_FALSE(restored.mightContain("FE:79:D8:03"));
+
+  EEPROM.write(ALLOWLIST_EEPROM_ADDR + 4 + 114 / 8, 0);
+  TEST_ASSERT_FALSE(restored.restore(ALLOWLIST_EEPROM_ADDR));
+  TEST_ASSERT_FALSE(restored.active());
+}
+
+// In order, sequence numbers increasing; a full ring drops the oldest
+void test_scan_queue_order()
+{
+  ScanQueue queue;
+  queue.begin(-1, false);
+  for (uint8_t i = 0; i < SCAN_QUEUE_SIZE + 2; i++)
+    queue.push(cardAt(i, i), 0, 0);
+  TEST_ASSERT_EQUAL(SCAN_QUEUE_SIZE, queue.size());
+  TEST_ASSERT_EQUAL(2, queue.dropped());
+  for (uint8_t i = 2; i < SCAN_QUEUE_SIZE + 2; i++)
+  {
+    TEST_ASSERT_NOT_NULL(queue.front());
+    TEST_ASSERT_EQUAL_HEX8(i, queue.front()->card.uid[3]);
+    TEST_ASSERT_EQUAL(i, queue.front()->sequence);
+    queue.pop();
+  }
+  TEST_ASSERT_NULL(queue.front());
+}
+
+// Scans published while online never reach the EEPROM
+void test_scan_queue_online()
+{
+  EEPROM.erase();
+  ScanQueue queue;
+  queue.begin(SCAN_QUEUE_EEPROM_ADDR, true);
+  const uint32_t writes = EEPROM.writes();
+  for (uint16_t i = 0; i < 100; i++)
+  {
+    queue.push(cardAt(i, i), 0, 0);
+    queue.pop();
+  }
+  TEST_ASSERT_EQUAL(writes, EEPROM.writes());
+}
+
+// Unsent scans survive a restart in order, with sequence numbers above the earlier run's
+void test_scan_queue_restart()
+{
+  EEPROM.erase();
+  {
+    ScanQueue queue;
+    queue.begin(SCAN_QUEUE_EEPROM_ADDR, true);
+    for (uint8_t i = 0; i < 4; i++)
+      queue.push(cardAt(i, 1000 + i), i & 1, i == 2 ? ScanQueue::FLAG_REJECTED : 0);
+    queue.persist();
+    queue.pop(); // Sent before the restart
+  }
+
+  ScanQueue queue;
+  queue.begin(SCAN_QUEUE_EEPROM_ADDR, true);
+  TEST_ASSERT_EQUAL(3, queue.size());
+  for (uint8_t i = 1; i < 4; i++)
+  {
+    const ScanEvent *event = queue.front();
+    TEST_ASSERT_EQUAL_HEX8(i, event->card.uid[3]);
+    TEST_ASSERT_EQUAL(4, event->card.uidSize);
+    TEST_ASSERT_EQUAL(i, event->sequence);
+    TEST_ASSERT_EQUAL(i & 1, event->reader);
+    TEST_ASSERT_EQUAL((i == 2 ? ScanQueue::FLAG_REJECTED : 0) | ScanQueue::FLAG_RESTORED, event->flags);
+    queue.pop();
+  }
+  queue.push(cardAt(9, 2000), 0, 0);
+  TEST_ASSERT_EQUAL(1UL << 16, queue.front()->sequence); // Boot 1, first scan
+}
+
+// A scan from before a restart is late however soon after boot it is sent; a scan of this run
+// has its real age
+void test_scan_queue_restored_age()
+{
+  EEPROM.erase();
+  {
+    ScanQueue queue;
+    queue.begin(SCAN_QUEUE_EEPROM_ADDR, true);
+    queue.push(cardAt(1, 5000), 0, 0);
+    queue.persist();
+  }
+
+  ScanQueue queue;
+  queue.begin(SCAN_QUEUE_EEPROM_ADDR, true);
+  queue.push(cardAt(2, 300), 0, 0);
+  TEST_ASSERT_EQUAL(2, queue.size());
+  TEST_ASSERT_EQUAL(ScanQueue::AGE_UNKNOWN, ScanQueue::ageMs(*queue.front(), 1000)); // 1 s after boot
+  queue.pop();
+  TEST_ASSERT_EQUAL(700, ScanQueue::ageMs(*queue.front(), 1000));
+}
+
+// Offline scans rotate through every slot instead of wearing out one
+void test_scan_queue_wear()
+{
+  EEPROM.erase();
+  ScanQueue queue;
+  queue.begin(SCAN_QUEUE_EEPROM_ADDR, true);
+  for (uint8_t i = 0; i < 3 * SCAN_QUEUE_SIZE; i++)
+  {
+    queue.push(cardAt(i, i), 0, 0);
+    if (i % 3 == 0)
+      queue.push(cardAt(0x80 | i, i), 0, 0);
+    queue.persist();
+    queue.pop();
+  }
+  uint32_t used = 0;
+  for (uint8_t slot = 0; slot < SCAN_QUEUE_SIZE; slot++)
+  {
+    if (EEPROM.read(SCAN_QUEUE_EEPROM_ADDR + 2 + slot * ScanQueue::SLOT_SIZE) != 0xFF)
+      used++;
+  }
+  TEST_ASSERT_EQUAL(SCAN_QUEUE_SIZE, used);
+  printf("[queue] %u offline scans: %u EEPROM writes, %.1f per scan\n", 4 * SCAN_QUEUE_SIZE,
+         (unsigned)EEPROM.writes(), (double)EEPROM.writes() / (4 * SCAN_QUEUE_SIZE));
+}
+
+// One presence step the way main.cpp drives it: wait the reader's pause, then start and poll to completion
+static RfidReader::PresenceEvent dutyStep(RfidReader &reader, TestCard &uid)
+{
+  SimClock::advanceNs((uint64_t)reader.pollIntervalMs() * 1000000);
+  return presenceStep(reader, uid);
+}
+
+// Idle field for idleMs: share of the time the field was on and I2C transactions per second
+static void reportIdle(const char *mode, RfidReader &reader, uint32_t idleMs, double &fieldOnShare)
+{
+  TestCard uid;
+  const uint64_t fieldStart = chip->fieldOnNs();
+  SimMeter meter(Wire);
+  while (meter.cost().elapsedUs < idleMs * 1000)
+    TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::None, dutyStep(reader, uid));
+  SimMeter::Cost cost = meter.cost();
+  fieldOnShare = (double)(chip->fieldOnNs() - fieldStart) / 1000.0 / cost.elapsedUs;
+  printf("[duty] %-26s idle: field on %5.1f %%, %6.0f transactions/s, pause %u ms\n", mode, 100.0 * fieldOnShare,
+         cost.transactions * 1e6 / cost.elapsedUs, (unsigned)reader.pollIntervalMs());
+}
+
+// Without duty cycling the field never goes off
+void test_duty_cycle_off()
+{
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  double share;
+  reportIdle("always on", reader, 2000, share);
+  TEST_ASSERT_FALSE(reader.sleeping());
+  TEST_ASSERT_TRUE(share > 0.99);
+}
+
+// Idle power and worst-case detection latency per latency setting: the card arrives just after a step
+void test_duty_cycle_latency()
+{
+  static const uint16_t LATENCIES_MS[] = {100, 250, 1000};
+  for (uint8_t i = 0; i < sizeof(LATENCIES_MS) / sizeof(LATENCIES_MS[0]); i++)
+  {
+    const uint16_t maxLatencyMs = LATENCIES_MS[i];
+    tearDown();
+    setUp();
+    RfidReader reader(RFID_I2C_ADDR);
+    beginReader(reader);
+    reader.setDutyCycle(RFID_POLL_INTERVAL_MS, maxLatencyMs, 0);
+
+    char mode[32];
+    snprintf(mode, sizeof(mode), "max latency %u ms", (unsigned)maxLatencyMs);
+    double share;
+    reportIdle(mode, reader, 5000, share);
+    TEST_ASSERT_TRUE(reader.sleeping());
+    TEST_ASSERT_TRUE(share < 0.2);
+
+    SimPicc card(UID_7, sizeof(UID_7), 0x00);
+    chip->addPicc(&card);
+    TestCard uid;
+    const uint64_t arrivedNs = SimClock::nowNs();
+    RfidReader::PresenceEvent event;
+    do
+    {
+      event = dutyStep(reader, uid);
+    } while (event == RfidReader::PresenceEvent::None);
+    const uint32_t latencyUs = (uint32_t)((SimClock::nowNs() - arrivedNs) / 1000);
+    printf("[duty] %-26s detection latency %6u us\n", mode, (unsigned)latencyUs);
+    TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::Arrived, event);
+    TEST_ASSERT_EQUAL_STRING("04:11:22:33:44:55:66", uid.c_str());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32((uint32_t)maxLatencyMs * 1000, latencyUs);
+
+    // Back to the short pause with the field on while the card is there
+    TEST_ASSERT_EQUAL_UINT16(RFID_POLL_INTERVAL_MS, reader.pollIntervalMs());
+    TEST_ASSERT_EQUAL(RfidReader::PresenceEvent::None, dutyStep(reader, uid));
+    TEST_ASSERT_FALSE(reader.sleeping());
+    chip->removePicc(&card);
+  }
+}
+
+#if MFRC522_FEATURE_STATS
+// The driver's own counters agree with what the bus saw: a register read is a pointer write plus a read transaction
+static void assertStatsMatchBus(const MFRC522_I2C::PCD_Stats &stats, const SimMeter::Cost &cost)
+{
+  TEST_ASSERT_EQUAL_UINT32(cost.transactions, 2 * stats.regReads + stats.regWrites);
+  TEST_ASSERT_EQUAL_UINT32(cost.bytesRead, stats.bytesRead);
+  TEST_ASSERT_EQUAL_UINT32(cost.bytesWritten, stats.bytesWritten + stats.regWrites + stats.regReads);
+}
+
+void test_stats_empty_field()
+{
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+  TEST_ASSERT_EQUAL_UINT32(0, reader.stats().regReads);
+
+  TestCard uid;
+  SimMeter meter(Wire);
+  TEST_ASSERT_FALSE(readUid(reader, "readUid() empty field, counted", uid));
+  SimMeter::Cost cost = meter.cost();
+  MFRC522_I2C::PCD_Stats stats = reader.stats();
+  assertStatsMatchBus(stats, cost);
+  TEST_ASSERT_EQUAL_UINT16(1, stats.timeouts.request);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.timeouts.select);
+  TEST_ASSERT_TRUE(stats.commPolls > 0);
+  TEST_ASSERT_EQUAL_UINT16(1, stats.isNewCardPresent.calls);
+  TEST_ASSERT_EQUAL_UINT32(stats.isNewCardPresent.totalUs, stats.isNewCardPresent.maxUs);
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(cost.elapsedUs, stats.isNewCardPresent.totalUs);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.select.calls);
+
+  reader.resetStats();
+  TEST_ASSERT_EQUAL_UINT32(0, reader.stats().regReads);
+  TEST_ASSERT_EQUAL_UINT16(0, reader.stats().isNewCardPresent.calls);
+}
+
+// Select and halt are timed; the halt is a timeout on the wire
+void test_stats_read_and_halt()
+{
+  SimPicc card(UID_7, sizeof(UID_7), 0x00);
+  chip->addPicc(&card);
+  RfidReader reader(RFID_I2C_ADDR);
+  beginReader(reader);
+
+  TestCard uid;
+  SimMeter meter(Wire);
+  TEST_ASSERT_TRUE(readUid(reader, "readUid() 7 byte UID, counted", uid));
+  reader.halt();
+  MFRC522_I2C::PCD_Stats stats = reader.stats();
+  assertStatsMatchBus(stats, meter.cost());
+  TEST_ASSERT_EQUAL_UINT16(0, stats.timeouts.request);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.timeouts.select);
+  TEST_ASSERT_EQUAL_UINT16(1, stats.timeouts.halt);
+  TEST_ASSERT_EQUAL_UINT16(1, stats.select.calls);
+  TEST_ASSERT_TRUE(stats.select.totalUs > 0);
+  TEST_ASSERT_EQUAL_UINT16(1, stats.haltA.calls);
+  TEST_ASSERT_TRUE(stats.haltA.totalUs > 0);
+  TEST_ASSERT_EQUAL(SimPicc::Halt, card.state());
+}
+#endif
+
+int main()
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_begin_negotiates_fastest_clock);
+  RUN_TEST(test_read_uid_empty_field);
+  RUN_TEST(test_read_uid_single_size);
+  RUN_TEST(test_readers_on_two_buses);
+  RUN_TEST(test_format_uid_truncates);
+  RUN_TEST(test_read_uid_double_size);
+  RUN_TEST(test_read_uid_triple_size);
+  RUN_TEST(test_read_uid_collision);
+  RUN_TEST(test_inventory_two_cards);
+  RUN_TEST(test_slow_card);
+  RUN_TEST(test_detect_empty_field);
+  RUN_TEST(test_detect_card);
+  RUN_TEST(test_presence_tracking);
+  RUN_TEST(test_stream_prefilled_frame);
+  RUN_TEST(test_stream_long_frame);
+  RUN_TEST(test_stream_after_halt);
+  RUN_TEST(test_negotiate_bit_rate);
+#if MFRC522_FEATURE_READ
+  RUN_TEST(test_read_pages_ntag);
+  RUN_TEST(test_read_pages_ultralight_nak);
+  RUN_TEST(test_read_blocks_classic);
+  RUN_TEST(test_read_blocks_wrong_key);
+#endif
+  RUN_TEST(test_uid_cache_alternating);
+  RUN_TEST(test_uid_cache_window);
+  RUN_TEST(test_uid_cache_lru);
+  RUN_TEST(test_allowlist_positions);
+  RUN_TEST(test_allowlist_malformed);
+  RUN_TEST(test_allowlist_eeprom);
+  RUN_TEST(test_scan_queue_order);
+  RUN_TEST(test_scan_queue_online);
+  RUN_TEST(test_scan_queue_restart);
+  RUN_TEST(test_scan_queue_restored_age);
+  RUN_TEST(test_scan_queue_wear);
+  RUN_TEST(test_duty_cycle_off);
+  RUN_TEST(test_duty_cycle_latency);
+#if MFRC522_FEATURE_STATS
+  RUN_TEST(test_stats_empty_field);
+  RUN_TEST(test_stats_read_and_halt);
+#endif
+  return UNITY_END();
+}